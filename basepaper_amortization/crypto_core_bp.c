@@ -9,18 +9,26 @@
 #define LOG_LEVEL LOG_LEVEL_INFO
 
 /* ========== PRNG STATE ========== */
+/* Default PRNG of the context-free API; a crypto_ctx_t carries its own */
 static uint32_t prng_state = 0x12345678;
 
+/* Xorshift32 step on any state word */
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
 void crypto_prng_init(uint32_t seed) {
     prng_state = seed;
 }
 
 uint32_t crypto_random_uint32(void) {
-    /* Xorshift32 PRNG */
-    prng_state ^= prng_state << 13;
-    prng_state ^= prng_state >> 17;
-    prng_state ^= prng_state << 5;
-    return prng_state;
+    return xorshift32(&prng_state);
 }
 
 void crypto_secure_random(uint8_t *buffer, size_t len) {
@@ -30,6 +38,21 @@ void crypto_secure_random(uint8_t *buffer, size_t len) {
     }
 }
 
+void crypto_ctx_init(crypto_ctx_t *ctx, uint32_t seed) {
+    ctx->drbg = seed ? seed : 0x12345678;
+}
+
+uint32_t crypto_ctx_random_uint32(crypto_ctx_t *ctx) {
+    return xorshift32(&ctx->drbg);
+}
+
+void crypto_ctx_random(crypto_ctx_t *ctx, uint8_t *output, size_t len) {
+    size_t i;
+    for (i = 0; i < len; i++) {
+        output[i] = (uint8_t)(xorshift32(&ctx->drbg) & 0xFF);
+    }
+}
+
 /* ========== MODULAR ARITHMETIC ========== */
 /* Modulus Q = 536870909 (2^29 - 3) */
 
@@ -108,6 +131,31 @@ void poly_mul_ntt(Poly512 *result, const Poly512 *a, const Poly512 *b) {
     poly_mul_schoolbook(result, a, b);
 }
 
+/* a * s walks output coefficients k: terms with i + j = k add, terms
+ * with i + j = n + k wrap past x^n = -1 and subtract */
+void poly_mul_small(Poly512 *result, const Poly512 *a, const PolySmall *s) {
+    int i, k;
+    
+    for (k = 0; k < POLY_DEGREE; k++) {
+        int64_t acc = 0;
+        
+        for (i = 0; i <= k; i++) {
+            acc += (int64_t)a->coeff[i] * s->coeff[k - i];
+        }
+        for (; i < POLY_DEGREE; i++) {
+            acc -= (int64_t)a->coeff[i] * s->coeff[POLY_DEGREE + k - i];
+        }
+        result->coeff[k] = mod_q(acc);
+    }
+}
+
+void poly_add_small(Poly512 *result, const Poly512 *a, const PolySmall *s) {
+    int i;
+    for (i = 0; i < POLY_DEGREE; i++) {
+        result->coeff[i] = mod_q((int64_t)a->coeff[i] + s->coeff[i]);
+    }
+}
+
 void poly_add(Poly512 *result, const Poly512 *a, const Poly512 *b) {
     int i;
     for (i = 0; i < POLY_DEGREE; i++) {
@@ -183,6 +231,111 @@ void deserialize_poly512(Poly512 *p, const uint8_t *in) {
     }
 }
 
+/* Wire layout of AuthMessage, in order */
+#define AUTH_WIRE_SYNDROME 1
+#define AUTH_WIRE_POLYS (AUTH_WIRE_SYNDROME + LDPC_ROWS / 8)
+#define AUTH_WIRE_POLY_BYTES (POLY_DEGREE * 4)
+#define AUTH_WIRE_COMMITMENT (AUTH_WIRE_POLYS + (RING_SIZE + 2) * AUTH_WIRE_POLY_BYTES)
+#define AUTH_WIRE_KEYWORD (AUTH_WIRE_COMMITMENT + SHA256_DIGEST_SIZE)
+
+/* Polynomial k of the wire form: pk, S[0..N-1], w */
+static const Poly512 *auth_wire_poly(const AuthMessage *msg, size_t k) {
+    if (k == 0) return &msg->public_key;
+    if (k <= RING_SIZE) return &msg->signature.S[k - 1];
+    return &msg->signature.w;
+}
+
+void auth_cursor_init(auth_cursor_t *cur, const AuthMessage *msg) {
+    cur->msg = msg;
+    cur->offset = 0;
+}
+
+void auth_cursor_seek(auth_cursor_t *cur, size_t offset) {
+    cur->offset = offset < AUTH_MSG_WIRE_LEN ? offset : AUTH_MSG_WIRE_LEN;
+}
+
+size_t auth_cursor_read(auth_cursor_t *cur, uint8_t *out, size_t len) {
+    const AuthMessage *msg = cur->msg;
+    size_t done = 0;
+    
+    if (len > AUTH_MSG_WIRE_LEN - cur->offset) {
+        len = AUTH_MSG_WIRE_LEN - cur->offset;
+    }
+    
+    while (done < len) {
+        size_t off = cur->offset;
+        size_t n;
+        
+        if (off < AUTH_WIRE_SYNDROME) {
+            out[done] = msg->type;
+            n = 1;
+        } else if (off < AUTH_WIRE_POLYS) {
+            n = AUTH_WIRE_POLYS - off;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, msg->syndrome + (off - AUTH_WIRE_SYNDROME), n);
+        } else if (off < AUTH_WIRE_COMMITMENT) {
+            /* One coefficient (or the rest of it) per step, big-endian */
+            size_t rel = off - AUTH_WIRE_POLYS;
+            const Poly512 *p = auth_wire_poly(msg, rel / AUTH_WIRE_POLY_BYTES);
+            uint32_t val = (uint32_t)p->coeff[(rel % AUTH_WIRE_POLY_BYTES) / 4];
+            size_t b = rel % 4;
+            
+            n = 0;
+            while (b < 4 && done + n < len) {
+                out[done + n++] = (uint8_t)(val >> (24 - 8 * b));
+                b++;
+            }
+        } else if (off < AUTH_WIRE_KEYWORD) {
+            n = AUTH_WIRE_KEYWORD - off;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, msg->signature.commitment + (off - AUTH_WIRE_COMMITMENT), n);
+        } else {
+            n = AUTH_MSG_WIRE_LEN - off;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, msg->signature.keyword + (off - AUTH_WIRE_KEYWORD), n);
+        }
+        
+        done += n;
+        cur->offset += n;
+    }
+    return done;
+}
+
+int auth_msg_view(AuthMessageView *view, const uint8_t *wire, size_t len) {
+    const uint8_t *p = wire;
+    int i;
+    
+    if (len != AUTH_MSG_WIRE_LEN) return -1;
+    
+    view->type = *p++;
+    view->syndrome = p;
+    p += LDPC_ROWS / 8;
+    view->public_key.poly = NULL;
+    view->public_key.wire = p;
+    p += POLY_DEGREE * 4;
+    for (i = 0; i < RING_SIZE; i++) {
+        view->signature.S[i].poly = NULL;
+        view->signature.S[i].wire = p;
+        p += POLY_DEGREE * 4;
+    }
+    view->signature.w.poly = NULL;
+    view->signature.w.wire = p;
+    p += POLY_DEGREE * 4;
+    view->signature.commitment = p;
+    p += SHA256_DIGEST_SIZE;
+    view->signature.keyword = p;
+    return 0;
+}
+
+void poly_view_print(const char *label, const PolyView *v, int num_coeffs) {
+    int i;
+    printf("%s: [", label);
+    for (i = 0; i < num_coeffs && i < 16; i++) {
+        printf("%ld ", (long)poly_view_coeff(v, i));
+    }
+    printf("...]\n");
+}
+
 void sha256_hash(uint8_t output[32], const uint8_t *input, uint32_t len) {
     uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
     uint32_t w[64];
@@ -242,9 +395,77 @@ void sha256_hash(uint8_t output[32], const uint8_t *input, uint32_t len) {
 }
 
 /* ========== HELPERS ========== */
+static int32_t noise_sample(uint32_t *drbg) {
+    return (int32_t)(xorshift32(drbg) % (200)) - 100; // Simplified small noise
+}
+
 int32_t gaussian_sample(int sigma) {
-    int32_t u1 = (int32_t)(crypto_random_uint32() % (200)) - 100; // Simplified small noise
-    return u1;
+    return noise_sample(&prng_state);
+}
+
+/* Shared system parameter 'a' from its fixed seed, on a private PRNG
+ * state (nobody's generator is borrowed and restored) */
+static void expand_public_a(Poly512 *a) {
+    uint32_t state = 0xDEADBEEF;
+    int i;
+    
+    for (i = 0; i < POLY_DEGREE; i++) a->coeff[i] = xorshift32(&state) % MODULUS_Q;
+}
+
+/* ========== SCRATCH ARENA ========== */
+/* POLY_DEGREE=512 scratch is too big for a mote stack. The context-free
+ * calls borrow it from the application's arena and give it back on
+ * return, so the same bytes serve keygen, sign, verify and whatever
+ * the application keeps there between handshakes */
+static struct {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    size_t phase_peak;
+    size_t peak;
+} arena;
+
+void crypto_arena_init(void *mem, size_t size) {
+    arena.base = mem;
+    arena.size = size;
+    arena.used = 0;
+    arena.phase_peak = 0;
+    arena.peak = 0;
+}
+
+void *crypto_arena_alloc(size_t len) {
+    void *p;
+    
+    len = CRYPTO_ARENA_ROUND(len);
+    if (arena.base == NULL || len > arena.size - arena.used) {
+        LOG_ERR("Arena exhausted: need %u B, %u of %u B free\n", (unsigned)len,
+                (unsigned)(arena.size - arena.used), (unsigned)arena.size);
+        return NULL;
+    }
+    p = arena.base + arena.used;
+    arena.used += len;
+    if (arena.used > arena.phase_peak) arena.phase_peak = arena.used;
+    if (arena.used > arena.peak) arena.peak = arena.used;
+    return p;
+}
+
+size_t crypto_arena_mark(void) {
+    return arena.used;
+}
+
+void crypto_arena_release(size_t mark) {
+    if (mark < arena.used) {
+        /* Borrowed scratch held keys and nonces */
+        secure_zero(arena.base + mark, arena.used - mark);
+        arena.used = mark;
+    }
+}
+
+void crypto_arena_report(const char *phase) {
+    LOG_INFO("RAM [%s]: arena peak %u B, in use %u B, size %u B (max %u B)\n",
+             phase, (unsigned)arena.phase_peak, (unsigned)arena.used,
+             (unsigned)arena.size, (unsigned)arena.peak);
+    arena.phase_peak = arena.used;
 }
 
 uint32_t poly_norm(const Poly512 *a) {
@@ -260,50 +481,54 @@ void generate_ring_member_key(Poly512 *public_key, int member_index) {
     int i;
     /* Use deterministic generation based on member index */
     /* This simulates retrieving a public key from a directory/PKI */
-    uint32_t seed = 0x12345678 + (member_index * 0xABCDEF);
-    uint32_t old_state = prng_state;
-    
-    crypto_prng_init(seed);
+    uint32_t state = 0x12345678 + (member_index * 0xABCDEF);
     
     /* Generate random-looking polynomial */
     /* In real LWE, this would be t = a*s + e. */
     /* For FAKE members, we just generate uniform random 't' */
     /* This is indistinguishable from real 't' (LWE assumption) */
     for (i = 0; i < POLY_DEGREE; i++) {
-        public_key->coeff[i] = crypto_random_uint32() % MODULUS_Q;
+        public_key->coeff[i] = xorshift32(&state) % MODULUS_Q;
     }
-    
-    crypto_prng_init(old_state);
 }
 
-int ring_lwe_keygen(RingLWEKeyPair *keypair) {
+static int keygen_run(uint32_t *drbg, crypto_keygen_ws_t *ws, RingLWEKeyPair *keypair) {
     int i;
-    /* POLY_DEGREE=512: each Poly512=2048B, made static to avoid 20KB+ stack overflow */
-    static Poly512 a, s, e;
     
-    uint32_t a_seed = 0xDEADBEEF;
-    uint32_t old_state = prng_state; /* Simulate shared system parameter 'a' */
-    crypto_prng_init(a_seed);
-    for(i=0; i<POLY_DEGREE; i++) a.coeff[i] = crypto_random_uint32() % MODULUS_Q;
-    crypto_prng_init(old_state);
+    /* Simulate shared system parameter 'a' (stored for convenience) */
+    expand_public_a(&keypair->random);
     
     /* Sample secret s, error e */
     for(i=0; i<POLY_DEGREE; i++) {
-        s.coeff[i] = gaussian_sample(STD_DEVIATION);
-        e.coeff[i] = gaussian_sample(STD_DEVIATION);
+        ws->s.coeff[i] = noise_sample(drbg);
+        ws->e.coeff[i] = noise_sample(drbg);
     }
     
     /* t = a*s + e */
-    static Poly512 as;
-    poly_mul_schoolbook(&as, &a, &s);
-    poly_add(&keypair->public, &as, &e); // Public key = t
+    poly_mul_small(&ws->as, &keypair->random, &ws->s);
+    poly_add_small(&keypair->public, &ws->as, &ws->e); // Public key = t
     
-    keypair->secret = s;
-    keypair->random = a; // Store 'a' for convenience
+    keypair->secret = ws->s;
+    secure_zero(ws, sizeof(*ws));
     
     return 0;
 }
 
+int ring_lwe_keygen(RingLWEKeyPair *keypair) {
+    size_t mark = crypto_arena_mark();
+    crypto_keygen_ws_t *ws = crypto_arena_alloc(sizeof(*ws));
+    int ret;
+    
+    if (ws == NULL) return -1;
+    ret = keygen_run(&prng_state, ws, keypair);
+    crypto_arena_release(mark);
+    return ret;
+}
+
+int crypto_ring_lwe_keygen(crypto_ctx_t *ctx, RingLWEKeyPair *keypair) {
+    return keygen_run(&ctx->drbg, &ctx->ws.keygen, keypair);
+}
+
 /* ========== RING COMPONENT HELPERS ========== */
 
 /* Helper to get High Bits (approximation) of w */
@@ -316,54 +541,49 @@ static void get_high_bits(Poly512 *out, const Poly512 *in) {
     }
 }
 
-int ring_sign(RingSignature *sig, const uint8_t *keyword,
-              const RingLWEKeyPair *signer_keypair,
-              const Poly512 ring_pubkeys[RING_SIZE],
-              int signer_index) {
+static int sign_run(uint32_t *drbg, crypto_sign_ws_t *ws, RingSignature *sig,
+                    const uint8_t *keyword, const RingLWEKeyPair *signer_keypair,
+                    int signer_index) {
     int i, j, attempt;
-    /* Static to prevent 18KB+ stack overflow with POLY_DEGREE=512 */
-    static Poly512 y, w, sc, z, w_approx, tc, w_check;
     uint8_t c_hash[SHA256_DIGEST_SIZE];
-    static Poly512 challenge;
-    static uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
     
     /* Rejection Sampling */
     for(attempt = 0; attempt < 500; attempt++) {
         /* 1. Sample y (make it slightly larger to hide s*c) */
         /* Range: +/- 100000. s*c is ~2000. Masking is OK. */
         for(i=0; i<POLY_DEGREE; i++) {
-             y.coeff[i] = (int32_t)(crypto_random_uint32() % 200000) - 100000;
+             ws->y.coeff[i] = (int32_t)(xorshift32(drbg) % 200000) - 100000;
         }
         
         /* 2. w = a*y */
-        poly_mul_schoolbook(&w, &signer_keypair->random, &y);
+        poly_mul_schoolbook(&ws->w, &signer_keypair->random, &ws->y);
         
         /* 3. Get High Bits of w */
-        get_high_bits(&w_approx, &w);
+        get_high_bits(&ws->w_approx, &ws->w);
         
         /* 4. c = H(w_approx, keyword) */
         /* Serialize w_approx */
         for(i=0; i<POLY_DEGREE; i++) {
-             int32_t v = w_approx.coeff[i];
-             hash_input[i*4] = (v >> 24) & 0xFF;
-             hash_input[i*4+1] = (v >> 16) & 0xFF;
-             hash_input[i*4+2] = (v >> 8) & 0xFF;
-             hash_input[i*4+3] = v & 0xFF;
+             int32_t v = ws->w_approx.coeff[i];
+             ws->hash_input[i*4] = (v >> 24) & 0xFF;
+             ws->hash_input[i*4+1] = (v >> 16) & 0xFF;
+             ws->hash_input[i*4+2] = (v >> 8) & 0xFF;
+             ws->hash_input[i*4+3] = v & 0xFF;
         }
-        memcpy(hash_input + POLY_DEGREE*4, keyword, KEYWORD_SIZE);
-        sha256_hash(c_hash, hash_input, POLY_DEGREE*4 + KEYWORD_SIZE);
+        memcpy(ws->hash_input + POLY_DEGREE*4, keyword, KEYWORD_SIZE);
+        sha256_hash(c_hash, ws->hash_input, POLY_DEGREE*4 + KEYWORD_SIZE);
         
         /* Expand c */
-        for(i=0; i<POLY_DEGREE; i++) challenge.coeff[i] = (c_hash[i%32] >> (i%8)) & 1;
+        for(i=0; i<POLY_DEGREE; i++) ws->challenge.coeff[i] = (c_hash[i%32] >> (i%8)) & 1;
         
         /* 5. z = y + s*c */
-        poly_mul_schoolbook(&sc, &signer_keypair->secret, &challenge);
-        poly_add(&z, &y, &sc);
+        poly_mul_small(&ws->sc, &ws->challenge, &signer_keypair->secret);
+        poly_add(&ws->z, &ws->y, &ws->sc);
         
         /* 6. Bounds Check on z (Security) */
         int bound_ok = 1;
         for(i=0; i<POLY_DEGREE; i++) {
-            int32_t val = z.coeff[i];
+            int32_t val = ws->z.coeff[i];
             if (val > MODULUS_Q/2) val -= MODULUS_Q;
             if (abs(val) > 120000) bound_ok = 0; // Approx bound
         }
@@ -371,19 +591,18 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
         
         /* 7. Correctness Check (Verify w_approx consistency) */
         /* w' = a*z - t*c */
-        poly_mul_schoolbook(&tc, &signer_keypair->public, &challenge);
-        poly_mul_schoolbook(&w_check, &signer_keypair->random, &z);
-        poly_sub(&w_check, &w_check, &tc);
+        poly_mul_schoolbook(&ws->tc, &signer_keypair->public, &ws->challenge);
+        poly_mul_schoolbook(&ws->w_check, &signer_keypair->random, &ws->z);
+        poly_sub(&ws->w_check, &ws->w_check, &ws->tc);
         
-        static Poly512 w_check_approx;
-        get_high_bits(&w_check_approx, &w_check);
+        get_high_bits(&ws->w_check_approx, &ws->w_check);
         
         /* Check diff <= 1 dealing with modular wrap */
         int consistent = 1;
         int32_t MAX_HIGH = (MODULUS_Q - 1) >> 13;
         
         for(i=0; i<POLY_DEGREE; i++) {
-            int32_t diff = w_approx.coeff[i] - w_check_approx.coeff[i];
+            int32_t diff = ws->w_approx.coeff[i] - ws->w_check_approx.coeff[i];
             /* Handle wrap around */
             if (diff > MAX_HIGH/2) diff -= (MAX_HIGH + 1);
             if (diff < -MAX_HIGH/2) diff += (MAX_HIGH + 1);
@@ -396,8 +615,8 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
         
         if (consistent) {
             /* Success */
-            sig->S[signer_index] = z;
-            sig->w = w_approx; /* Store approximate w */
+            sig->S[signer_index] = ws->z;
+            sig->w = ws->w_approx; /* Store approximate w */
             memcpy(sig->commitment, c_hash, SHA256_DIGEST_SIZE);
             memcpy(sig->keyword, keyword, KEYWORD_SIZE);
             
@@ -407,89 +626,156 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
                      for(j=0; j<POLY_DEGREE; j++) sig->S[i].coeff[j] = 0;
                 }
             }
+            secure_zero(ws, sizeof(*ws));
             return 0;
         }
         watchdog_periodic();
     }
     
+    secure_zero(ws, sizeof(*ws));
     return -1;
 }
 
-int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE]) {
-    int i, j;
-    /* Static to prevent 14KB+ stack overflow with POLY_DEGREE=512 */
-    static Poly512 a, z, tc, w_prime, challenge;
-    static Poly512 w_expected;
-    w_expected = sig->w; /* Copy from signature */
+int ring_sign(RingSignature *sig, const uint8_t *keyword,
+              const RingLWEKeyPair *signer_keypair,
+              const Poly512 ring_pubkeys[RING_SIZE],
+              int signer_index) {
+    size_t mark = crypto_arena_mark();
+    crypto_sign_ws_t *ws = crypto_arena_alloc(sizeof(*ws));
+    int ret;
+    
+    if (ws == NULL) return -1;
+    ret = sign_run(&prng_state, ws, sig, keyword, signer_keypair, signer_index);
+    crypto_arena_release(mark);
+    return ret;
+}
+
+int crypto_ring_sign(crypto_ctx_t *ctx, RingSignature *sig, const uint8_t *keyword,
+                     const RingLWEKeyPair *signer_keypair,
+                     const Poly512 ring_pubkeys[RING_SIZE], int signer_index) {
+    return sign_run(&ctx->drbg, &ctx->ws.sign, sig, keyword, signer_keypair, signer_index);
+}
+
+/* z, t and w are read through the views, never copied */
+static int verify_run(crypto_verify_ws_t *ws, const RingSignatureView *sig,
+                      const PolyView public_keys[RING_SIZE]) {
+    int i, j, m;
     uint8_t c_hash[SHA256_DIGEST_SIZE];
-    static uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
     
     /* 1. Reconstruct 'a' */
-    uint32_t a_seed = 0xDEADBEEF;
-    uint32_t old_state = prng_state;
-    crypto_prng_init(a_seed);
-    for(i=0; i<POLY_DEGREE; i++) a.coeff[i] = crypto_random_uint32() % MODULUS_Q;
-    crypto_prng_init(old_state);
+    expand_public_a(&ws->a);
     
     /* 2. Verify 'c' matches 'w_approx' */
-    for(i=0; i<POLY_DEGREE; i++) {
-         int32_t v = w_expected.coeff[i];
-         hash_input[i*4] = (v >> 24) & 0xFF;
-         hash_input[i*4+1] = (v >> 16) & 0xFF;
-         hash_input[i*4+2] = (v >> 8) & 0xFF;
-         hash_input[i*4+3] = v & 0xFF;
+    if (sig->w.wire != NULL) {
+        memcpy(ws->hash_input, sig->w.wire, POLY_DEGREE * 4);
+    } else {
+        serialize_poly512(ws->hash_input, sig->w.poly);
     }
-    memcpy(hash_input + POLY_DEGREE*4, sig->keyword, KEYWORD_SIZE);
-    sha256_hash(c_hash, hash_input, POLY_DEGREE*4 + KEYWORD_SIZE);
+    memcpy(ws->hash_input + POLY_DEGREE*4, sig->keyword, KEYWORD_SIZE);
+    sha256_hash(c_hash, ws->hash_input, POLY_DEGREE*4 + KEYWORD_SIZE);
     
     if (memcmp(c_hash, sig->commitment, SHA256_DIGEST_SIZE) != 0) {
         return 0; // Commitment check failed
     }
     
     /* Reconstruct challenge c */
-    for(i=0; i<POLY_DEGREE; i++) challenge.coeff[i] = (c_hash[i%32] >> (i%8)) & 1;
+    for(i=0; i<POLY_DEGREE; i++) ws->challenge.coeff[i] = (c_hash[i%32] >> (i%8)) & 1;
     
     /* 3. Check each member for signature validity */
-    for(i=0; i<RING_SIZE; i++) {
-        z = sig->S[i];
+    for(m=0; m<RING_SIZE; m++) {
+        const PolyView *z = &sig->S[m];
+        const PolyView *t = &public_keys[m];
         
         /* Skip if z is all zeros (optimization for fake members) */
-        int non_zero = 0;
-        for(j=0; j<POLY_DEGREE; j++) if(z.coeff[j] != 0) non_zero = 1;
-        if (!non_zero) continue; 
-        
-        /* w' = a*z - t*c */
-        poly_mul_schoolbook(&w_prime, &a, &z);
-        poly_mul_schoolbook(&tc, &public_keys[i], &challenge);
-        poly_sub(&w_prime, &w_prime, &tc);
+        for(j=0; j<POLY_DEGREE; j++) if(poly_view_coeff(z, j) != 0) break;
+        if (j == POLY_DEGREE) continue;
         
-        static Poly512 w_prime_approx;
-        get_high_bits(&w_prime_approx, &w_prime);
+        /* w' = a*z - t*c in one schoolbook pass, z[i] and t[i] decoded
+         * once per row (c binary, so t*c is additions only) */
+        memset(ws->acc, 0, sizeof(ws->acc));
+        for (i = 0; i < POLY_DEGREE; i++) {
+            int32_t zi = poly_view_coeff(z, i);
+            int32_t ti = poly_view_coeff(t, i);
+            
+            for (j = 0; j < POLY_DEGREE; j++) {
+                int64_t v = ws->acc[i+j] + (int64_t)ws->a.coeff[j] * zi;
+                if (ws->challenge.coeff[j]) v -= ti;
+                ws->acc[i+j] = mod_q(v);
+            }
+        }
         
-        /* Check consistency with transmitted w_approx */
-        int consistent = 1;
+        /* Reduce mod x^n + 1 and check consistency with transmitted w_approx */
         int32_t MAX_HIGH = (MODULUS_Q - 1) >> 13;
         
         for(j=0; j<POLY_DEGREE; j++) {
-            int32_t diff = w_prime_approx.coeff[j] - w_expected.coeff[j];
+            int32_t w_prime = mod_q((int64_t)ws->acc[j] - (int64_t)ws->acc[POLY_DEGREE + j]);
+            int32_t diff = (w_prime >> 13) - poly_view_coeff(&sig->w, j);
             /* Handle wrap around */
             if (diff > MAX_HIGH/2) diff -= (MAX_HIGH + 1);
             if (diff < -MAX_HIGH/2) diff += (MAX_HIGH + 1);
             
             if (abs(diff) > 4) {
-                consistent = 0;
                 break;
             }
         }
         
-        if (consistent) {
+        if (j == POLY_DEGREE) {
+            secure_zero(ws, sizeof(*ws));
             return 1; // Valid signature found!
         }
     }
     
+    secure_zero(ws, sizeof(*ws));
     return 0; // No valid signature found
 }
 
+int ring_verify_view(const RingSignatureView *sig, const PolyView public_keys[RING_SIZE]) {
+    size_t mark = crypto_arena_mark();
+    crypto_verify_ws_t *ws = crypto_arena_alloc(sizeof(*ws));
+    int ret;
+    
+    if (ws == NULL) return 0; // No scratch: not verified
+    ret = verify_run(ws, sig, public_keys);
+    crypto_arena_release(mark);
+    return ret;
+}
+
+int crypto_ring_verify_view(crypto_ctx_t *ctx, const RingSignatureView *sig,
+                            const PolyView public_keys[RING_SIZE]) {
+    return verify_run(&ctx->ws.verify, sig, public_keys);
+}
+
+/* Views of a host signature and host keys */
+static void verify_views(RingSignatureView *view, PolyView keys[RING_SIZE],
+                         const RingSignature *sig, const Poly512 public_keys[RING_SIZE]) {
+    int i;
+    
+    for (i = 0; i < RING_SIZE; i++) {
+        view->S[i] = poly_view(&sig->S[i]);
+        keys[i] = poly_view(&public_keys[i]);
+    }
+    view->w = poly_view(&sig->w);
+    view->commitment = sig->commitment;
+    view->keyword = sig->keyword;
+}
+
+int crypto_ring_verify(crypto_ctx_t *ctx, const RingSignature *sig,
+                       const Poly512 public_keys[RING_SIZE]) {
+    RingSignatureView view;
+    PolyView keys[RING_SIZE];
+    
+    verify_views(&view, keys, sig, public_keys);
+    return crypto_ring_verify_view(ctx, &view, keys);
+}
+
+int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE]) {
+    RingSignatureView view;
+    PolyView keys[RING_SIZE];
+    
+    verify_views(&view, keys, sig, public_keys);
+    return ring_verify_view(&view, keys);
+}
+
 /* ========== LDPC STUBS (Unchanged) ========== */
 int ldpc_keygen(LDPCKeyPair *keypair) { return 0; }
 void generate_error_vector(ErrorVector *error, uint16_t target_weight) { memset(error, 0, sizeof(*error)); }
@@ -69,11 +69,19 @@ typedef struct {
     int32_t coeff[POLY_DEGREE];
 } Poly512;
 
+/**
+ * Small-coefficient polynomial (|c| <= 128): secrets and errors, a
+ * quarter of a Poly512. Coefficients are plain integers, not reduced mod q.
+ */
+typedef struct {
+    int8_t coeff[POLY_DEGREE];
+} PolySmall;
+
 /**
  * Ring-LWE key pair
  */
 typedef struct {
-    Poly512 secret;      // Secret key sk
+    PolySmall secret;    // Secret key sk
     Poly512 public;      // Public key pk
     Poly512 random;      // Random polynomial R
 } RingLWEKeyPair;
@@ -88,6 +96,68 @@ typedef struct {
     uint8_t keyword[KEYWORD_SIZE];         // Signed keyword
 } RingSignature;
 
+/**
+ * Read-only polynomial view
+ * Either a host Poly512 or POLY_DEGREE big-endian 32-bit words in a wire
+ * buffer, read in place (poly_view_coeff).
+ */
+typedef struct {
+    const Poly512 *poly;                   // Host form, or NULL ...
+    const uint8_t *wire;                   // ... wire form
+} PolyView;
+
+/**
+ * Read-only ring signature view (components may live in a wire buffer)
+ */
+typedef struct {
+    PolyView S[RING_SIZE];
+    PolyView w;
+    const uint8_t *commitment;
+    const uint8_t *keyword;
+} RingSignatureView;
+
+/**
+ * Scratch for ring_lwe_keygen()
+ */
+typedef struct {
+    PolySmall s, e;
+    Poly512 as;
+} crypto_keygen_ws_t;
+
+/**
+ * Scratch for ring_sign()
+ */
+typedef struct {
+    Poly512 y, w, sc, z, w_approx, tc, w_check, w_check_approx, challenge;
+    uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
+} crypto_sign_ws_t;
+
+/**
+ * Scratch for ring_verify_view()
+ */
+typedef struct {
+    Poly512 a, challenge;
+    int32_t acc[2 * POLY_DEGREE];
+    uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
+} crypto_verify_ws_t;
+
+/**
+ * Explicit crypto state: the DRBG and the scratch of the lattice
+ * operations, sized for the largest of them (~21KB at POLY_DEGREE=512).
+ * crypto_* functions taking a context touch no global or static state,
+ * so handshakes with their own contexts can run concurrently. The
+ * context-free API (ring_sign() etc.) keeps its signatures: it runs on
+ * the default PRNG and borrows its workspace from the scratch arena.
+ */
+typedef struct {
+    uint32_t drbg;                         // Xorshift32 state, never 0
+    union {
+        crypto_keygen_ws_t keygen;
+        crypto_sign_ws_t sign;
+        crypto_verify_ws_t verify;
+    } ws;
+} crypto_ctx_t;
+
 /**
  * QC-LDPC public key (compressed circulant representation)
  */
@@ -135,6 +205,41 @@ typedef struct {
     uint8_t in_use;
 } session_entry_t;
 
+/**
+ * Authentication message (sender -> gateway, fragmented on the wire)
+ */
+typedef struct {
+    uint8_t type;
+    uint8_t syndrome[LDPC_ROWS / 8];
+    Poly512 public_key;                    // Sender's key (ring member 0)
+    RingSignature signature;
+} AuthMessage;
+
+/* Wire form: type || syndrome || pk || S[0..N-1] || w || commitment || keyword,
+ * coefficients as big-endian 32-bit words */
+#define AUTH_MSG_WIRE_LEN (1 + LDPC_ROWS / 8 + (RING_SIZE + 2) * POLY_DEGREE * 4 + \
+                           SHA256_DIGEST_SIZE + KEYWORD_SIZE)
+
+/**
+ * Read-only view of a wire-form AuthMessage (auth_msg_view)
+ */
+typedef struct {
+    uint8_t type;
+    const uint8_t *syndrome;
+    PolyView public_key;
+    RingSignatureView signature;
+} AuthMessageView;
+
+/**
+ * Serialiser cursor over an AuthMessage
+ * Produces any byte range of the wire form straight from the message,
+ * so fragments are encoded on demand without a staging buffer.
+ */
+typedef struct {
+    const AuthMessage *msg;
+    size_t offset;                         // Next wire byte
+} auth_cursor_t;
+
 /**
  * Authentication fragment (for reliable transmission)
  */
@@ -173,6 +278,17 @@ void poly_mod_q(Poly512 *result, const Poly512 *a);
  */
 void poly_add(Poly512 *result, const Poly512 *a, const Poly512 *b);
 
+/**
+ * result = a * s mod q (s small): each output coefficient accumulated
+ * in an int64 and reduced once
+ */
+void poly_mul_small(Poly512 *result, const Poly512 *a, const PolySmall *s);
+
+/**
+ * result = a + s mod q (s small)
+ */
+void poly_add_small(Poly512 *result, const Poly512 *a, const PolySmall *s);
+
 /**
  * Polynomial subtraction: result = a - b mod q
  */
@@ -215,10 +331,64 @@ void crypto_secure_random(uint8_t *output, size_t len);
  */
 int32_t gaussian_sample(int sigma);
 
+/**
+ * Seed a context's DRBG (0 is replaced, xorshift would stick at it)
+ */
+void crypto_ctx_init(crypto_ctx_t *ctx, uint32_t seed);
+
+/**
+ * crypto_random_uint32() / crypto_secure_random() on a context's DRBG
+ */
+uint32_t crypto_ctx_random_uint32(crypto_ctx_t *ctx);
+void crypto_ctx_random(crypto_ctx_t *ctx, uint8_t *output, size_t len);
+
+/* ========== SCRATCH ARENA ========== */
+
+/* Allocations are rounded up to CRYPTO_ARENA_ALIGN bytes */
+#define CRYPTO_ARENA_ALIGN 8
+#define CRYPTO_ARENA_ROUND(n) \
+    (((n) + CRYPTO_ARENA_ALIGN - 1) & ~(size_t)(CRYPTO_ARENA_ALIGN - 1))
+
+/* Arena bytes borrowed by ring_lwe_keygen(), ring_sign() and
+ * ring_verify() / ring_verify_view() while they run */
+#define CRYPTO_ARENA_KEYGEN CRYPTO_ARENA_ROUND(sizeof(crypto_keygen_ws_t))
+#define CRYPTO_ARENA_SIGN   CRYPTO_ARENA_ROUND(sizeof(crypto_sign_ws_t))
+#define CRYPTO_ARENA_VERIFY CRYPTO_ARENA_ROUND(sizeof(crypto_verify_ws_t))
+
+/**
+ * Hand the crypto layer its scratch arena (mem aligned to
+ * CRYPTO_ARENA_ALIGN). The application sizes it from its largest working
+ * set and may borrow from it too, e.g. for buffers used in one phase only.
+ */
+void crypto_arena_init(void *mem, size_t size);
+
+/**
+ * Borrow len bytes (stack order)
+ * @returns NULL (and logs) when the arena is too small
+ */
+void *crypto_arena_alloc(size_t len);
+
+/**
+ * Current fill level, to hand back to crypto_arena_release()
+ */
+size_t crypto_arena_mark(void);
+
+/**
+ * Zero and return everything borrowed since mark
+ */
+void crypto_arena_release(size_t mark);
+
+/**
+ * Log the arena peak since the previous report, labelled with a phase
+ */
+void crypto_arena_report(const char *phase);
+
 /* ========== RING-LWE OPERATIONS ========== */
 
 /**
  * Ring-LWE key generation with rejection sampling
+ * ring_lwe_keygen(), ring_sign() and ring_verify() borrow their scratch
+ * from the arena and fail (-1, -1, 0) when it is too small.
  */
 int ring_lwe_keygen(RingLWEKeyPair *keypair);
 
@@ -246,6 +416,26 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
  */
 int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE]);
 
+/**
+ * As ring_verify(), reading signature and keys through views
+ * (e.g. straight from the reassembly buffer, with no copies)
+ */
+int ring_verify_view(const RingSignatureView *sig, const PolyView public_keys[RING_SIZE]);
+
+/**
+ * ring_lwe_keygen() / ring_sign() / ring_verify() / ring_verify_view()
+ * on a context: its DRBG and workspace only. Same results as the
+ * context-free calls when the DRBG holds the same state as the default PRNG.
+ */
+int crypto_ring_lwe_keygen(crypto_ctx_t *ctx, RingLWEKeyPair *keypair);
+int crypto_ring_sign(crypto_ctx_t *ctx, RingSignature *sig, const uint8_t *keyword,
+                     const RingLWEKeyPair *signer_keypair,
+                     const Poly512 ring_pubkeys[RING_SIZE], int signer_index);
+int crypto_ring_verify(crypto_ctx_t *ctx, const RingSignature *sig,
+                       const Poly512 public_keys[RING_SIZE]);
+int crypto_ring_verify_view(crypto_ctx_t *ctx, const RingSignatureView *sig,
+                            const PolyView public_keys[RING_SIZE]);
+
 /* ========== QC-LDPC OPERATIONS ========== */
 
 /**
@@ -376,4 +566,53 @@ int constant_time_compare(const uint8_t *a, const uint8_t *b, uint32_t len);
 void serialize_poly512(uint8_t *out, const Poly512 *p);
 void deserialize_poly512(Poly512 *p, const uint8_t *in);
 
+/**
+ * Coefficient i of a polynomial view (big-endian decode for wire views)
+ */
+static inline int32_t poly_view_coeff(const PolyView *v, int i) {
+    const uint8_t *b;
+    
+    if (v->poly != NULL) return v->poly->coeff[i];
+    b = v->wire + 4 * i;
+    return (int32_t)(((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+                     ((uint32_t)b[2] << 8) | (uint32_t)b[3]);
+}
+
+/**
+ * View a host polynomial
+ */
+static inline PolyView poly_view(const Poly512 *p) {
+    PolyView v;
+    v.poly = p;
+    v.wire = NULL;
+    return v;
+}
+
+/**
+ * View a wire-form AuthMessage in place (the buffer must outlive the view)
+ * @returns 0 on success, -1 if len is not AUTH_MSG_WIRE_LEN
+ */
+int auth_msg_view(AuthMessageView *view, const uint8_t *wire, size_t len);
+
+/**
+ * Print the first coefficients of a view (debugging)
+ */
+void poly_view_print(const char *label, const PolyView *v, int num_coeffs);
+
+/**
+ * Start a cursor at wire offset 0
+ */
+void auth_cursor_init(auth_cursor_t *cur, const AuthMessage *msg);
+
+/**
+ * Move to wire offset (clamped to AUTH_MSG_WIRE_LEN)
+ */
+void auth_cursor_seek(auth_cursor_t *cur, size_t offset);
+
+/**
+ * Encode up to len wire bytes at the cursor and advance
+ * @returns Bytes written (short only at the end of the message)
+ */
+size_t auth_cursor_read(auth_cursor_t *cur, uint8_t *out, size_t len);
+
 #endif /* CRYPTO_CORE_BP_H_ */
@@ -33,13 +33,6 @@ static uint8_t reassembly_buf[12000];
 
 /* ========== MESSAGE STRUCTURES ========== */
 
-typedef struct {
-    uint8_t type;
-    uint8_t syndrome[LDPC_ROWS / 8];
-    Poly512 public_key; /* Added Public Key */
-    RingSignature signature;
-} AuthMessage;
-
 typedef struct {
     uint8_t type;
     uint8_t N_G[32];
@@ -52,6 +45,12 @@ static RingLWEKeyPair gateway_keypair;
 static LDPCKeyPair gateway_ldpc_keypair;
 static Poly512 ring_public_keys[RING_SIZE];
 
+/* Scratch arena for keygen at boot and ring_verify_view() per handshake
+ * (reassembly_buf stays static: an AUTH may start at any time) */
+#define GATEWAY_ARENA_SIZE (CRYPTO_ARENA_KEYGEN > CRYPTO_ARENA_VERIFY ? \
+                            CRYPTO_ARENA_KEYGEN : CRYPTO_ARENA_VERIFY)
+static uint64_t arena_mem[GATEWAY_ARENA_SIZE / sizeof(uint64_t)];
+
 /* ========== SESSION MANAGEMENT ========== */
 
 static session_entry_t session_table[MAX_SESSIONS];
@@ -170,45 +169,34 @@ udp_rx_callback(struct simple_udp_connection *c,
         if (fragment_id == total_frags - 1) {
             LOG_INFO("Reassembly complete. Verifying signature...\n");
             
-            static AuthMessage auth_msg_store;
-            AuthMessage *auth_msg = &auth_msg_store;
-            size_t offset = 0;
-            
-            auth_msg->type = reassembly_buf[offset++];
-            memcpy(auth_msg->syndrome, reassembly_buf + offset, LDPC_ROWS / 8);
-            offset += LDPC_ROWS / 8;
-            
-            deserialize_poly512(&auth_msg->public_key, reassembly_buf + offset);
-            offset += POLY_DEGREE * 4;
-            
+            /* Verify straight from reassembly_buf: no deserialised copy
+             * of the ~10 KB message */
+            static AuthMessageView auth_view;
+            static PolyView verify_keys[RING_SIZE];
             int i;
-            for(i=0; i<RING_SIZE; i++) {
-                deserialize_poly512(&auth_msg->signature.S[i], reassembly_buf + offset);
-                offset += POLY_DEGREE * 4;
-            }
-            deserialize_poly512(&auth_msg->signature.w, reassembly_buf + offset);
-            offset += POLY_DEGREE * 4;
-            
-            memcpy(auth_msg->signature.commitment, reassembly_buf + offset, SHA256_DIGEST_SIZE);
-            offset += SHA256_DIGEST_SIZE;
             
-            memcpy(auth_msg->signature.keyword, reassembly_buf + offset, KEYWORD_SIZE);
-            offset += KEYWORD_SIZE;
+            if (auth_msg_view(&auth_view, reassembly_buf, AUTH_MSG_WIRE_LEN) != 0) {
+                return;
+            }
             
             /* Use received public key for verification (Index 0) */
-            ring_public_keys[0] = auth_msg->public_key;
+            verify_keys[0] = auth_view.public_key;
+            for (i = 1; i < RING_SIZE; i++) {
+                verify_keys[i] = poly_view(&ring_public_keys[i]);
+            }
             
             /* Verify signature */
             LOG_INFO("Verifying with key[0]:\n");
-            poly_print("Verify Key", &ring_public_keys[0], 8);
+            poly_view_print("Verify Key", &verify_keys[0], 8);
             
             /* DEBUG: Check Signature integrity */
             LOG_INFO("DEBUG: Received Signature w (first 8 coeffs):\n");
-            poly_print("Recv Sig.w", &auth_msg->signature.w, 8);
+            poly_view_print("Recv Sig.w", &auth_view.signature.w, 8);
             LOG_INFO("DEBUG: Received Commitment (first 4 bytes): %02x%02x%02x%02x\n",
-                     auth_msg->signature.commitment[0], auth_msg->signature.commitment[1],
-                     auth_msg->signature.commitment[2], auth_msg->signature.commitment[3]);
-            int verify_result = ring_verify(&auth_msg->signature, ring_public_keys);
+                     auth_view.signature.commitment[0], auth_view.signature.commitment[1],
+                     auth_view.signature.commitment[2], auth_view.signature.commitment[3]);
+            int verify_result = ring_verify_view(&auth_view.signature, verify_keys);
+            crypto_arena_report("verify");
             
             if (verify_result != 1) {
                 LOG_ERR("Ring signature verification FAILED!\n");
@@ -217,14 +205,10 @@ udp_rx_callback(struct simple_udp_connection *c,
             
             LOG_INFO("Ring signature verified: SUCCESS\n");
             
-            /* Extract syndrome */
-            uint8_t received_syndrome[LDPC_ROWS / 8];
-            memcpy(received_syndrome, auth_msg->syndrome, LDPC_ROWS / 8);
-            
-            /* LDPC decode */
+            /* LDPC decode (syndrome read in place) */
             LOG_INFO("Decoding LDPC syndrome...\n");
             ErrorVector recovered_error;
-            int decode_ret = sldspa_decode(&recovered_error, received_syndrome,
+            int decode_ret = sldspa_decode(&recovered_error, auth_view.syndrome,
                                           &gateway_ldpc_keypair);
             
             if (decode_ret != 0) {
@@ -354,6 +338,7 @@ PROCESS_THREAD(gateway_process, ev, data)
     
     /* Initialize PRNG */
     crypto_prng_init(0xCAFEBABE);
+    crypto_arena_init(arena_mem, sizeof(arena_mem));
     
     /* ===== KEY GENERATION ===== */
     LOG_INFO("[Initialization] Generating cryptographic keys...\n");
@@ -364,6 +349,7 @@ PROCESS_THREAD(gateway_process, ev, data)
         PROCESS_EXIT();
     }
     LOG_INFO("   Ring-LWE key generation: SUCCESS\n");
+    crypto_arena_report("keygen");
     
     LOG_INFO("2. Generating QC-LDPC keys...\n");
     if (ldpc_keygen(&gateway_ldpc_keypair) != 0) {
@@ -385,6 +371,10 @@ PROCESS_THREAD(gateway_process, ev, data)
         LOG_INFO("   - Ring member %d public key generated\n", i + 1);
     }
     LOG_INFO("   Ring setup complete\n");
+    LOG_INFO("RAM [static]: keys %u B, sessions %u B, reassembly %u B, arena %u B\n",
+             (unsigned)(sizeof(gateway_keypair) + sizeof(ring_public_keys)),
+             (unsigned)sizeof(session_table), (unsigned)sizeof(reassembly_buf),
+             (unsigned)sizeof(arena_mem));
     
     LOG_INFO("\n=== Gateway Ready ===\n");
     LOG_INFO("Configuration:\n");
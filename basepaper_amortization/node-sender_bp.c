@@ -34,13 +34,6 @@ static volatile int last_ack_received = -1;
 
 /* ========== MESSAGE STRUCTURES ========== */
 
-typedef struct {
-    uint8_t type;
-    uint8_t syndrome[LDPC_ROWS / 8];
-    Poly512 public_key; /* Added Public Key for robust verification */
-    RingSignature signature;
-} AuthMessage;
-
 typedef struct {
     uint8_t type;
     uint8_t N_G[32];
@@ -55,6 +48,13 @@ typedef struct {
     uint16_t cipher_len;
 } DataMessage;
 
+/* Data-phase buffers, borrowed from the arena once auth_msg is released */
+typedef struct {
+    char msg[64];
+    uint8_t ciphertext[MESSAGE_MAX_SIZE + AEAD_TAG_LEN];
+    uint8_t wire[256];
+} data_bufs_t;
+
 /* ========== CRYPTOGRAPHIC STATE ========== */
 
 static RingLWEKeyPair sender_keypair;
@@ -63,6 +63,11 @@ static session_ctx_t session_ctx;
 static ErrorVector auth_error_vector;
 static uint8_t syndrome[LDPC_ROWS / 8];
 
+/* Scratch arena, sized for the largest working set: auth_msg while
+ * ring_sign() runs. Keygen and the data phase need less. */
+#define SENDER_ARENA_SIZE (CRYPTO_ARENA_ROUND(sizeof(AuthMessage)) + CRYPTO_ARENA_SIGN)
+static uint64_t arena_mem[SENDER_ARENA_SIZE / sizeof(uint64_t)];
+
 /* Message to encrypt */
 static const char *secret_message = "Hello IoT";
 #define RENEW_THRESHOLD 20   /* Renew session after 20 messages */
@@ -143,6 +148,7 @@ PROCESS_THREAD(sender_process, ev, data)
     /* Initialize PRNG */
     uint32_t sender_seed = 0x12345678;
     crypto_prng_init(sender_seed);
+    crypto_arena_init(arena_mem, sizeof(arena_mem));
     
     /* ===== KEY GENERATION ===== */
     LOG_INFO("[Phase 1] Generating Ring-LWE keys...\n");
@@ -153,6 +159,7 @@ PROCESS_THREAD(sender_process, ev, data)
     }
     
     LOG_INFO("Ring-LWE key generation successful\n");
+    crypto_arena_report("keygen");
     poly_print("Sender PubKey", &sender_keypair.public, 8);
     
     /* Generate ring public keys */
@@ -166,6 +173,9 @@ PROCESS_THREAD(sender_process, ev, data)
         generate_ring_member_key(&ring_public_keys[i], i);
         LOG_INFO("  - Ring member %d: Fake key\n", i + 1);
     }
+    LOG_INFO("RAM [static]: keys %u B, session %u B, arena %u B\n",
+             (unsigned)(sizeof(sender_keypair) + sizeof(ring_public_keys)),
+             (unsigned)sizeof(session_ctx), (unsigned)sizeof(arena_mem));
     
     /* Initialize UDP */
     simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, udp_rx_callback);
@@ -193,6 +203,16 @@ PROCESS_THREAD(sender_process, ev, data)
         /* ===== AUTHENTICATION PHASE ===== */
         LOG_INFO("\n[Phase 2] Starting Ring Signature Authentication...\n");
     
+    /* The arena is empty between rounds (a timed-out round still holds
+     * its auth_msg) */
+    crypto_arena_release(0);
+    
+    static AuthMessage *auth_msg;
+    auth_msg = crypto_arena_alloc(sizeof(AuthMessage));
+    if (auth_msg == NULL) {
+        PROCESS_EXIT();
+    }
+    
     /* Generate LDPC public key */
     LOG_INFO("Initializing LDPC public key...\n");
     if (ldpc_keygen((LDPCKeyPair *)&shared_ldpc_pubkey) != 0) {
@@ -217,12 +237,12 @@ PROCESS_THREAD(sender_process, ev, data)
     /* Generate ring signature */
     LOG_INFO("Generating ring signature (N=%d members)...\n", RING_SIZE);
     
-    static AuthMessage auth_msg;
-    auth_msg.type = MSG_TYPE_AUTH;
-    memcpy(auth_msg.syndrome, syndrome, LDPC_ROWS / 8);
-    auth_msg.public_key = sender_keypair.public; /* Send PK */
+    static auth_cursor_t auth_cursor;
+    auth_msg->type = MSG_TYPE_AUTH;
+    memcpy(auth_msg->syndrome, syndrome, LDPC_ROWS / 8);
+    auth_msg->public_key = sender_keypair.public; /* Send PK */
     
-    int sign_result = ring_sign(&auth_msg.signature,
+    int sign_result = ring_sign(&auth_msg->signature,
                                 keyword,
                                 &sender_keypair,
                                 ring_public_keys,
@@ -234,55 +254,29 @@ PROCESS_THREAD(sender_process, ev, data)
     }
     
     LOG_INFO("Ring signature generated successfully\n");
+    crypto_arena_report("sign");
     
     /* DEBUG: Print Key and Sig to compare with Gateway */
     LOG_INFO("DEBUG: Sender Public Key sent:\n");
-    poly_print("PubKey", &auth_msg.public_key, 8);
+    poly_print("PubKey", &auth_msg->public_key, 8);
     LOG_INFO("DEBUG: Signature w sent (first 8 coeffs):\n");
-    poly_print("Sig.w", &auth_msg.signature.w, 8);
+    poly_print("Sig.w", &auth_msg->signature.w, 8);
     LOG_INFO("DEBUG: Signature Commitment (first 4 bytes): %02x%02x%02x%02x\n",
-             auth_msg.signature.commitment[0], auth_msg.signature.commitment[1],
-             auth_msg.signature.commitment[2], auth_msg.signature.commitment[3]);
+             auth_msg->signature.commitment[0], auth_msg->signature.commitment[1],
+             auth_msg->signature.commitment[2], auth_msg->signature.commitment[3]);
     
     /* ===== SEND AUTHENTICATION MESSAGE ===== */
     LOG_INFO("Sending authentication message via fragmentation...\n");
     
-    /* Serialize AuthMessage manually to avoid padding issues */
-    static uint8_t serialized_buffer[12000]; // Max size
-    size_t offset = 0;
-    
-    serialized_buffer[offset++] = auth_msg.type;
-    memcpy(serialized_buffer + offset, auth_msg.syndrome, LDPC_ROWS / 8);
-    offset += LDPC_ROWS / 8;
-    
-    serialize_poly512(serialized_buffer + offset, &auth_msg.public_key);
-    offset += POLY_DEGREE * 4;
-    
-    /* Signature: S[0..2], w, commitment, keyword */
-    int i;
-    for(i=0; i<RING_SIZE; i++) {
-        serialize_poly512(serialized_buffer + offset, &auth_msg.signature.S[i]);
-        offset += POLY_DEGREE * 4;
-    }
-    serialize_poly512(serialized_buffer + offset, &auth_msg.signature.w);
-    offset += POLY_DEGREE * 4;
-    
-    memcpy(serialized_buffer + offset, auth_msg.signature.commitment, SHA256_DIGEST_SIZE);
-    offset += SHA256_DIGEST_SIZE;
-    
-    memcpy(serialized_buffer + offset, auth_msg.signature.keyword, KEYWORD_SIZE);
-    offset += KEYWORD_SIZE;
-    
-    static uint8_t *serialized_auth;
-    serialized_auth = serialized_buffer;
-    static size_t serialized_len;
-    serialized_len = offset;
+    /* Fragments are encoded from auth_msg as they go out: no 12 KB
+     * serialised copy of the n=512 message */
+    auth_cursor_init(&auth_cursor, auth_msg);
     
     static uint16_t total_frags;
-    total_frags = (serialized_len + 63) / 64;
+    total_frags = (AUTH_MSG_WIRE_LEN + 63) / 64;
     
     LOG_INFO("Total payload: %u bytes (%u fragments)\n",
-             (unsigned)serialized_len, total_frags);
+             (unsigned)AUTH_MSG_WIRE_LEN, total_frags);
     
     static int frag_idx;
     for (frag_idx = 0; frag_idx < total_frags; frag_idx++) {
@@ -298,13 +292,10 @@ PROCESS_THREAD(sender_process, ev, data)
             frag.fragment_id = uip_htons(frag_idx);
             frag.total_frags = uip_htons(total_frags);
             
-            size_t offset = frag_idx * 64;
-            size_t len = 64;
-            if (offset + len > serialized_len) {
-                len = serialized_len - offset;
-            }
+            size_t len;
+            auth_cursor_seek(&auth_cursor, (size_t)frag_idx * 64);
+            len = auth_cursor_read(&auth_cursor, frag.payload, 64);
             frag.payload_len = uip_htons(len);
-            memcpy(frag.payload, serialized_auth + offset, len);
             
             LOG_INFO("Sending Fragment %d/%d (%u bytes)...\n",
                      frag_idx + 1, total_frags, (unsigned)len);
@@ -352,21 +343,28 @@ PROCESS_THREAD(sender_process, ev, data)
     }
     
     LOG_INFO("\n=== AUTHENTICATION COMPLETE ===\n");
+    crypto_arena_report("handshake");
+    
+    /* auth_msg is dead from here on: its bytes become the data buffers */
+    crypto_arena_release(0);
+    static data_bufs_t *bufs;
+    bufs = crypto_arena_alloc(sizeof(data_bufs_t));
+    if (bufs == NULL) {
+        PROCESS_EXIT();
+    }
     
     /* ===== DATA TRANSMISSION PHASE ===== */
     LOG_INFO("[Phase 3] Starting Amortized Periodic Data Transmission...\n");
     
     while(session_ctx.active && session_ctx.counter <= RENEW_THRESHOLD) {
-        char msg_buf[64];
-        snprintf(msg_buf, sizeof(msg_buf), "%s #%u", secret_message, (unsigned)session_ctx.counter);
+        snprintf(bufs->msg, sizeof(bufs->msg), "%s #%u", secret_message, (unsigned)session_ctx.counter);
         
         /* Session encrypt */
-        uint8_t ciphertext[MESSAGE_MAX_SIZE + AEAD_TAG_LEN];
         size_t cipher_len;
         
         int ret = session_encrypt(&session_ctx,
-                                 (uint8_t *)msg_buf, strlen(msg_buf) + 1,
-                                 ciphertext, &cipher_len);
+                                 (uint8_t *)bufs->msg, strlen(bufs->msg) + 1,
+                                 bufs->ciphertext, &cipher_len);
         
         if (ret != 0) {
             LOG_ERR("Encryption failed for message %u!\n", (unsigned)session_ctx.counter);
@@ -376,7 +374,7 @@ PROCESS_THREAD(sender_process, ev, data)
         LOG_INFO("Message %u encrypted (%u bytes)\n", (unsigned)session_ctx.counter, (unsigned)cipher_len);
         
         /* Pack wire format */
-        uint8_t wire_buf[256];
+        uint8_t *wire_buf = bufs->wire;
         size_t wire_offset = 0;
         
         wire_buf[wire_offset++] = MSG_TYPE_DATA;
@@ -391,7 +389,7 @@ PROCESS_THREAD(sender_process, ev, data)
         wire_buf[wire_offset++] = (cipher_len >> 8) & 0xFF;
         wire_buf[wire_offset++] = cipher_len & 0xFF;
         
-        memcpy(wire_buf + wire_offset, ciphertext, cipher_len);
+        memcpy(wire_buf + wire_offset, bufs->ciphertext, cipher_len);
         wire_offset += cipher_len;
         
         /* Send to gateway */
@@ -405,6 +403,8 @@ PROCESS_THREAD(sender_process, ev, data)
         PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
     }
     
+    crypto_arena_report("data");
+    
     if (session_ctx.counter > RENEW_THRESHOLD) {
         LOG_INFO("\n**************************************************\n");
         LOG_INFO("* AMORTIZATION THRESHOLD REACHED (%d msgs)      *\n", RENEW_THRESHOLD);
@@ -26,13 +26,43 @@ var metrics = {
 
     // 2. Communication Cost (Bytes)
     auth_payload_bytes: 0,
+    auth_fragments: 0,
+    auth_frag_size: 0,
+    auth_transmissions: 0,
     data_payload_bytes: 0,
     data_messages_sent: 0,
     data_messages_recv: 0,
 
     // 3. Latency
     first_data_sent: 0,
-    first_data_recv: 0
+    first_data_recv: 0,
+
+    // 4. Renewal (make-before-break)
+    last_data_sent: 0,
+    max_data_gap: 0,
+    session_switches: 0,
+
+    // 5. Renewal policy (handshake load on the gateway)
+    key_updates: 0,
+    handshakes_started: 0,
+    peak_handshakes: 0,
+
+    // 6. DATA latency, split by whether the gateway was completing a handshake
+    data_sent_at: {},
+    gateway_verifying: false,
+    latency_idle_sum: 0,
+    latency_idle_max: 0,
+    latency_idle_n: 0,
+    latency_busy_sum: 0,
+    latency_busy_max: 0,
+    latency_busy_n: 0,
+
+    // 7. Boot -> first DATA the gateway accepted, per sender
+    boot_at: {},           // Time of each mote's first output line
+    first_accepted: {},
+    boot_to_data_sum: 0,
+    boot_to_data_max: 0,
+    boot_to_data_n: 0
 };
 
 function writeSummary() {
@@ -61,10 +91,24 @@ function writeSummary() {
     out.write("  - E2E Data Latency (Msg #1):" + e2e_latency.toFixed(3) + " ms\n");
     out.write("  - Total Messages Sent:      " + metrics.data_messages_sent + "\n");
     out.write("  - Total Messages Decrypted: " + metrics.data_messages_recv + "\n");
+    out.write("  - Session Switches:         " + metrics.session_switches + "\n");
+    out.write("  - Max DATA Gap:             " + (metrics.max_data_gap / 1000.0).toFixed(3) + " ms\n");
+    out.write("  - Key Updates:              " + metrics.key_updates + "\n");
+    out.write("  - Full Handshakes:          " + metrics.handshakes_started + "\n");
+    out.write("  - Peak Concurrent Handshakes:" + metrics.peak_handshakes + "\n");
+    var avg_ms = function (sum, n) { return n == 0 ? 0 : sum / n / 1000.0; };
+    out.write("  - DATA Latency (gw idle):   avg " + avg_ms(metrics.latency_idle_sum, metrics.latency_idle_n).toFixed(3) +
+        " ms, max " + (metrics.latency_idle_max / 1000.0).toFixed(3) + " ms (" + metrics.latency_idle_n + " msgs)\n");
+    out.write("  - DATA Latency (gw verify): avg " + avg_ms(metrics.latency_busy_sum, metrics.latency_busy_n).toFixed(3) +
+        " ms, max " + (metrics.latency_busy_max / 1000.0).toFixed(3) + " ms (" + metrics.latency_busy_n + " msgs)\n");
+    out.write("  - Boot -> Accepted DATA:    avg " + avg_ms(metrics.boot_to_data_sum, metrics.boot_to_data_n).toFixed(3) +
+        " ms, max " + (metrics.boot_to_data_max / 1000.0).toFixed(3) + " ms (" + metrics.boot_to_data_n + " senders)\n");
 
     // C. Communication Overhead (Matches Paper Sec 5.5.1)
     out.write("\n[C] COMMUNICATION OVERHEAD\n");
     out.write("  - Auth Payload Size:        " + metrics.auth_payload_bytes + " bytes\n");
+    out.write("  - Auth Fragment Size:       " + metrics.auth_frag_size + " bytes\n");
+    out.write("  - Auth Fragments / Sent:    " + metrics.auth_fragments + " / " + metrics.auth_transmissions + " (incl. retransmissions)\n");
     out.write("  - Data Payload Size (Avg):  " + metrics.data_payload_bytes + " bytes / msg\n");
     out.write("  - Total Bandwidth Saved:    >98% (Amortization Active)\n");
 
@@ -103,6 +147,9 @@ while (true) {
     log.log(time + ":" + id + ":" + msg + "\n");
 
     // 2. Parse Metrics based on specific string triggers
+    if (metrics.boot_at[id] === undefined) {
+        metrics.boot_at[id] = time; // Contiki prints its banner at boot
+    }
 
     // --- Computation Keygen ---
     if (msg.contains("[Phase 1] Generating Ring-LWE keys...")) {
@@ -137,6 +184,26 @@ while (true) {
         // e.g., "Total payload: 2637 bytes"
         var match = msg.match(/Total payload: (\d+) bytes/);
         if (match) metrics.auth_payload_bytes = parseInt(match[1]);
+        match = msg.match(/fragments of (\d+) bytes/);
+        if (match) metrics.auth_frag_size = parseInt(match[1]);
+    }
+
+    if (msg.contains("fragments acknowledged (")) {
+        // e.g., "All 42 fragments acknowledged (45 transmissions, SRTT 180 ms, RTO 1000 ms)"
+        var match = msg.match(/All (\d+) fragments acknowledged \((\d+) transmissions/);
+        if (match) {
+            metrics.auth_fragments = parseInt(match[1]);
+            metrics.auth_transmissions = parseInt(match[2]);
+        }
+    }
+
+    if (msg.contains("Coded transfer: k=")) {
+        // e.g., "Coded transfer: k=33, 39 sent, done at 37 (loss now 62/1000)"
+        var match = msg.match(/Coded transfer: k=(\d+), (\d+) sent/);
+        if (match) {
+            metrics.auth_fragments = parseInt(match[1]);
+            metrics.auth_transmissions = parseInt(match[2]);
+        }
     }
 
     if (msg.contains("encrypted (")) {
@@ -149,6 +216,65 @@ while (true) {
         }
     }
 
+    if (msg.contains("UDP Packet Sent")) {
+        // e.g., "  -> UDP Packet Sent with counter=7"
+        var match = msg.match(/counter=(\d+)/);
+        if (match) {
+            metrics.data_sent_at[id + ":" + match[1]] = { t: time, busy: metrics.gateway_verifying };
+        }
+        // Largest interval between consecutive DATA sends (renewal stalls)
+        if (metrics.last_data_sent != 0 && time - metrics.last_data_sent > metrics.max_data_gap) {
+            metrics.max_data_gap = time - metrics.last_data_sent;
+        }
+        metrics.last_data_sent = time;
+    }
+    if (msg.contains("[Renewal] DATA switched")) {
+        metrics.session_switches++;
+    }
+    if (msg.contains("Reassembly complete. Verifying signature...")) {
+        metrics.gateway_verifying = true;
+    }
+    if (msg.contains("[Handshake] finished")) {
+        metrics.gateway_verifying = false;
+    }
+    if (msg.contains("[Data] peer=")) {
+        // e.g., "[Data] peer=2 counter=7 decrypted"
+        var match = msg.match(/peer=(\d+) counter=(\d+)/);
+        var sent = match ? metrics.data_sent_at[match[1] + ":" + match[2]] : null;
+        if (match && !metrics.first_accepted[match[1]] && metrics.boot_at[match[1]] !== undefined) {
+            // Sender boot -> its first DATA decrypted and accepted by the gateway
+            var boot_lat = time - metrics.boot_at[match[1]];
+            metrics.first_accepted[match[1]] = true;
+            metrics.boot_to_data_sum += boot_lat;
+            metrics.boot_to_data_n++;
+            if (boot_lat > metrics.boot_to_data_max) metrics.boot_to_data_max = boot_lat;
+        }
+        if (sent) {
+            var lat = time - sent.t;
+            if (sent.busy || metrics.gateway_verifying) {
+                metrics.latency_busy_sum += lat;
+                metrics.latency_busy_n++;
+                if (lat > metrics.latency_busy_max) metrics.latency_busy_max = lat;
+            } else {
+                metrics.latency_idle_sum += lat;
+                metrics.latency_idle_n++;
+                if (lat > metrics.latency_idle_max) metrics.latency_idle_max = lat;
+            }
+            delete metrics.data_sent_at[match[1] + ":" + match[2]];
+        }
+    }
+    if (msg.contains("Key update complete")) {
+        metrics.key_updates++;
+    }
+    if (msg.contains("[Handshake] started")) {
+        // e.g., "[Handshake] started, active=2 peak=3"
+        metrics.handshakes_started++;
+        var match = msg.match(/active=(\d+)/);
+        if (match && parseInt(match[1]) > metrics.peak_handshakes) {
+            metrics.peak_handshakes = parseInt(match[1]);
+        }
+    }
+
     if (msg.contains("Decrypted:")) {
         metrics.data_messages_recv++;
         if (metrics.data_messages_recv == 1) {
@@ -9,18 +9,26 @@
 #define LOG_LEVEL LOG_LEVEL_INFO
 
 /* ========== PRNG STATE ========== */
-static uint32_t prng_state = 0x12345678;
+/* Default PRNG of the context-free API; a crypto_ctx_t carries its own */
+static THREAD_LOCAL uint32_t prng_state = 0x12345678;
+
+/* Xorshift32 step on any state word */
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
 
 void crypto_prng_init(uint32_t seed) {
     prng_state = seed;
 }
 
 uint32_t crypto_random_uint32(void) {
-    /* Xorshift32 PRNG */
-    prng_state ^= prng_state << 13;
-    prng_state ^= prng_state >> 17;
-    prng_state ^= prng_state << 5;
-    return prng_state;
+    return xorshift32(&prng_state);
 }
 
 void crypto_secure_random(uint8_t *buffer, size_t len) {
@@ -30,6 +38,21 @@ void crypto_secure_random(uint8_t *buffer, size_t len) {
     }
 }
 
+void crypto_ctx_init(crypto_ctx_t *ctx, uint32_t seed) {
+    ctx->drbg = seed ? seed : 0x12345678;
+}
+
+uint32_t crypto_ctx_random_uint32(crypto_ctx_t *ctx) {
+    return xorshift32(&ctx->drbg);
+}
+
+void crypto_ctx_random(crypto_ctx_t *ctx, uint8_t *output, size_t len) {
+    size_t i;
+    for (i = 0; i < len; i++) {
+        output[i] = (uint8_t)(xorshift32(&ctx->drbg) & 0xFF);
+    }
+}
+
 /* ========== MODULAR ARITHMETIC ========== */
 /* Modulus Q = 536870909 (2^29 - 3) */
 
@@ -108,6 +131,69 @@ void poly_mul_ntt(Poly512 *result, const Poly512 *a, const Poly512 *b) {
     poly_mul_schoolbook(result, a, b);
 }
 
+/* |s| <= 128 summed over POLY_DEGREE terms: 16 bits hold it up to n = 255 */
+#if POLY_DEGREE <= 255
+typedef int16_t small_acc_t;
+#else
+typedef int32_t small_acc_t;
+#endif
+
+/* a * s walks output coefficients k: terms with i + j = k add, terms
+ * with i + j = n + k wrap past x^n = -1 and subtract */
+void poly_mul_small(Poly512 *result, const Poly512 *a, const PolySmall *s) {
+    int i, k;
+    
+    for (k = 0; k < POLY_DEGREE; k++) {
+        int64_t acc = 0;
+        
+        for (i = 0; i <= k; i++) {
+            acc += (int64_t)a->coeff[i] * s->coeff[k - i];
+        }
+        for (; i < POLY_DEGREE; i++) {
+            acc -= (int64_t)a->coeff[i] * s->coeff[POLY_DEGREE + k - i];
+        }
+        result->coeff[k] = mod_q(acc);
+    }
+}
+
+/* Products with a binary c add one shifted copy of the other operand per
+ * set bit of c (the part shifted past x^n negated), so only set bits
+ * cost anything and the inner loops are branch-free additions */
+void poly_mul_bits(Poly512 *result, const Poly512 *a, const PolyBits *c) {
+    int64_t acc[POLY_DEGREE];
+    int i, j;
+    
+    memset(acc, 0, sizeof(acc));
+    for (i = 0; i < POLY_DEGREE; i++) {
+        if (!poly_bit(c, i)) continue;
+        for (j = 0; j < POLY_DEGREE - i; j++) acc[i + j] += a->coeff[j];
+        for (; j < POLY_DEGREE; j++) acc[i + j - POLY_DEGREE] -= a->coeff[j];
+    }
+    for (i = 0; i < POLY_DEGREE; i++) result->coeff[i] = mod_q(acc[i]);
+}
+
+void poly_mul_small_bits(Poly512 *result, const PolySmall *s, const PolyBits *c) {
+    small_acc_t acc[POLY_DEGREE];
+    int i, j;
+    
+    memset(acc, 0, sizeof(acc));
+    for (i = 0; i < POLY_DEGREE; i++) {
+        if (!poly_bit(c, i)) continue;
+        for (j = 0; j < POLY_DEGREE - i; j++) acc[i + j] += s->coeff[j];
+        for (; j < POLY_DEGREE; j++) acc[i + j - POLY_DEGREE] -= s->coeff[j];
+    }
+    for (i = 0; i < POLY_DEGREE; i++) {
+        result->coeff[i] = acc[i] < 0 ? acc[i] + MODULUS_Q : acc[i];
+    }
+}
+
+void poly_add_small(Poly512 *result, const Poly512 *a, const PolySmall *s) {
+    int i;
+    for (i = 0; i < POLY_DEGREE; i++) {
+        result->coeff[i] = mod_q((int64_t)a->coeff[i] + s->coeff[i]);
+    }
+}
+
 void poly_add(Poly512 *result, const Poly512 *a, const Poly512 *b) {
     int i;
     for (i = 0; i < POLY_DEGREE; i++) {
@@ -138,6 +224,15 @@ void poly_print(const char *label, const Poly512 *p, int num_coeffs) {
     printf("...]\n");
 }
 
+void poly_small_print(const char *label, const PolySmall *p, int num_coeffs) {
+    int i;
+    printf("%s: [", label);
+    for (i = 0; i < num_coeffs && i < 16; i++) {
+        printf("%d ", p->coeff[i]);
+    }
+    printf("...]\n");
+}
+
 /* ========== SHA-256 (Simplified) ========== */
 /* Using standard constants */
 static const uint32_t K[64] = {
@@ -161,14 +256,24 @@ static const uint32_t K[64] = {
 
 /* ========== SERIALIZATION ========== */
 
+static void serialize_poly512_coeff(uint8_t *out, int32_t val) {
+    out[0] = (val >> 24) & 0xFF;
+    out[1] = (val >> 16) & 0xFF;
+    out[2] = (val >> 8)  & 0xFF;
+    out[3] = val & 0xFF;
+}
+
 void serialize_poly512(uint8_t *out, const Poly512 *p) {
     int i;
     for(i=0; i<POLY_DEGREE; i++) {
-        int32_t val = p->coeff[i];
-        out[i*4]   = (val >> 24) & 0xFF;
-        out[i*4+1] = (val >> 16) & 0xFF;
-        out[i*4+2] = (val >> 8)  & 0xFF;
-        out[i*4+3] = val & 0xFF;
+        serialize_poly512_coeff(out + i*4, p->coeff[i]);
+    }
+}
+
+void serialize_poly_small(uint8_t *out, const PolySmall *p) {
+    int i;
+    for(i=0; i<POLY_DEGREE; i++) {
+        serialize_poly512_coeff(out + i*4, p->coeff[i]);
     }
 }
 
@@ -183,51 +288,119 @@ void deserialize_poly512(Poly512 *p, const uint8_t *in) {
     }
 }
 
-void sha256_hash(uint8_t output[32], const uint8_t *input, uint32_t len) {
-    uint32_t h[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
-    uint32_t w[64];
-    uint8_t buf[64];
-    uint32_t i, j;
+/* Wire layout of AuthMessage, in order */
+#define AUTH_WIRE_SYNDROME 1
+#define AUTH_WIRE_POLYS (AUTH_WIRE_SYNDROME + LDPC_ROWS / 8)
+#define AUTH_WIRE_POLY_BYTES (POLY_DEGREE * 4)
+#define AUTH_WIRE_COMMITMENT (AUTH_WIRE_POLYS + (RING_SIZE + 2) * AUTH_WIRE_POLY_BYTES)
+#define AUTH_WIRE_KEYWORD (AUTH_WIRE_COMMITMENT + SHA256_DIGEST_SIZE)
+
+/* Polynomial k of the wire form: pk, S[0..N-1], w */
+static const Poly512 *auth_wire_poly(const AuthMessage *msg, size_t k) {
+    if (k == 0) return &msg->public_key;
+    if (k <= RING_SIZE) return &msg->signature.S[k - 1];
+    return &msg->signature.w;
+}
+
+void auth_cursor_init(auth_cursor_t *cur, const AuthMessage *msg) {
+    cur->msg = msg;
+    cur->offset = 0;
+}
+
+void auth_cursor_seek(auth_cursor_t *cur, size_t offset) {
+    cur->offset = offset < AUTH_MSG_WIRE_LEN ? offset : AUTH_MSG_WIRE_LEN;
+}
+
+size_t auth_cursor_read(auth_cursor_t *cur, uint8_t *out, size_t len) {
+    const AuthMessage *msg = cur->msg;
+    size_t done = 0;
     
-    // Process full blocks
-    for(i=0; i + 64 <= len; i+=64) {
-        for(j=0; j<16; j++) w[j] = (input[i+4*j]<<24)|(input[i+4*j+1]<<16)|(input[i+4*j+2]<<8)|(input[i+4*j+3]);
-        for(j=16; j<64; j++) w[j] = sigma1(w[j-2]) + w[j-7] + sigma0(w[j-15]) + w[j-16];
-        uint32_t temp_h[8]; memcpy(temp_h, h, 32);
-        for(j=0; j<64; j++) {
-            uint32_t t1 = temp_h[7] + SIG1(temp_h[4]) + CH(temp_h[4], temp_h[5], temp_h[6]) + K[j] + w[j];
-            uint32_t t2 = SIG0(temp_h[0]) + MAJ(temp_h[0], temp_h[1], temp_h[2]);
-            temp_h[7]=temp_h[6]; temp_h[6]=temp_h[5]; temp_h[5]=temp_h[4]; temp_h[4]=temp_h[3]+t1;
-            temp_h[3]=temp_h[2]; temp_h[2]=temp_h[1]; temp_h[1]=temp_h[0]; temp_h[0]=t1+t2;
-        }
-        for(j=0; j<8; j++) h[j] += temp_h[j];
+    if (len > AUTH_MSG_WIRE_LEN - cur->offset) {
+        len = AUTH_MSG_WIRE_LEN - cur->offset;
     }
     
-    // Padding
-    memset(buf, 0, 64);
-    memcpy(buf, input+i, len-i);
-    buf[len-i] = 0x80;
-    if(len-i >= 56) {
-        // Process this block and create another
-        for(j=0; j<16; j++) w[j] = (buf[4*j]<<24)|(buf[4*j+1]<<16)|(buf[4*j+2]<<8)|(buf[4*j+3]);
-        for(j=16; j<64; j++) w[j] = sigma1(w[j-2]) + w[j-7] + sigma0(w[j-15]) + w[j-16];
-        uint32_t temp_h[8]; memcpy(temp_h, h, 32);
-        for(j=0; j<64; j++) {
-            uint32_t t1 = temp_h[7] + SIG1(temp_h[4]) + CH(temp_h[4], temp_h[5], temp_h[6]) + K[j] + w[j];
-            uint32_t t2 = SIG0(temp_h[0]) + MAJ(temp_h[0], temp_h[1], temp_h[2]);
-            temp_h[7]=temp_h[6]; temp_h[6]=temp_h[5]; temp_h[5]=temp_h[4]; temp_h[4]=temp_h[3]+t1;
-            temp_h[3]=temp_h[2]; temp_h[2]=temp_h[1]; temp_h[1]=temp_h[0]; temp_h[0]=t1+t2;
+    while (done < len) {
+        size_t off = cur->offset;
+        size_t n;
+        
+        if (off < AUTH_WIRE_SYNDROME) {
+            out[done] = msg->type;
+            n = 1;
+        } else if (off < AUTH_WIRE_POLYS) {
+            n = AUTH_WIRE_POLYS - off;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, msg->syndrome + (off - AUTH_WIRE_SYNDROME), n);
+        } else if (off < AUTH_WIRE_COMMITMENT) {
+            /* One coefficient (or the rest of it) per step, big-endian */
+            size_t rel = off - AUTH_WIRE_POLYS;
+            const Poly512 *p = auth_wire_poly(msg, rel / AUTH_WIRE_POLY_BYTES);
+            uint32_t val = (uint32_t)p->coeff[(rel % AUTH_WIRE_POLY_BYTES) / 4];
+            size_t b = rel % 4;
+            
+            n = 0;
+            while (b < 4 && done + n < len) {
+                out[done + n++] = (uint8_t)(val >> (24 - 8 * b));
+                b++;
+            }
+        } else if (off < AUTH_WIRE_KEYWORD) {
+            n = AUTH_WIRE_KEYWORD - off;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, msg->signature.commitment + (off - AUTH_WIRE_COMMITMENT), n);
+        } else {
+            n = AUTH_MSG_WIRE_LEN - off;
+            if (n > len - done) n = len - done;
+            memcpy(out + done, msg->signature.keyword + (off - AUTH_WIRE_KEYWORD), n);
         }
-        for(j=0; j<8; j++) h[j] += temp_h[j];
-        memset(buf, 0, 64);
+        
+        done += n;
+        cur->offset += n;
     }
-    // Append length
-    uint64_t bits = (uint64_t)len * 8;
-    buf[56] = (bits>>56)&0xFF; buf[57] = (bits>>48)&0xFF; buf[58] = (bits>>40)&0xFF; buf[59] = (bits>>32)&0xFF;
-    buf[60] = (bits>>24)&0xFF; buf[61] = (bits>>16)&0xFF; buf[62] = (bits>>8)&0xFF; buf[63] = bits&0xFF;
-    for(j=0; j<16; j++) w[j] = (buf[4*j]<<24)|(buf[4*j+1]<<16)|(buf[4*j+2]<<8)|(buf[4*j+3]);
+    return done;
+}
+
+int auth_msg_view(AuthMessageView *view, const uint8_t *wire, size_t len) {
+    const uint8_t *p = wire;
+    int i;
+    
+    if (len != AUTH_MSG_WIRE_LEN) return -1;
+    
+    view->type = *p++;
+    view->syndrome = p;
+    p += LDPC_ROWS / 8;
+    view->public_key.poly = NULL;
+    view->public_key.wire = p;
+    p += POLY_DEGREE * 4;
+    for (i = 0; i < RING_SIZE; i++) {
+        view->signature.S[i].poly = NULL;
+        view->signature.S[i].wire = p;
+        p += POLY_DEGREE * 4;
+    }
+    view->signature.w.poly = NULL;
+    view->signature.w.wire = p;
+    p += POLY_DEGREE * 4;
+    view->signature.commitment = p;
+    p += SHA256_DIGEST_SIZE;
+    view->signature.keyword = p;
+    return 0;
+}
+
+void poly_view_print(const char *label, const PolyView *v, int num_coeffs) {
+    int i;
+    printf("%s: [", label);
+    for (i = 0; i < num_coeffs && i < 16; i++) {
+        printf("%ld ", (long)poly_view_coeff(v, i));
+    }
+    printf("...]\n");
+}
+
+static void sha256_block(uint32_t h[8], const uint8_t *block) {
+    uint32_t w[64];
+    uint32_t temp_h[8];
+    uint32_t j;
+    
+    for(j=0; j<16; j++) w[j] = ((uint32_t)block[4*j]<<24)|((uint32_t)block[4*j+1]<<16)|((uint32_t)block[4*j+2]<<8)|(block[4*j+3]);
     for(j=16; j<64; j++) w[j] = sigma1(w[j-2]) + w[j-7] + sigma0(w[j-15]) + w[j-16];
-    uint32_t temp_h[8]; memcpy(temp_h, h, 32);
+    memcpy(temp_h, h, 32);
     for(j=0; j<64; j++) {
         uint32_t t1 = temp_h[7] + SIG1(temp_h[4]) + CH(temp_h[4], temp_h[5], temp_h[6]) + K[j] + w[j];
         uint32_t t2 = SIG0(temp_h[0]) + MAJ(temp_h[0], temp_h[1], temp_h[2]);
@@ -235,16 +408,99 @@ void sha256_hash(uint8_t output[32], const uint8_t *input, uint32_t len) {
         temp_h[3]=temp_h[2]; temp_h[2]=temp_h[1]; temp_h[1]=temp_h[0]; temp_h[0]=t1+t2;
     }
     for(j=0; j<8; j++) h[j] += temp_h[j];
+}
+
+void sha256_init(sha256_ctx_t *ctx) {
+    static const uint32_t iv[8] = {0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    memcpy(ctx->h, iv, sizeof(iv));
+    ctx->buf_len = 0;
+    ctx->total = 0;
+}
+
+void sha256_update(sha256_ctx_t *ctx, const uint8_t *input, uint32_t len) {
+    ctx->total += len;
+    
+    // Top up a partial block first
+    if (ctx->buf_len > 0) {
+        uint32_t n = 64 - ctx->buf_len;
+        if (n > len) n = len;
+        memcpy(ctx->buf + ctx->buf_len, input, n);
+        ctx->buf_len += n;
+        input += n;
+        len -= n;
+        if (ctx->buf_len < 64) return;
+        sha256_block(ctx->h, ctx->buf);
+        ctx->buf_len = 0;
+    }
+    
+    // Process full blocks in place
+    while (len >= 64) {
+        sha256_block(ctx->h, input);
+        input += 64;
+        len -= 64;
+    }
+    
+    memcpy(ctx->buf, input, len);
+    ctx->buf_len = len;
+}
+
+void sha256_final(sha256_ctx_t *ctx, uint8_t output[32]) {
+    uint64_t bits = ctx->total * 8;
+    uint32_t j;
+    
+    // Padding
+    ctx->buf[ctx->buf_len++] = 0x80;
+    if (ctx->buf_len > 56) {
+        memset(ctx->buf + ctx->buf_len, 0, 64 - ctx->buf_len);
+        sha256_block(ctx->h, ctx->buf);
+        ctx->buf_len = 0;
+    }
+    memset(ctx->buf + ctx->buf_len, 0, 56 - ctx->buf_len);
+    // Append length
+    for(j=0; j<8; j++) ctx->buf[56 + j] = (bits >> (56 - 8*j)) & 0xFF;
+    sha256_block(ctx->h, ctx->buf);
     
     for(j=0; j<8; j++) {
-        output[4*j] = (h[j]>>24)&0xFF; output[4*j+1] = (h[j]>>16)&0xFF; output[4*j+2] = (h[j]>>8)&0xFF; output[4*j+3] = h[j]&0xFF;
+        output[4*j] = (ctx->h[j]>>24)&0xFF; output[4*j+1] = (ctx->h[j]>>16)&0xFF; output[4*j+2] = (ctx->h[j]>>8)&0xFF; output[4*j+3] = ctx->h[j]&0xFF;
     }
 }
 
+void sha256_hash(uint8_t output[32], const uint8_t *input, uint32_t len) {
+    sha256_ctx_t ctx;
+    
+    sha256_init(&ctx);
+    sha256_update(&ctx, input, len);
+    sha256_final(&ctx, output);
+}
+
 /* ========== HELPERS ========== */
+static int32_t noise_sample(uint32_t *drbg) {
+    return (int32_t)(xorshift32(drbg) % (200)) - 100; // Simplified small noise
+}
+
 int32_t gaussian_sample(int sigma) {
-    int32_t u1 = (int32_t)(crypto_random_uint32() % (200)) - 100; // Simplified small noise
-    return u1;
+    return noise_sample(&prng_state);
+}
+
+/* Shared system parameter 'a' from its fixed seed, on a private PRNG
+ * state (nobody's generator is borrowed and restored). The core reads
+ * ring_a_table instead; this is the generator the table is checked against. */
+void ring_expand_a(Poly512 *a) {
+    uint32_t state = RING_A_SEED;
+    int i;
+    
+    for (i = 0; i < POLY_DEGREE; i++) a->coeff[i] = xorshift32(&state) % MODULUS_Q;
+}
+
+/* Challenge c from H(w_approx || keyword): coefficient i is bit i%8 of
+ * hash byte i%32 */
+static void expand_challenge(PolyBits *c, const uint8_t c_hash[SHA256_DIGEST_SIZE]) {
+    int i;
+    
+    memset(c->bits, 0, sizeof(c->bits));
+    for (i = 0; i < POLY_DEGREE; i++) {
+        c->bits[i >> 3] |= ((c_hash[i % 32] >> (i % 8)) & 1) << (i & 7);
+    }
 }
 
 uint32_t poly_norm(const Poly512 *a) {
@@ -260,128 +516,120 @@ void generate_ring_member_key(Poly512 *public_key, int member_index) {
     int i;
     /* Use deterministic generation based on member index */
     /* This simulates retrieving a public key from a directory/PKI */
-    uint32_t seed = 0x12345678 + (member_index * 0xABCDEF);
-    uint32_t old_state = prng_state;
-    
-    crypto_prng_init(seed);
+    uint32_t state = RING_MEMBER_SEED(member_index);
     
     /* Generate random-looking polynomial */
     /* In real LWE, this would be t = a*s + e. */
     /* For FAKE members, we just generate uniform random 't' */
     /* This is indistinguishable from real 't' (LWE assumption) */
     for (i = 0; i < POLY_DEGREE; i++) {
-        public_key->coeff[i] = crypto_random_uint32() % MODULUS_Q;
+        public_key->coeff[i] = xorshift32(&state) % MODULUS_Q;
     }
-    
-    crypto_prng_init(old_state);
 }
 
-int ring_lwe_keygen(RingLWEKeyPair *keypair) {
+static int keygen_run(uint32_t *drbg, crypto_keygen_ws_t *ws, RingLWEKeyPair *keypair) {
     int i;
-    Poly512 a, s, e;
-    
-    uint32_t a_seed = 0xDEADBEEF;
-    uint32_t old_state = prng_state; /* Simulate shared system parameter 'a' */
-    crypto_prng_init(a_seed);
-    for(i=0; i<POLY_DEGREE; i++) a.coeff[i] = crypto_random_uint32() % MODULUS_Q;
-    crypto_prng_init(old_state);
     
     /* Sample secret s, error e */
     for(i=0; i<POLY_DEGREE; i++) {
-        s.coeff[i] = gaussian_sample(STD_DEVIATION);
-        e.coeff[i] = gaussian_sample(STD_DEVIATION);
+        ws->s.coeff[i] = noise_sample(drbg);
+        ws->e.coeff[i] = noise_sample(drbg);
     }
     
     /* t = a*s + e */
-    Poly512 as;
-    poly_mul_schoolbook(&as, &a, &s);
-    poly_add(&keypair->public, &as, &e); // Public key = t
+    poly_mul_small(&ws->as, &ring_a_table, &ws->s);
+    poly_add_small(&keypair->public, &ws->as, &ws->e); // Public key = t
     
-    keypair->secret = s;
-    keypair->random = a; // Store 'a' for convenience
+    keypair->secret = ws->s;
+    secure_zero(ws, sizeof(*ws));
     
     return 0;
 }
 
+int ring_lwe_keygen(RingLWEKeyPair *keypair) {
+    crypto_keygen_ws_t ws;
+    
+    return keygen_run(&prng_state, &ws, keypair);
+}
+
+int crypto_ring_lwe_keygen(crypto_ctx_t *ctx, RingLWEKeyPair *keypair) {
+    return keygen_run(&ctx->drbg, &ctx->ws.keygen, keypair);
+}
+
 /* ========== RING COMPONENT HELPERS ========== */
 
 /* Helper to get High Bits (approximation) of w */
-static void get_high_bits(Poly512 *out, const Poly512 *in) {
+static void get_high_bits(PolyHigh *out, const Poly512 *in) {
     int i;
     for (i = 0; i < POLY_DEGREE; i++) {
         /* Keep top 16 bits (shift by 13 for 29-bit modulus? Modulus is 29 bits.
            Shift 13 keeps 16 bits. */
-        out->coeff[i] = (in->coeff[i] >> 13);
+        out->coeff[i] = (uint16_t)(in->coeff[i] >> 13);
     }
 }
 
-int ring_sign(RingSignature *sig, const uint8_t *keyword,
-              const RingLWEKeyPair *signer_keypair,
-              const Poly512 ring_pubkeys[RING_SIZE],
-              int signer_index) {
+static int sign_run(uint32_t *drbg, crypto_sign_ws_t *ws, RingSignature *sig,
+                    const uint8_t *keyword, const RingLWEKeyPair *signer_keypair,
+                    int signer_index) {
     int i, j, attempt;
-    Poly512 y, w, sc, z, w_approx, tc, w_check;
     uint8_t c_hash[SHA256_DIGEST_SIZE];
-    Poly512 challenge;
-    uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
     
     /* Rejection Sampling */
     for(attempt = 0; attempt < 500; attempt++) {
         /* 1. Sample y (make it slightly larger to hide s*c) */
         /* Range: +/- 100000. s*c is ~2000. Masking is OK. */
         for(i=0; i<POLY_DEGREE; i++) {
-             y.coeff[i] = (int32_t)(crypto_random_uint32() % 200000) - 100000;
+             ws->y.coeff[i] = (int32_t)(xorshift32(drbg) % 200000) - 100000;
         }
         
         /* 2. w = a*y */
-        poly_mul_schoolbook(&w, &signer_keypair->random, &y);
+        poly_mul_schoolbook(&ws->w, &ring_a_table, &ws->y);
         
         /* 3. Get High Bits of w */
-        get_high_bits(&w_approx, &w);
+        get_high_bits(&ws->w_approx, &ws->w);
         
         /* 4. c = H(w_approx, keyword) */
         /* Serialize w_approx */
         for(i=0; i<POLY_DEGREE; i++) {
-             int32_t v = w_approx.coeff[i];
-             hash_input[i*4] = (v >> 24) & 0xFF;
-             hash_input[i*4+1] = (v >> 16) & 0xFF;
-             hash_input[i*4+2] = (v >> 8) & 0xFF;
-             hash_input[i*4+3] = v & 0xFF;
+             int32_t v = ws->w_approx.coeff[i];
+             ws->hash_input[i*4] = (v >> 24) & 0xFF;
+             ws->hash_input[i*4+1] = (v >> 16) & 0xFF;
+             ws->hash_input[i*4+2] = (v >> 8) & 0xFF;
+             ws->hash_input[i*4+3] = v & 0xFF;
         }
-        memcpy(hash_input + POLY_DEGREE*4, keyword, KEYWORD_SIZE);
-        sha256_hash(c_hash, hash_input, POLY_DEGREE*4 + KEYWORD_SIZE);
+        memcpy(ws->hash_input + POLY_DEGREE*4, keyword, KEYWORD_SIZE);
+        sha256_hash(c_hash, ws->hash_input, POLY_DEGREE*4 + KEYWORD_SIZE);
         
         /* Expand c */
-        for(i=0; i<POLY_DEGREE; i++) challenge.coeff[i] = (c_hash[i%32] >> (i%8)) & 1;
+        expand_challenge(&ws->challenge, c_hash);
         
         /* 5. z = y + s*c */
-        poly_mul_schoolbook(&sc, &signer_keypair->secret, &challenge);
-        poly_add(&z, &y, &sc);
+        poly_mul_small_bits(&ws->sc, &signer_keypair->secret, &ws->challenge);
+        poly_add(&ws->z, &ws->y, &ws->sc);
         
         /* 6. Bounds Check on z (Security) */
         int bound_ok = 1;
         for(i=0; i<POLY_DEGREE; i++) {
-            int32_t val = z.coeff[i];
+            int32_t val = ws->z.coeff[i];
             if (val > MODULUS_Q/2) val -= MODULUS_Q;
-            if (abs(val) > 120000) bound_ok = 0; // Approx bound
+            if (abs(val) > RING_Z_BOUND) bound_ok = 0; // Approx bound
         }
         if (!bound_ok) continue;
         
         /* 7. Correctness Check (Verify w_approx consistency) */
         /* w' = a*z - t*c */
-        poly_mul_schoolbook(&tc, &signer_keypair->public, &challenge);
-        poly_mul_schoolbook(&w_check, &signer_keypair->random, &z);
-        poly_sub(&w_check, &w_check, &tc);
+        poly_mul_bits(&ws->tc, &signer_keypair->public, &ws->challenge);
+        poly_mul_schoolbook(&ws->w_check, &ring_a_table, &ws->z);
+        poly_sub(&ws->w_check, &ws->w_check, &ws->tc);
         
-        Poly512 w_check_approx;
-        get_high_bits(&w_check_approx, &w_check);
+        get_high_bits(&ws->w_check_approx, &ws->w_check);
         
         /* Check diff <= 1 dealing with modular wrap */
         int consistent = 1;
         int32_t MAX_HIGH = (MODULUS_Q - 1) >> 13;
         
         for(i=0; i<POLY_DEGREE; i++) {
-            int32_t diff = w_approx.coeff[i] - w_check_approx.coeff[i];
+            int32_t diff = ws->w_approx.coeff[i] - ws->w_check_approx.coeff[i];
             /* Handle wrap around */
             if (diff > MAX_HIGH/2) diff -= (MAX_HIGH + 1);
             if (diff < -MAX_HIGH/2) diff += (MAX_HIGH + 1);
@@ -394,8 +642,9 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
         
         if (consistent) {
             /* Success */
-            sig->S[signer_index] = z;
-            sig->w = w_approx; /* Store approximate w */
+            sig->S[signer_index] = ws->z;
+            /* Store approximate w */
+            for(j=0; j<POLY_DEGREE; j++) sig->w.coeff[j] = ws->w_approx.coeff[j];
             memcpy(sig->commitment, c_hash, SHA256_DIGEST_SIZE);
             memcpy(sig->keyword, keyword, KEYWORD_SIZE);
             
@@ -405,85 +654,371 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
                      for(j=0; j<POLY_DEGREE; j++) sig->S[i].coeff[j] = 0;
                 }
             }
+            secure_zero(ws, sizeof(*ws));
             return 0;
         }
         watchdog_periodic();
     }
     
+    secure_zero(ws, sizeof(*ws));
     return -1;
 }
 
-int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE]) {
-    int i, j;
-    Poly512 a, z, tc, w_prime, challenge;
-    Poly512 w_expected = sig->w; /* The w_approx from signer */
+int ring_sign(RingSignature *sig, const uint8_t *keyword,
+              const RingLWEKeyPair *signer_keypair,
+              const PolyView ring_pubkeys[RING_SIZE],
+              int signer_index) {
+    crypto_sign_ws_t ws;
+    
+    return sign_run(&prng_state, &ws, sig, keyword, signer_keypair, signer_index);
+}
+
+int crypto_ring_sign(crypto_ctx_t *ctx, RingSignature *sig, const uint8_t *keyword,
+                     const RingLWEKeyPair *signer_keypair,
+                     const PolyView ring_pubkeys[RING_SIZE], int signer_index) {
+    return sign_run(&ctx->drbg, &ctx->ws.sign, sig, keyword, signer_keypair, signer_index);
+}
+
+/* ========== INCREMENTAL VERIFICATION ========== */
+
+enum {
+    VERIFY_STAGE_MEMBER,                   // Pick the next ring member
+    VERIFY_STAGE_AZ,                       // Accumulate a*z, a slice of rows at a time
+    VERIFY_STAGE_TC,                       // Subtract t*c (needs the challenge)
+    VERIFY_STAGE_CHECK,                    // Compare high bits with the transmitted w
+    VERIFY_STAGE_BLOCK,                    // a*z - t*c and the high-bits check, blockwise
+    VERIFY_STAGE_DONE
+};
+
+/* Centred representative of a coefficient mod q */
+static inline int32_t centre_q(int32_t v) {
+    v = mod_q(v);
+    return v > MODULUS_Q / 2 ? v - MODULUS_Q : v;
+}
+
+/* High bits of w' within 4 of the transmitted w_approx (with wrap) */
+static int verify_high_bits_ok(int32_t w_prime, int32_t w_high) {
+    int32_t MAX_HIGH = (MODULUS_Q - 1) >> 13;
+    int32_t diff = (w_prime >> 13) - w_high;
+    
+    if (diff > MAX_HIGH/2) diff -= (MAX_HIGH + 1);
+    if (diff < -MAX_HIGH/2) diff += (MAX_HIGH + 1);
+    return abs(diff) <= 4;
+}
+
+/* Wire bytes [p, p + n) present? Host data always is */
+static int verify_bytes_ready(const ring_verify_ctx_t *ctx, const uint8_t *p, size_t n) {
+    return ctx->avail_end == NULL || p + n <= ctx->avail_end;
+}
+
+static int verify_coeff_ready(const ring_verify_ctx_t *ctx, const PolyView *v, int i) {
+    return v->poly != NULL || verify_bytes_ready(ctx, v->wire + 4 * i, 4);
+}
+
+/* Extend the infinity-norm check of z over the coefficients present
+ * @returns 0, or -1 if one is over RING_Z_BOUND */
+static int verify_z_norm(ring_verify_ctx_t *ctx, const PolyView *z) {
+    while (ctx->normed < POLY_DEGREE && verify_coeff_ready(ctx, z, ctx->normed)) {
+        int32_t v = centre_q(poly_view_coeff(z, ctx->normed));
+        
+        if (v > RING_Z_BOUND || v < -RING_Z_BOUND) return -1;
+        if (v != 0) ctx->z_nonzero = 1;
+        ctx->normed++;
+    }
+    return 0;
+}
+
+/* Feed whatever of w has arrived to the hash; once the keyword (last on
+ * the wire) is there too, finish it and expand the challenge.
+ * @returns 0, or -1 if the commitment does not match */
+static int verify_hash_progress(ring_verify_ctx_t *ctx) {
+    const PolyView *w = &ctx->sig.w;
     uint8_t c_hash[SHA256_DIGEST_SIZE];
-    uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
+    int i;
     
-    /* 1. Reconstruct 'a' */
-    uint32_t a_seed = 0xDEADBEEF;
-    uint32_t old_state = prng_state;
-    crypto_prng_init(a_seed);
-    for(i=0; i<POLY_DEGREE; i++) a.coeff[i] = crypto_random_uint32() % MODULUS_Q;
-    crypto_prng_init(old_state);
+    if (ctx->have_challenge) return 0;
     
-    /* 2. Verify 'c' matches 'w_approx' */
-    for(i=0; i<POLY_DEGREE; i++) {
-         int32_t v = w_expected.coeff[i];
-         hash_input[i*4] = (v >> 24) & 0xFF;
-         hash_input[i*4+1] = (v >> 16) & 0xFF;
-         hash_input[i*4+2] = (v >> 8) & 0xFF;
-         hash_input[i*4+3] = v & 0xFF;
+    if (w->poly != NULL) {
+        uint8_t word[4];
+        for (i = ctx->hashed / 4; i < POLY_DEGREE; i++) {
+            serialize_poly512_coeff(word, w->poly->coeff[i]);
+            sha256_update(&ctx->hash, word, 4);
+        }
+        ctx->hashed = POLY_DEGREE * 4;
+    } else if (ctx->hashed < POLY_DEGREE * 4) {
+        uint16_t n = POLY_DEGREE * 4 - ctx->hashed;
+        if (ctx->avail_end != NULL) {
+            const uint8_t *from = w->wire + ctx->hashed;
+            if (ctx->avail_end <= from) return 0;
+            if ((size_t)(ctx->avail_end - from) < n) n = ctx->avail_end - from;
+        }
+        sha256_update(&ctx->hash, w->wire + ctx->hashed, n);
+        ctx->hashed += n;
+    }
+    
+    if (ctx->hashed < POLY_DEGREE * 4 ||
+        !verify_bytes_ready(ctx, ctx->sig.keyword, KEYWORD_SIZE) ||
+        !verify_bytes_ready(ctx, ctx->sig.commitment, SHA256_DIGEST_SIZE)) {
+        return 0;
     }
-    memcpy(hash_input + POLY_DEGREE*4, sig->keyword, KEYWORD_SIZE);
-    sha256_hash(c_hash, hash_input, POLY_DEGREE*4 + KEYWORD_SIZE);
     
-    if (memcmp(c_hash, sig->commitment, SHA256_DIGEST_SIZE) != 0) {
-        return 0; // Commitment check failed
+    sha256_update(&ctx->hash, ctx->sig.keyword, KEYWORD_SIZE);
+    sha256_final(&ctx->hash, c_hash);
+    
+    if (memcmp(c_hash, ctx->sig.commitment, SHA256_DIGEST_SIZE) != 0) {
+        return -1; // Commitment check failed
     }
     
     /* Reconstruct challenge c */
-    for(i=0; i<POLY_DEGREE; i++) challenge.coeff[i] = (c_hash[i%32] >> (i%8)) & 1;
+    expand_challenge(&ctx->challenge, c_hash);
+    ctx->have_challenge = 1;
+    return 0;
+}
+
+void ring_verify_pipe_start(ring_verify_ctx_t *ctx, const RingSignatureView *sig,
+                            const PolyView public_keys[RING_SIZE],
+                            const uint8_t *avail_end) {
+    ctx->sig = *sig;
+    memcpy(ctx->public_keys, public_keys, sizeof(ctx->public_keys));
+    ctx->avail_end = avail_end;
+    ctx->member = 0;
+    ctx->row = 0;
+    ctx->hashed = 0;
+    ctx->have_challenge = 0;
+    ctx->result = 0;
+    
+    /* c = H(w_approx || keyword), fed as the bytes arrive; 'a' is read
+     * from ring_a_table, so there is nothing to expand */
+    sha256_init(&ctx->hash);
     
-    /* 3. Check each member for signature validity */
-    for(i=0; i<RING_SIZE; i++) {
-        z = sig->S[i];
+    ctx->stage = VERIFY_STAGE_MEMBER;
+}
+
+void ring_verify_pipe_avail(ring_verify_ctx_t *ctx, const uint8_t *avail_end) {
+    ctx->avail_end = avail_end;
+}
+
+int ring_verify_view_start(ring_verify_ctx_t *ctx, const RingSignatureView *sig,
+                           const PolyView public_keys[RING_SIZE]) {
+    ring_verify_pipe_start(ctx, sig, public_keys, NULL);
+    
+    /* Everything is here: the commitment check can fail right away */
+    if (verify_hash_progress(ctx) != 0) {
+        ctx->stage = VERIFY_STAGE_DONE;
+        return 0;
+    }
+    return RING_VERIFY_PENDING;
+}
+
+int ring_verify_start(ring_verify_ctx_t *ctx, const RingSignature *sig,
+                      const Poly512 public_keys[RING_SIZE]) {
+    RingSignatureView view;
+    PolyView keys[RING_SIZE];
+    int i;
+    
+    for (i = 0; i < RING_SIZE; i++) {
+        view.S[i] = poly_view(&sig->S[i]);
+        keys[i] = poly_view(&public_keys[i]);
+    }
+    view.w = poly_view(&sig->w);
+    view.commitment = sig->commitment;
+    view.keyword = sig->keyword;
+    return ring_verify_view_start(ctx, &view, keys);
+}
+
+int ring_verify_step(ring_verify_ctx_t *ctx) {
+    const PolyView *z;
+    const PolyView *t;
+    int i, j, end;
+    
+    if (ctx->stage != VERIFY_STAGE_DONE && verify_hash_progress(ctx) != 0) {
+        ctx->stage = VERIFY_STAGE_DONE;
+        ctx->result = 0;
+    }
+    
+    switch (ctx->stage) {
+    case VERIFY_STAGE_MEMBER:
+        /* 3. Check each member for signature validity */
+        if (ctx->member >= RING_SIZE) {
+            ctx->stage = VERIFY_STAGE_DONE;
+            return ctx->result; // No valid signature found
+        }
+        z = &ctx->sig.S[ctx->member];
+        t = &ctx->public_keys[ctx->member];
+        ctx->row = 0;
+        ctx->normed = 0;
+        ctx->z_nonzero = 0;
         
-        /* Skip if z is all zeros (optimization for fake members) */
-        int non_zero = 0;
-        for(j=0; j<POLY_DEGREE; j++) if(z.coeff[j] != 0) non_zero = 1;
-        if (!non_zero) continue; 
+        if (!ctx->have_challenge ||
+            !verify_coeff_ready(ctx, z, POLY_DEGREE - 1) ||
+            !verify_coeff_ready(ctx, t, POLY_DEGREE - 1)) {
+            /* Still arriving: accumulate a*z row by row as z comes in */
+            memset(ctx->acc, 0, sizeof(ctx->acc));
+            ctx->stage = VERIFY_STAGE_AZ;
+            return RING_VERIFY_PENDING;
+        }
         
-        /* w' = a*z - t*c */
-        poly_mul_schoolbook(&w_prime, &a, &z);
-        poly_mul_schoolbook(&tc, &public_keys[i], &challenge);
-        poly_sub(&w_prime, &w_prime, &tc);
+        /* Cheap pre-filter: z over the signer's bound, or all zero (a
+         * fake member), is rejected before any multiply */
+        if (verify_z_norm(ctx, z) != 0 || !ctx->z_nonzero) {
+            ctx->member++;
+            return RING_VERIFY_PENDING;
+        }
+        for (i = 0; i < POLY_DEGREE; i++) {
+            ctx->acc[i] = centre_q(poly_view_coeff(z, i));
+            ctx->acc[POLY_DEGREE + i] = poly_view_coeff(t, i);
+        }
+        ctx->stage = VERIFY_STAGE_BLOCK;
+        return RING_VERIFY_PENDING;
         
-        Poly512 w_prime_approx;
-        get_high_bits(&w_prime_approx, &w_prime);
+    case VERIFY_STAGE_AZ:
+        /* a*z, row i pairing z[i] with all of a: rows proceed as z arrives
+         * and passes the norm check. Zero rows cost nothing, so all-zero
+         * (fake) members are skipped for free */
+        z = &ctx->sig.S[ctx->member];
+        if (verify_z_norm(ctx, z) != 0) {
+            ctx->member++;
+            ctx->stage = VERIFY_STAGE_MEMBER;
+            return RING_VERIFY_PENDING;
+        }
+        end = ctx->row + RING_VERIFY_SLICE_ROWS;
+        if (end > ctx->normed) end = ctx->normed;
         
-        /* Check consistency with transmitted w_approx */
-        int consistent = 1;
-        int32_t MAX_HIGH = (MODULUS_Q - 1) >> 13;
+        for (i = ctx->row; i < end; i++) {
+            int32_t zi = poly_view_coeff(z, i);
+            
+            if (zi == 0) continue;
+            for (j = 0; j < POLY_DEGREE; j++) {
+                ctx->acc[i+j] = mod_q(ctx->acc[i+j] + (int64_t)ring_a_table.coeff[j] * zi);
+            }
+        }
+        if (i == ctx->row) {
+            return RING_VERIFY_STALLED;
+        }
+        ctx->row = i;
+        if (ctx->row == POLY_DEGREE) {
+            if (ctx->z_nonzero) {
+                ctx->row = 0;
+                ctx->stage = VERIFY_STAGE_TC;
+            } else {
+                ctx->member++;
+                ctx->stage = VERIFY_STAGE_MEMBER;
+            }
+        }
+        return RING_VERIFY_PENDING;
         
-        for(j=0; j<POLY_DEGREE; j++) {
-            int32_t diff = w_prime_approx.coeff[j] - w_expected.coeff[j];
-            /* Handle wrap around */
-            if (diff > MAX_HIGH/2) diff -= (MAX_HIGH + 1);
-            if (diff < -MAX_HIGH/2) diff += (MAX_HIGH + 1);
+    case VERIFY_STAGE_TC:
+        /* - t*c, row i pairing t[i] with all of c (binary: additions only) */
+        if (!ctx->have_challenge) {
+            return RING_VERIFY_STALLED;
+        }
+        t = &ctx->public_keys[ctx->member];
+        end = ctx->row + RING_VERIFY_SLICE_ROWS;
+        if (end > POLY_DEGREE) end = POLY_DEGREE;
+        
+        for (i = ctx->row; i < end; i++) {
+            int32_t ti;
             
-            if (abs(diff) > 4) {
-                consistent = 0;
+            if (!verify_coeff_ready(ctx, t, i)) break;
+            ti = poly_view_coeff(t, i);
+            for (j = 0; j < POLY_DEGREE; j++) {
+                if (poly_bit(&ctx->challenge, j)) {
+                    ctx->acc[i+j] = mod_q((int64_t)ctx->acc[i+j] - ti);
+                }
+            }
+        }
+        if (i == ctx->row) {
+            return RING_VERIFY_STALLED;
+        }
+        ctx->row = i;
+        if (ctx->row == POLY_DEGREE) {
+            ctx->stage = VERIFY_STAGE_CHECK;
+        }
+        return RING_VERIFY_PENDING;
+        
+    case VERIFY_STAGE_CHECK:
+        /* Reduce mod x^n + 1 and check consistency with transmitted w_approx
+         * (all of w is present: the challenge depended on it) */
+        for(j=0; j<POLY_DEGREE; j++) {
+            int32_t w_prime = mod_q((int64_t)ctx->acc[j] - (int64_t)ctx->acc[POLY_DEGREE + j]);
+            if (!verify_high_bits_ok(w_prime, poly_view_coeff(&ctx->sig.w, j))) {
                 break;
             }
         }
         
-        if (consistent) {
+        if (j == POLY_DEGREE) {
+            ctx->result = 1;
+            ctx->stage = VERIFY_STAGE_DONE;
             return 1; // Valid signature found!
         }
+        ctx->member++;
+        ctx->stage = VERIFY_STAGE_MEMBER;
+        return RING_VERIFY_PENDING;
+    
+    case VERIFY_STAGE_BLOCK: {
+        /* 4. w'[k] = (a*z - t*c)[k] for a block of k, reduced mod x^n + 1
+         * as it goes (terms wrapping past x^n change sign). The member is
+         * dropped at the first coefficient whose high bits miss w, so a
+         * forgery costs about one block instead of two full products */
+        const int32_t *zc = ctx->acc;
+        const int32_t *tc = ctx->acc + POLY_DEGREE;
+        
+        end = ctx->row + RING_VERIFY_BLOCK;
+        if (end > POLY_DEGREE) end = POLY_DEGREE;
+        
+        for (j = ctx->row; j < end; j++) {
+            int64_t w_prime = 0;
+            
+            for (i = 0; i <= j; i++) {
+                w_prime += (int64_t)ring_a_table.coeff[i] * zc[j - i];
+                if (poly_bit(&ctx->challenge, j - i)) w_prime -= tc[i];
+            }
+            for (; i < POLY_DEGREE; i++) {
+                w_prime -= (int64_t)ring_a_table.coeff[i] * zc[POLY_DEGREE + j - i];
+                if (poly_bit(&ctx->challenge, POLY_DEGREE + j - i)) w_prime += tc[i];
+            }
+            if (!verify_high_bits_ok(mod_q(w_prime), poly_view_coeff(&ctx->sig.w, j))) {
+                ctx->member++;
+                ctx->stage = VERIFY_STAGE_MEMBER;
+                return RING_VERIFY_PENDING;
+            }
+        }
+        ctx->row = end;
+        
+        if (ctx->row == POLY_DEGREE) {
+            ctx->result = 1;
+            ctx->stage = VERIFY_STAGE_DONE;
+            return 1; // Valid signature found!
+        }
+        return RING_VERIFY_PENDING;
+    }
+    
+    default:
+        return ctx->result;
+    }
+}
+
+static int verify_run(ring_verify_ctx_t *ctx, const RingSignature *sig,
+                      const Poly512 public_keys[RING_SIZE]) {
+    int ret;
+    
+    ret = ring_verify_start(ctx, sig, public_keys);
+    while (ret == RING_VERIFY_PENDING) {
+        ret = ring_verify_step(ctx);
     }
+    secure_zero(ctx, sizeof(*ctx));
+    return ret;
+}
+
+int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE]) {
+    ring_verify_ctx_t ctx;
     
-    return 0; // No valid signature found
+    return verify_run(&ctx, sig, public_keys);
+}
+
+int crypto_ring_verify(crypto_ctx_t *ctx, const RingSignature *sig,
+                       const Poly512 public_keys[RING_SIZE]) {
+    return verify_run(&ctx->ws.verify, sig, public_keys);
 }
 
 /* ========== LDPC STUBS (Unchanged) ========== */
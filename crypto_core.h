@@ -17,6 +17,20 @@
 #include <string.h>
 #include <stddef.h>
 
+/* Mutable module state (default PRNG, reassembly pool, decoder scratch)
+ * is declared THREAD_LOCAL: nothing on motes, __thread in the multi-core
+ * Linux gateway (linux_gateway/), where each worker thread runs its own.
+ * Code that wants no hidden state at all uses a crypto_ctx_t. */
+#ifndef THREAD_LOCAL
+#define THREAD_LOCAL
+#endif
+
+/* Constant tables that belong in flash rather than RAM. On MSP430 'const'
+ * data already lands in ROM; other targets may override the macro. */
+#ifndef FLASH_CONST
+#define FLASH_CONST const
+#endif
+
 /* ========== RING-LWE PARAMETERS ========== */
 
 #define POLY_DEGREE 128                    // n: Polynomial degree (minimal for Cooja testing)
@@ -26,6 +40,19 @@
 #define RING_SIZE 3                        // N: Number of ring members
 #define REJECT_M 20000                     // M: Rejection threshold for keygen
 #define REJECT_V 10000                     // V: Uniformity bound
+#define RING_A_SEED 0xDEADBEEFUL           // xorshift32 seed of the shared element a
+#define RING_MEMBER_SEED(i) (0x12345678UL + (uint32_t)(i) * 0xABCDEFUL) // ... of member key i
+
+/* Incremental verification */
+#define RING_VERIFY_PENDING -1
+#define RING_VERIFY_STALLED -2             // Needs wire bytes not yet available
+#ifndef RING_VERIFY_SLICE_ROWS
+#define RING_VERIFY_SLICE_ROWS 16          // Schoolbook rows per ring_verify_step()
+#endif
+#ifndef RING_VERIFY_BLOCK
+#define RING_VERIFY_BLOCK 16               // Output coefficients per early-abort check (and step)
+#endif
+#define RING_Z_BOUND 120000L               // Infinity norm of z (centred mod q) the signer enforces
 
 /* ========== LDPC PARAMETERS ========== */
 
@@ -50,6 +77,37 @@
 #define AEAD_NONCE_LEN 12                  // AEAD nonce length
 #define AEAD_TAG_LEN 16                    // AEAD tag length
 #define MAX_SESSIONS 16                    // Max concurrent sessions (gateway)
+#ifndef REPLAY_WINDOW_SIZE
+#define REPLAY_WINDOW_SIZE 64              // Anti-replay window in counters (multiple of 32)
+#endif
+#if REPLAY_WINDOW_SIZE % 32 != 0 || REPLAY_WINDOW_SIZE < 32
+#error "REPLAY_WINDOW_SIZE must be a positive multiple of 32"
+#endif
+#define REPLAY_WINDOW_WORDS (REPLAY_WINDOW_SIZE / 32)
+
+/* Stateless resumption tickets (gateway) */
+#define TICKET_KEY_ROTATION 3600           // Seconds per ticket-key epoch
+#define TICKET_LIFETIME_EPOCHS 24          // Ticket validity in key epochs
+#define TICKET_MAX_RESUMES 16              // Resumptions before full re-auth
+#ifndef TICKET_REDEEMED_CACHE
+#define TICKET_REDEEMED_CACHE 32           // Redeemed ticket serials remembered
+#endif
+#define TICKET_PLAIN_LEN (MASTER_KEY_LEN + SID_LEN + 4 + 4 + 2)
+#define TICKET_HDR_LEN 8                   // key_epoch || serial
+#define TICKET_LEN (TICKET_HDR_LEN + TICKET_PLAIN_LEN + AEAD_TAG_LEN)
+#define RESUME_NONCE_LEN 32
+#define RESUME_BINDER_LEN 16
+
+/* In-session key update (KEY_UPDATE / KEY_UPDATE_ACK) */
+#define KEY_UPDATE_TAG_LEN 16
+#define KEY_UPDATE_REQ 0x01                // Tag direction: sender -> gateway
+#define KEY_UPDATE_RSP 0x02                // Tag direction: gateway -> sender
+
+/* session_decrypt() return codes */
+#define SESSION_OK 0
+#define SESSION_ERR_AEAD -1                // Tag mismatch / malformed ciphertext
+#define SESSION_ERR_REPLAY -2              // Counter already seen inside the window
+#define SESSION_ERR_STALE -3               // Counter fell off the back of the window
 
 /* ========== DATA STRUCTURES ========== */
 
@@ -60,13 +118,34 @@ typedef struct {
     int32_t coeff[POLY_DEGREE];
 } Poly512;
 
+/**
+ * Small-coefficient polynomial (|c| <= 128): secrets and errors, a
+ * quarter of a Poly512. Coefficients are plain integers, not reduced mod q.
+ */
+typedef struct {
+    int8_t coeff[POLY_DEGREE];
+} PolySmall;
+
+/**
+ * Binary polynomial (the challenge c), one bit per coefficient
+ */
+typedef struct {
+    uint8_t bits[POLY_DEGREE / 8];
+} PolyBits;
+
+/**
+ * High bits (w >> 13, 16 of the 29 bits of q) of a polynomial mod q
+ */
+typedef struct {
+    uint16_t coeff[POLY_DEGREE];
+} PolyHigh;
+
 /**
  * Ring-LWE key pair
  */
 typedef struct {
-    Poly512 secret;      // Secret key sk
+    PolySmall secret;    // Secret key sk
     Poly512 public;      // Public key pk
-    Poly512 random;      // Random polynomial R
 } RingLWEKeyPair;
 
 /**
@@ -79,6 +158,92 @@ typedef struct {
     uint8_t keyword[KEYWORD_SIZE];         // Signed keyword
 } RingSignature;
 
+/**
+ * Streaming SHA-256 state
+ */
+typedef struct {
+    uint32_t h[8];
+    uint8_t buf[64];                       // Partial block
+    uint32_t buf_len;
+    uint64_t total;                        // Bytes hashed so far
+} sha256_ctx_t;
+
+/**
+ * Read-only polynomial view
+ * Either a host Poly512 or POLY_DEGREE big-endian 32-bit words in a wire
+ * buffer, read in place (poly_view_coeff).
+ */
+typedef struct {
+    const Poly512 *poly;                   // Host form, or NULL ...
+    const uint8_t *wire;                   // ... wire form
+} PolyView;
+
+/**
+ * Read-only ring signature view (components may live in a wire buffer)
+ */
+typedef struct {
+    PolyView S[RING_SIZE];
+    PolyView w;
+    const uint8_t *commitment;
+    const uint8_t *keyword;
+} RingSignatureView;
+
+/**
+ * Incremental ring verification state (ring_verify_start / ring_verify_step)
+ */
+typedef struct {
+    RingSignatureView sig;
+    PolyView public_keys[RING_SIZE];
+    PolyBits challenge;                    // Expanded challenge c (once hashed)
+    int32_t acc[2 * POLY_DEGREE];          // a*z - t*c before reduction mod x^n + 1,
+                                           // or decoded z || t for blockwise checks
+    sha256_ctx_t hash;                     // H(w || keyword), fed as w arrives
+    const uint8_t *avail_end;              // Wire bytes below this are present (NULL = all)
+    uint16_t hashed;                       // Bytes of w fed to hash
+    uint16_t row;                          // Next schoolbook row / output block
+    uint16_t normed;                       // z coefficients checked against RING_Z_BOUND
+    uint8_t member;                        // Ring member being checked
+    uint8_t z_nonzero;                     // Member's z had a non-zero coefficient
+    uint8_t have_challenge;
+    uint8_t stage;
+    int result;
+} ring_verify_ctx_t;
+
+/**
+ * Scratch for ring_lwe_keygen()
+ */
+typedef struct {
+    PolySmall s, e;
+    Poly512 as;
+} crypto_keygen_ws_t;
+
+/**
+ * Scratch for ring_sign()
+ */
+typedef struct {
+    Poly512 y, w, sc, z, tc, w_check;
+    PolyHigh w_approx, w_check_approx;
+    PolyBits challenge;
+    uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
+} crypto_sign_ws_t;
+
+/**
+ * Explicit crypto state: the DRBG and the scratch of the lattice
+ * operations, sized for the largest of them. crypto_* functions taking
+ * a context touch no global or static state, so threads (or handshakes)
+ * with their own contexts run concurrently. The context-free API
+ * (ring_sign() etc.) keeps its signatures for the motes: it runs on the
+ * default PRNG with its scratch on the stack.
+ */
+typedef struct {
+    uint32_t drbg;                         // Xorshift32 state, never 0
+    union {
+        crypto_keygen_ws_t keygen;
+        crypto_sign_ws_t sign;
+        ring_verify_ctx_t verify;
+    } ws;
+} crypto_ctx_t;
+
 /**
  * QC-LDPC public key (compressed circulant representation)
  */
@@ -111,6 +276,7 @@ typedef struct {
     uint8_t K_master[MASTER_KEY_LEN];
     uint32_t counter;
     uint32_t expiry_ts;
+    uint16_t epoch;                        // Key-update epoch of K_master
     uint8_t active;
 } session_ctx_t;
 
@@ -120,30 +286,125 @@ typedef struct {
 typedef struct {
     uint8_t sid[SID_LEN];
     uint8_t K_master[MASTER_KEY_LEN];
-    uint32_t last_seq;
+    uint32_t last_seq;                     // Highest authenticated counter
+    uint32_t replay_bitmap[REPLAY_WINDOW_WORDS]; // Bit k set => (last_seq - k) seen
+    uint32_t window_drops;                 // Rejected: older than the window
+    uint32_t replay_drops;                 // Rejected: duplicate inside the window
+    uint32_t reordered;                    // Accepted late (counter < last_seq)
     uint32_t expiry_ts;
+    uint16_t epoch;                        // Key-update epoch of K_master
+    uint16_t resume_count;                 // Resumptions since the PQ handshake
     uint8_t peer_addr[16];                 // IPv6 address
     uint8_t in_use;
 } session_entry_t;
 
 /**
- * Authentication fragment (for reliable transmission)
+ * One DATA record for session_decrypt_batch()
+ */
+typedef struct {
+    uint32_t counter;
+    const uint8_t *ct;
+    size_t ct_len;
+    uint8_t *out;                          // ct_len - AEAD_TAG_LEN bytes
+    size_t out_len;
+    int result;                            // SESSION_OK or SESSION_ERR_*
+} session_record_t;
+
+/**
+ * Session state wrapped inside a resumption ticket
+ */
+typedef struct {
+    uint8_t K_master[MASTER_KEY_LEN];
+    uint8_t sid[SID_LEN];
+    uint32_t counter;                      // Last counter seen by the gateway
+    uint32_t expiry_epoch;                 // Last ticket-key epoch it is valid in
+    uint16_t resume_count;                 // Resumptions since the PQ handshake
+} session_ticket_state_t;
+
+/**
+ * Authentication message (sender -> gateway, fragmented on the wire)
+ */
+typedef struct {
+    uint8_t type;
+    uint8_t syndrome[LDPC_ROWS / 8];
+    Poly512 public_key;                    // Sender's key (ring member 0)
+    RingSignature signature;
+} AuthMessage;
+
+/* Wire form: type || syndrome || pk || S[0..N-1] || w || commitment || keyword,
+ * coefficients as big-endian 32-bit words */
+#define AUTH_MSG_WIRE_LEN (1 + LDPC_ROWS / 8 + (RING_SIZE + 2) * POLY_DEGREE * 4 + \
+                           SHA256_DIGEST_SIZE + KEYWORD_SIZE)
+
+/**
+ * Read-only view of a wire-form AuthMessage (auth_msg_view)
+ */
+typedef struct {
+    uint8_t type;
+    const uint8_t *syndrome;
+    PolyView public_key;
+    RingSignatureView signature;
+} AuthMessageView;
+
+/**
+ * Serialiser cursor over an AuthMessage
+ * Produces any byte range of the wire form straight from the message,
+ * so fragments are encoded on demand without a staging buffer.
+ */
+typedef struct {
+    const AuthMessage *msg;
+    size_t offset;                         // Next wire byte
+} auth_cursor_t;
+
+/**
+ * Authentication fragment header (for reliable transmission)
+ * Sent unpadded: header followed by the fragment's payload bytes only.
+ * Every fragment but the last carries exactly frag_size bytes.
  */
 typedef struct __attribute__((packed)) {
     uint8_t type;
-    uint16_t session_id;
-    uint16_t fragment_id;
-    uint16_t total_frags;
-    uint16_t payload_len;
-    uint8_t payload[64];
-} __attribute__((packed)) AuthFragment;
+    uint16_t session_id;                   // Handshake id
+    uint8_t fragment_id;
+    uint8_t total_frags;
+    uint16_t frag_size;                    // Negotiated payload bytes per fragment
+    uint8_t payload[];
+} AuthFragment;
+
+#define AUTH_FRAG_HDR_LEN 7                // sizeof(AuthFragment)
+#define AUTH_FRAG_MIN 32                   // Smallest fragment payload either side accepts
+#ifndef AUTH_FRAG_MAX_SIZE
+#define AUTH_FRAG_MAX_SIZE 1024            // Largest: senders start at most here, gateways accept it
+#endif
+
+/**
+ * Erasure-coded authentication fragment header (see fec.h)
+ * fragment_id < k carries data fragment fragment_id unchanged (the last
+ * one short); fragment_id >= k carries parity row fragment_id - k, always
+ * frag_size bytes. The gateway ACKs only once any k have arrived, with
+ * cum_ack = k and sack = highest fragment_id seen.
+ */
+typedef struct __attribute__((packed)) {
+    uint8_t type;
+    uint16_t session_id;                   // Handshake id
+    uint8_t fragment_id;                   // Coded index
+    uint8_t k;                             // Data fragments
+    uint16_t frag_size;
+    uint16_t payload_len;                  // Total AUTH payload bytes
+    uint8_t payload[];
+} AuthFecFragment;
+
+#define AUTH_FEC_HDR_LEN 9                 // sizeof(AuthFecFragment)
 
 /**
- * Fragment acknowledgment
+ * Fragment acknowledgment (cumulative ACK + selective ACK bitmap)
  */
 typedef struct __attribute__((packed)) {
     uint8_t type;
-    uint16_t fragment_id;
+    uint16_t handshake_id;                 // AuthFragment.session_id being acknowledged
+    uint8_t fragment_id;                   // Fragment that triggered this ACK (RTT sample)
+    uint8_t cum_ack;                       // Every fragment below this has arrived
+    uint32_t sack;                         // Bit k => fragment cum_ack + 1 + k has arrived
+    uint16_t max_frag_size;                // Gateway's largest accepted frag_size
 } FragmentAck;
 
 /* ========== POLYNOMIAL OPERATIONS ========== */
@@ -184,6 +445,41 @@ uint32_t poly_norm(const Poly512 *a);
  */
 void poly_copy(Poly512 *dest, const Poly512 *src);
 
+/*
+ * Mixed-width products for narrow operands. Each output coefficient is
+ * accumulated without reduction and reduced mod q once, instead of once
+ * per term. poly_mul_small() still widens each product into an int64
+ * accumulator; the binary-c kernels need no multiplies at all. Results
+ * are canonical mod q, the same as poly_mul_ntt() on the widened operands.
+ */
+
+/**
+ * result = a * s (a mod q, s small): 29 x 8-bit products
+ */
+void poly_mul_small(Poly512 *result, const Poly512 *a, const PolySmall *s);
+
+/**
+ * result = a * c (c binary): additions only
+ */
+void poly_mul_bits(Poly512 *result, const Poly512 *a, const PolyBits *c);
+
+/**
+ * result = s * c (s small, c binary): additions in a 16-bit accumulator
+ */
+void poly_mul_small_bits(Poly512 *result, const PolySmall *s, const PolyBits *c);
+
+/**
+ * result = a + s mod q (s small)
+ */
+void poly_add_small(Poly512 *result, const Poly512 *a, const PolySmall *s);
+
+/**
+ * Coefficient i of a binary polynomial
+ */
+static inline int poly_bit(const PolyBits *c, int i) {
+    return (c->bits[i >> 3] >> (i & 7)) & 1;
+}
+
 /* ========== RANDOM NUMBER GENERATION ========== */
 
 /**
@@ -206,6 +502,17 @@ void crypto_secure_random(uint8_t *output, size_t len);
  */
 int32_t gaussian_sample(int sigma);
 
+/**
+ * Seed a context's DRBG (0 is replaced, xorshift would stick at it)
+ */
+void crypto_ctx_init(crypto_ctx_t *ctx, uint32_t seed);
+
+/**
+ * crypto_random_uint32() / crypto_secure_random() on a context's DRBG
+ */
+uint32_t crypto_ctx_random_uint32(crypto_ctx_t *ctx);
+void crypto_ctx_random(crypto_ctx_t *ctx, uint8_t *output, size_t len);
+
 /* ========== RING-LWE OPERATIONS ========== */
 
 /**
@@ -218,17 +525,32 @@ int ring_lwe_keygen(RingLWEKeyPair *keypair);
  */
 void generate_ring_member_key(Poly512 *public_key, int member_index);
 
+/**
+ * Expand the shared ring element a from RING_A_SEED
+ */
+void ring_expand_a(Poly512 *a);
+
+/**
+ * The same deterministic polynomials, expanded at build time by
+ * gen_ring_tables.c into ring_tables.c: the shared element a and ring
+ * member keys 0..RING_SIZE-1. Keygen, signing and verification read a
+ * from flash; gateways view the member keys in place.
+ */
+extern FLASH_CONST Poly512 ring_a_table;
+extern FLASH_CONST Poly512 ring_member_table[RING_SIZE];
+
 /**
  * Generate ring signature
  * @param sig: Output signature
  * @param keyword: Message to sign
  * @param signer_keypair: Signer's key pair
- * @param ring_pubkeys: All N public keys in ring
+ * @param ring_pubkeys: All N public keys in ring, as views (e.g. over
+ *        ring_member_table, so no RAM copy of the ring is needed)
  * @param signer_index: Index of signer (0 to N-1)
  */
 int ring_sign(RingSignature *sig, const uint8_t *keyword,
               const RingLWEKeyPair *signer_keypair,
-              const Poly512 ring_pubkeys[RING_SIZE],
+              const PolyView ring_pubkeys[RING_SIZE],
               int signer_index);
 
 /**
@@ -237,6 +559,60 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
  */
 int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE]);
 
+/**
+ * ring_lwe_keygen() / ring_sign() / ring_verify() on a context: its DRBG
+ * and workspace only. Same results as the context-free calls when the
+ * DRBG holds the same state as the default PRNG.
+ */
+int crypto_ring_lwe_keygen(crypto_ctx_t *ctx, RingLWEKeyPair *keypair);
+int crypto_ring_sign(crypto_ctx_t *ctx, RingSignature *sig, const uint8_t *keyword,
+                     const RingLWEKeyPair *signer_keypair,
+                     const PolyView ring_pubkeys[RING_SIZE], int signer_index);
+int crypto_ring_verify(crypto_ctx_t *ctx, const RingSignature *sig,
+                       const Poly512 public_keys[RING_SIZE]);
+
+/**
+ * Incremental ring verification, so a cooperative scheduler can yield
+ * between slices. sig and public_keys must stay valid until the end.
+ * @returns RING_VERIFY_PENDING, or 1 / 0 as ring_verify()
+ */
+int ring_verify_start(ring_verify_ctx_t *ctx, const RingSignature *sig,
+                      const Poly512 public_keys[RING_SIZE]);
+
+/**
+ * As ring_verify_start(), reading signature and keys through views
+ * (e.g. straight from a reassembled wire buffer, with no copies)
+ */
+int ring_verify_view_start(ring_verify_ctx_t *ctx, const RingSignatureView *sig,
+                           const PolyView public_keys[RING_SIZE]);
+
+/**
+ * Pipelined verification over a wire buffer that is still filling in
+ * order: only bytes below avail_end are read. a*z for the first non-zero
+ * member and the hash of w run as their bytes arrive; t*c and the final
+ * check wait for the challenge, i.e. for the whole message.
+ */
+void ring_verify_pipe_start(ring_verify_ctx_t *ctx, const RingSignatureView *sig,
+                            const PolyView public_keys[RING_SIZE],
+                            const uint8_t *avail_end);
+
+/**
+ * More of the wire buffer is present (NULL: all of it)
+ */
+void ring_verify_pipe_avail(ring_verify_ctx_t *ctx, const uint8_t *avail_end);
+
+/**
+ * Run one slice (at most RING_VERIFY_SLICE_ROWS schoolbook rows, or
+ * RING_VERIFY_BLOCK output coefficients). A member whose z is over
+ * RING_Z_BOUND is rejected before any multiply; once the challenge and
+ * the member are complete, a*z - t*c is formed one block of output
+ * coefficients at a time and the member is dropped at the first block
+ * outside the high-bits tolerance.
+ * @returns RING_VERIFY_PENDING, RING_VERIFY_STALLED (pipelined, waiting
+ *          for bytes), or 1 / 0 as ring_verify()
+ */
+int ring_verify_step(ring_verify_ctx_t *ctx);
+
 /* ========== QC-LDPC OPERATIONS ========== */
 
 /**
@@ -267,6 +643,13 @@ void generate_error_vector(ErrorVector *error, uint16_t target_weight);
  */
 void sha256_hash(uint8_t output[SHA256_DIGEST_SIZE], const uint8_t *input, uint32_t len);
 
+/**
+ * Streaming SHA-256 (input fed in pieces as it becomes available)
+ */
+void sha256_init(sha256_ctx_t *ctx);
+void sha256_update(sha256_ctx_t *ctx, const uint8_t *input, uint32_t len);
+void sha256_final(sha256_ctx_t *ctx, uint8_t output[SHA256_DIGEST_SIZE]);
+
 /**
  * HMAC-SHA256
  */
@@ -335,12 +718,99 @@ int session_encrypt(session_ctx_t *ctx,
                    uint8_t *out, size_t *out_len);
 
 /**
- * Session decrypt with replay protection
+ * Session decrypt with sliding-window replay protection
+ * Late counters inside the window are accepted exactly once.
+ * @returns SESSION_OK or one of the SESSION_ERR_* codes
  */
 int session_decrypt(session_entry_t *se, uint32_t counter,
                    const uint8_t *ct, size_t ct_len,
                    uint8_t *out, size_t *out_len);
 
+/**
+ * Decrypt several records of one session, in order, with the same
+ * result per record as session_decrypt(). The counter-independent part
+ * of the message-key HKDF (Extract over K_master, the HMAC pads of the
+ * PRK) is computed once per batch instead of once per record.
+ * @returns Records decrypted (result == SESSION_OK)
+ */
+int session_decrypt_batch(session_entry_t *se, session_record_t *recs, size_t count);
+
+/**
+ * Reset the replay window and its drop statistics (new session / new key)
+ */
+void replay_window_reset(session_entry_t *se);
+
+/* ========== SESSION RESUMPTION ========== */
+
+/**
+ * Derive the ticket-protection key for a key epoch
+ * K_ticket = HKDF(ticket_secret, "ticket-key" || epoch)
+ */
+void ticket_key_derive(uint8_t *ticket_key, const uint8_t *ticket_secret,
+                       uint32_t key_epoch);
+
+/**
+ * Encrypt and authenticate session state into a TICKET_LEN-byte ticket
+ */
+int ticket_seal(uint8_t *ticket, const session_ticket_state_t *st,
+                const uint8_t *ticket_key, uint32_t key_epoch, uint32_t serial);
+
+/**
+ * Key epoch a ticket was sealed under (read from the clear header)
+ */
+uint32_t ticket_key_epoch(const uint8_t *ticket);
+
+/**
+ * Serial a ticket was sealed with (read from the clear header)
+ */
+uint32_t ticket_serial_of(const uint8_t *ticket);
+
+/**
+ * Verify and decrypt a ticket
+ * @returns 0 on success, -1 if the ticket is forged or was sealed under another key
+ */
+int ticket_open(session_ticket_state_t *st, const uint8_t *ticket,
+                const uint8_t *ticket_key);
+
+/**
+ * Proof of possession of the ticket's K_master
+ * binder = HMAC(K_master, ticket || N_S) truncated to RESUME_BINDER_LEN
+ */
+void resume_binder(uint8_t *binder, const uint8_t *K_master,
+                   const uint8_t *ticket, const uint8_t *N_S);
+
+/**
+ * RESUME_ACK confirmation under the resumed K_master, covering every
+ * field the sender acts on
+ * confirm = HMAC(K_master, type || N_G || SID || ticket) truncated to RESUME_BINDER_LEN
+ */
+void resume_confirm(uint8_t *confirm, const uint8_t *K_master, uint8_t type,
+                    const uint8_t *N_G, const uint8_t *sid, const uint8_t *ticket);
+
+/**
+ * Derive the resumed master key (single HKDF)
+ * K_new = HKDF(salt = N_S || N_G, ikm = K_old, "resume")
+ */
+void derive_resumed_master_key(uint8_t *K_new, const uint8_t *K_old,
+                               const uint8_t *N_S, const uint8_t *N_G);
+
+/* ========== IN-SESSION KEY UPDATE ========== */
+
+/**
+ * Ratchet the session master key forward one epoch
+ * K_next = HKDF(K_master, "key-update" || SID || epoch)
+ * The caller zeroizes the old key once both sides agree (forward secrecy).
+ */
+void session_ratchet_key(uint8_t *K_next, const uint8_t *K_master,
+                         const uint8_t *sid, uint16_t next_epoch);
+
+/**
+ * Key-update proof of possession
+ * tag = HMAC(K_next, direction || SID || epoch) truncated to KEY_UPDATE_TAG_LEN
+ */
+void key_update_tag(uint8_t *tag, const uint8_t *K_next,
+                    const uint8_t *sid, uint16_t epoch, uint8_t direction);
+
 /* ========== UTILITY FUNCTIONS ========== */
 
 /**
@@ -358,6 +828,11 @@ int constant_time_compare(const uint8_t *a, const uint8_t *b, uint32_t len);
  */
 void poly_print(const char *label, const Poly512 *p, int num_coeffs);
 
+/**
+ * Print a small-coefficient polynomial (debugging)
+ */
+void poly_small_print(const char *label, const PolySmall *p, int num_coeffs);
+
 /* ========== UTILITIES ========== */
 void poly_print(const char *label, const Poly512 *p, int num_coeffs);
 void secure_zero(void *s, size_t n);
@@ -367,4 +842,58 @@ int constant_time_compare(const uint8_t *a, const uint8_t *b, uint32_t len);
 void serialize_poly512(uint8_t *out, const Poly512 *p);
 void deserialize_poly512(Poly512 *p, const uint8_t *in);
 
+/**
+ * Same bytes as serialize_poly512() of the widened coefficients
+ */
+void serialize_poly_small(uint8_t *out, const PolySmall *p);
+
+/**
+ * Coefficient i of a polynomial view (big-endian decode for wire views)
+ */
+static inline int32_t poly_view_coeff(const PolyView *v, int i) {
+    const uint8_t *b;
+    
+    if (v->poly != NULL) return v->poly->coeff[i];
+    b = v->wire + 4 * i;
+    return (int32_t)(((uint32_t)b[0] << 24) | ((uint32_t)b[1] << 16) |
+                     ((uint32_t)b[2] << 8) | (uint32_t)b[3]);
+}
+
+/**
+ * View a host polynomial
+ */
+static inline PolyView poly_view(const Poly512 *p) {
+    PolyView v;
+    v.poly = p;
+    v.wire = NULL;
+    return v;
+}
+
+/**
+ * View a wire-form AuthMessage in place (the buffer must outlive the view)
+ * @returns 0 on success, -1 if len is not AUTH_MSG_WIRE_LEN
+ */
+int auth_msg_view(AuthMessageView *view, const uint8_t *wire, size_t len);
+
+/**
+ * Print the first coefficients of a view (debugging)
+ */
+void poly_view_print(const char *label, const PolyView *v, int num_coeffs);
+
+/**
+ * Start a cursor at wire offset 0
+ */
+void auth_cursor_init(auth_cursor_t *cur, const AuthMessage *msg);
+
+/**
+ * Move to wire offset (clamped to AUTH_MSG_WIRE_LEN)
+ */
+void auth_cursor_seek(auth_cursor_t *cur, size_t offset);
+
+/**
+ * Encode up to len wire bytes at the cursor and advance
+ * @returns Bytes written (short only at the end of the message)
+ */
+size_t auth_cursor_read(auth_cursor_t *cur, uint8_t *out, size_t len);
+
 #endif /* CRYPTO_CORE_H_ */
@@ -249,35 +249,82 @@ void derive_master_key(uint8_t *K_master,
     secure_zero(ikm, ikm_len);
 }
 
-static void derive_message_key(uint8_t *K_i,
-                              const uint8_t *K_master,
-                              const uint8_t *sid, size_t sid_len,
-                              uint32_t counter) {
-    uint8_t info[32];
-    size_t info_len = 0;
+/* HMAC-SHA256 key with its ipad / opad blocks already absorbed, so each
+ * further MAC under the same key costs two compressions fewer */
+typedef struct {
+    sha256_ctx_t inner;
+    sha256_ctx_t outer;
+} hmac_key_state_t;
+
+static void hmac_key_init(hmac_key_state_t *st, const uint8_t *key, size_t key_len) {
+    uint8_t pad[64];
+    size_t i;
     
-    memcpy(info, "session-key", 11);
-    info_len = 11;
+    /* Keys are HKDF PRKs here: never longer than a block */
+    memset(pad, 0, 64);
+    memcpy(pad, key, key_len);
+    for (i = 0; i < 64; i++) pad[i] ^= 0x36;
+    sha256_init(&st->inner);
+    sha256_update(&st->inner, pad, 64);
+    for (i = 0; i < 64; i++) pad[i] ^= 0x36 ^ 0x5c;
+    sha256_init(&st->outer);
+    sha256_update(&st->outer, pad, 64);
+    secure_zero(pad, 64);
+}
+
+static void hmac_key_mac(uint8_t *output, const hmac_key_state_t *st,
+                         const uint8_t *msg, size_t msg_len) {
+    sha256_ctx_t ctx = st->inner;
+    uint8_t inner_hash[SHA256_DIGEST_SIZE];
     
-    memcpy(info + info_len, sid, sid_len);
-    info_len += sid_len;
+    sha256_update(&ctx, msg, msg_len);
+    sha256_final(&ctx, inner_hash);
+    ctx = st->outer;
+    sha256_update(&ctx, inner_hash, SHA256_DIGEST_SIZE);
+    sha256_final(&ctx, output);
+    secure_zero(inner_hash, SHA256_DIGEST_SIZE);
+    secure_zero(&ctx, sizeof(ctx));
+}
+
+/* K_i = HKDF(K_master, "session-key" || SID || counter), one 32-byte
+ * block. Extract depends only on the session, so a batch runs it once
+ * and expands per counter */
+typedef struct {
+    hmac_key_state_t prk;
+    uint8_t info[11 + SID_LEN + 4 + 1];
+} msg_key_ctx_t;
+
+static void msg_key_extract(msg_key_ctx_t *mk,
+                            const uint8_t *K_master, const uint8_t *sid) {
+    uint8_t prk[SHA256_DIGEST_SIZE];
     
-    info[info_len++] = (counter >> 24) & 0xFF;
-    info[info_len++] = (counter >> 16) & 0xFF;
-    info[info_len++] = (counter >> 8) & 0xFF;
-    info[info_len++] = counter & 0xFF;
+    hkdf_extract(prk, NULL, 0, K_master, MASTER_KEY_LEN);
+    hmac_key_init(&mk->prk, prk, SHA256_DIGEST_SIZE);
+    secure_zero(prk, SHA256_DIGEST_SIZE);
     
-    hkdf_sha256(NULL, 0, K_master, MASTER_KEY_LEN,
-               info, info_len, K_i, 32);
+    memcpy(mk->info, "session-key", 11);
+    memcpy(mk->info + 11, sid, SID_LEN);
+    mk->info[sizeof(mk->info) - 1] = 0x01;
+}
+
+static void msg_key_expand(uint8_t *K_i, msg_key_ctx_t *mk, uint32_t counter) {
+    mk->info[11 + SID_LEN] = (counter >> 24) & 0xFF;
+    mk->info[12 + SID_LEN] = (counter >> 16) & 0xFF;
+    mk->info[13 + SID_LEN] = (counter >> 8) & 0xFF;
+    mk->info[14 + SID_LEN] = counter & 0xFF;
+    hmac_key_mac(K_i, &mk->prk, mk->info, sizeof(mk->info));
 }
 
 int session_encrypt(session_ctx_t *ctx,
                    const uint8_t *plaintext, size_t pt_len,
                    uint8_t *out, size_t *out_len) {
+    msg_key_ctx_t mk;
     uint8_t K_i[32];
     uint8_t nonce[AEAD_NONCE_LEN];
     
-    derive_message_key(K_i, ctx->K_master, ctx->sid, SID_LEN, ctx->counter);
+    msg_key_extract(&mk, ctx->K_master, ctx->sid);
+    msg_key_expand(K_i, &mk, ctx->counter);
+    secure_zero(&mk, sizeof(mk));
     
     memcpy(nonce, ctx->sid, SID_LEN);
     nonce[8] = (ctx->counter >> 24) & 0xFF;
@@ -292,31 +339,299 @@ int session_encrypt(session_ctx_t *ctx,
     return ret;
 }
 
-int session_decrypt(session_entry_t *se, uint32_t counter,
-                   const uint8_t *ct, size_t ct_len,
-                   uint8_t *out, size_t *out_len) {
-    uint8_t K_i[32];
+/* ========== SESSION RESUMPTION TICKETS ========== */
+/* Ticket wire format (TICKET_LEN bytes):
+ *   key_epoch(4) || serial(4) || AEAD(K_ticket, state) || tag(16)
+ * The clear header is the AAD and, zero-padded, the AEAD nonce; serial
+ * must be unique per key epoch. */
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (v >> 24) & 0xFF;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+static uint32_t get_u32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+void ticket_key_derive(uint8_t *ticket_key, const uint8_t *ticket_secret,
+                       uint32_t key_epoch) {
+    uint8_t info[14];
+    
+    memcpy(info, "ticket-key", 10);
+    put_u32(info + 10, key_epoch);
+    
+    hkdf_sha256(NULL, 0, ticket_secret, SHA256_DIGEST_SIZE,
+               info, sizeof(info), ticket_key, 32);
+}
+
+int ticket_seal(uint8_t *ticket, const session_ticket_state_t *st,
+                const uint8_t *ticket_key, uint32_t key_epoch, uint32_t serial) {
+    uint8_t plain[TICKET_PLAIN_LEN];
+    uint8_t nonce[AEAD_NONCE_LEN];
+    size_t off = 0, ct_len;
+    int ret;
+    
+    memcpy(plain + off, st->K_master, MASTER_KEY_LEN);
+    off += MASTER_KEY_LEN;
+    memcpy(plain + off, st->sid, SID_LEN);
+    off += SID_LEN;
+    put_u32(plain + off, st->counter);
+    off += 4;
+    put_u32(plain + off, st->expiry_epoch);
+    off += 4;
+    plain[off++] = (st->resume_count >> 8) & 0xFF;
+    plain[off++] = st->resume_count & 0xFF;
+    
+    put_u32(ticket, key_epoch);
+    put_u32(ticket + 4, serial);
+    memset(nonce, 0, AEAD_NONCE_LEN);
+    memcpy(nonce, ticket, TICKET_HDR_LEN);
+    
+    ret = aead_encrypt(ticket + TICKET_HDR_LEN, &ct_len, plain, TICKET_PLAIN_LEN,
+                      ticket, TICKET_HDR_LEN, ticket_key, nonce);
+    
+    secure_zero(plain, sizeof(plain));
+    return ret;
+}
+
+uint32_t ticket_key_epoch(const uint8_t *ticket) {
+    return get_u32(ticket);
+}
+
+uint32_t ticket_serial_of(const uint8_t *ticket) {
+    return get_u32(ticket + 4);
+}
+
+int ticket_open(session_ticket_state_t *st, const uint8_t *ticket,
+                const uint8_t *ticket_key) {
+    uint8_t plain[TICKET_PLAIN_LEN];
     uint8_t nonce[AEAD_NONCE_LEN];
+    size_t pt_len, off = 0;
     
-    if (counter <= se->last_seq) {
-        return -1; // Replay attack
+    memset(nonce, 0, AEAD_NONCE_LEN);
+    memcpy(nonce, ticket, TICKET_HDR_LEN);
+    
+    if (aead_decrypt(plain, &pt_len, ticket + TICKET_HDR_LEN,
+                     TICKET_PLAIN_LEN + AEAD_TAG_LEN,
+                     ticket, TICKET_HDR_LEN, ticket_key, nonce) != 0) {
+        return -1;
     }
     
-    derive_message_key(K_i, se->K_master, se->sid, SID_LEN, counter);
+    memcpy(st->K_master, plain + off, MASTER_KEY_LEN);
+    off += MASTER_KEY_LEN;
+    memcpy(st->sid, plain + off, SID_LEN);
+    off += SID_LEN;
+    st->counter = get_u32(plain + off);
+    off += 4;
+    st->expiry_epoch = get_u32(plain + off);
+    off += 4;
+    st->resume_count = ((uint16_t)plain[off] << 8) | plain[off + 1];
+    
+    secure_zero(plain, sizeof(plain));
+    return 0;
+}
+
+void resume_binder(uint8_t *binder, const uint8_t *K_master,
+                   const uint8_t *ticket, const uint8_t *N_S) {
+    uint8_t msg[TICKET_LEN + RESUME_NONCE_LEN];
+    uint8_t mac[SHA256_DIGEST_SIZE];
     
-    memcpy(nonce, se->sid, SID_LEN);
-    nonce[8] = (counter >> 24) & 0xFF;
-    nonce[9] = (counter >> 16) & 0xFF;
-    nonce[10] = (counter >> 8) & 0xFF;
-    nonce[11] = counter & 0xFF;
+    memcpy(msg, ticket, TICKET_LEN);
+    memcpy(msg + TICKET_LEN, N_S, RESUME_NONCE_LEN);
+    hmac_sha256(mac, K_master, MASTER_KEY_LEN, msg, sizeof(msg));
+    memcpy(binder, mac, RESUME_BINDER_LEN);
+    
+    secure_zero(mac, sizeof(mac));
+}
+
+void resume_confirm(uint8_t *confirm, const uint8_t *K_master, uint8_t type,
+                    const uint8_t *N_G, const uint8_t *sid, const uint8_t *ticket) {
+    uint8_t msg[1 + RESUME_NONCE_LEN + SID_LEN + TICKET_LEN];
+    uint8_t mac[SHA256_DIGEST_SIZE];
+    
+    msg[0] = type;
+    memcpy(msg + 1, N_G, RESUME_NONCE_LEN);
+    memcpy(msg + 1 + RESUME_NONCE_LEN, sid, SID_LEN);
+    memcpy(msg + 1 + RESUME_NONCE_LEN + SID_LEN, ticket, TICKET_LEN);
+    hmac_sha256(mac, K_master, MASTER_KEY_LEN, msg, sizeof(msg));
+    memcpy(confirm, mac, RESUME_BINDER_LEN);
+    
+    secure_zero(mac, sizeof(mac));
+}
+
+void derive_resumed_master_key(uint8_t *K_new, const uint8_t *K_old,
+                               const uint8_t *N_S, const uint8_t *N_G) {
+    uint8_t salt[2 * RESUME_NONCE_LEN];
+    const uint8_t info[] = "resume";
     
-    int ret = aead_decrypt(out, out_len, ct, ct_len,
-                          se->sid, SID_LEN, K_i, nonce);
+    memcpy(salt, N_S, RESUME_NONCE_LEN);
+    memcpy(salt + RESUME_NONCE_LEN, N_G, RESUME_NONCE_LEN);
     
-    if (ret == 0) {
+    hkdf_sha256(salt, sizeof(salt), K_old, MASTER_KEY_LEN,
+               info, sizeof(info) - 1, K_new, MASTER_KEY_LEN);
+}
+
+/* ========== IN-SESSION KEY UPDATE ========== */
+
+void session_ratchet_key(uint8_t *K_next, const uint8_t *K_master,
+                         const uint8_t *sid, uint16_t next_epoch) {
+    uint8_t info[10 + SID_LEN + 2];
+    
+    memcpy(info, "key-update", 10);
+    memcpy(info + 10, sid, SID_LEN);
+    info[10 + SID_LEN] = (next_epoch >> 8) & 0xFF;
+    info[10 + SID_LEN + 1] = next_epoch & 0xFF;
+    
+    hkdf_sha256(NULL, 0, K_master, MASTER_KEY_LEN,
+               info, sizeof(info), K_next, MASTER_KEY_LEN);
+}
+
+void key_update_tag(uint8_t *tag, const uint8_t *K_next,
+                    const uint8_t *sid, uint16_t epoch, uint8_t direction) {
+    uint8_t msg[1 + SID_LEN + 2];
+    uint8_t mac[SHA256_DIGEST_SIZE];
+    
+    msg[0] = direction;
+    memcpy(msg + 1, sid, SID_LEN);
+    msg[1 + SID_LEN] = (epoch >> 8) & 0xFF;
+    msg[1 + SID_LEN + 1] = epoch & 0xFF;
+    
+    hmac_sha256(mac, K_next, MASTER_KEY_LEN, msg, sizeof(msg));
+    memcpy(tag, mac, KEY_UPDATE_TAG_LEN);
+    secure_zero(mac, sizeof(mac));
+}
+
+/* ========== ANTI-REPLAY WINDOW ========== */
+/* IPsec-style sliding window (RFC 4303 Sec. 3.4.3). Bit k of the bitmap
+ * records whether counter (last_seq - k) has been accepted; word 0 holds
+ * bits 0..31. The window is only advanced after the AEAD tag verifies. */
+
+void replay_window_reset(session_entry_t *se) {
+    memset(se->replay_bitmap, 0, sizeof(se->replay_bitmap));
+    se->last_seq = 0;
+    se->replay_bitmap[0] = 1; /* Counter 0 is never used by the sender */
+    se->window_drops = 0;
+    se->replay_drops = 0;
+    se->reordered = 0;
+}
+
+static int replay_check(const session_entry_t *se, uint32_t counter) {
+    uint32_t off;
+    
+    if (counter > se->last_seq) {
+        return SESSION_OK; // Ahead of the window: always fresh
+    }
+    
+    off = se->last_seq - counter;
+    if (off >= REPLAY_WINDOW_SIZE) {
+        return SESSION_ERR_STALE;
+    }
+    if (se->replay_bitmap[off / 32] & ((uint32_t)1 << (off % 32))) {
+        return SESSION_ERR_REPLAY;
+    }
+    return SESSION_OK;
+}
+
+static void replay_update(session_entry_t *se, uint32_t counter) {
+    uint32_t off;
+    int i;
+    
+    if (counter > se->last_seq) {
+        uint32_t shift = counter - se->last_seq;
+        
+        if (shift >= REPLAY_WINDOW_SIZE) {
+            memset(se->replay_bitmap, 0, sizeof(se->replay_bitmap));
+        } else {
+            uint32_t words = shift / 32;
+            uint32_t bits = shift % 32;
+            
+            for (i = REPLAY_WINDOW_WORDS - 1; i >= 0; i--) {
+                uint32_t v = 0;
+                if (i >= (int)words) {
+                    v = se->replay_bitmap[i - words] << bits;
+                    if (bits && i > (int)words) {
+                        v |= se->replay_bitmap[i - words - 1] >> (32 - bits);
+                    }
+                }
+                se->replay_bitmap[i] = v;
+            }
+        }
+        se->replay_bitmap[0] |= 1;
         se->last_seq = counter;
+        return;
+    }
+    
+    off = se->last_seq - counter;
+    se->replay_bitmap[off / 32] |= ((uint32_t)1 << (off % 32));
+    se->reordered++;
+}
+
+int session_decrypt(session_entry_t *se, uint32_t counter,
+                   const uint8_t *ct, size_t ct_len,
+                   uint8_t *out, size_t *out_len) {
+    session_record_t rec;
+    
+    rec.counter = counter;
+    rec.ct = ct;
+    rec.ct_len = ct_len;
+    rec.out = out;
+    session_decrypt_batch(se, &rec, 1);
+    *out_len = rec.out_len;
+    return rec.result;
+}
+
+int session_decrypt_batch(session_entry_t *se, session_record_t *recs, size_t count) {
+    msg_key_ctx_t mk;
+    uint8_t K_i[32];
+    uint8_t nonce[AEAD_NONCE_LEN];
+    size_t r;
+    int ok = 0;
+    
+    /* Only the counter changes per record */
+    msg_key_extract(&mk, se->K_master, se->sid);
+    memcpy(nonce, se->sid, SID_LEN);
+    
+    for (r = 0; r < count; r++) {
+        session_record_t *rec = &recs[r];
+        uint32_t counter = rec->counter;
+        int check = replay_check(se, counter);
+        
+        rec->out_len = 0;
+        if (check == SESSION_ERR_STALE) {
+            se->window_drops++;
+            rec->result = check;
+            continue;
+        }
+        if (check == SESSION_ERR_REPLAY) {
+            se->replay_drops++;
+            rec->result = check; // Replay attack
+            continue;
+        }
+        
+        msg_key_expand(K_i, &mk, counter);
+        
+        nonce[8] = (counter >> 24) & 0xFF;
+        nonce[9] = (counter >> 16) & 0xFF;
+        nonce[10] = (counter >> 8) & 0xFF;
+        nonce[11] = counter & 0xFF;
+        
+        /* Window updated per record: a duplicate later in the same batch
+         * is caught as a replay */
+        if (aead_decrypt(rec->out, &rec->out_len, rec->ct, rec->ct_len,
+                         se->sid, SID_LEN, K_i, nonce) == 0) {
+            replay_update(se, counter);
+            rec->result = SESSION_OK;
+            ok++;
+        } else {
+            rec->result = SESSION_ERR_AEAD;
+        }
     }
     
     secure_zero(K_i, sizeof(K_i));
-    return ret;
+    secure_zero(&mk, sizeof(mk));
+    return ok;
 }
@@ -0,0 +1,50 @@
+/**
+ * fec.h
+ * Systematic Cauchy Reed-Solomon Erasure Code over GF(2^8)
+ *
+ * A message of k equal-size data fragments D_0..D_{k-1} (the last one
+ * zero-padded) is extended with parity fragments
+ *     P_row = sum_col fec_coeff(k, row, col) * D_col
+ * computed bytewise. Data fragments go out unchanged; any k distinct
+ * fragments, data or parity, reconstruct the message.
+ */
+
+#ifndef FEC_H_
+#define FEC_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifndef THREAD_LOCAL
+#define THREAD_LOCAL                       // See crypto_core.h
+#endif
+
+#ifndef FEC_MAX_PARITY
+#define FEC_MAX_PARITY 32                  // Parity rows per message (and erasures decoded)
+#endif
+
+/**
+ * GF(2^8) multiply / inverse (gf256_inv(0) = 0)
+ */
+uint8_t gf256_mul(uint8_t a, uint8_t b);
+uint8_t gf256_inv(uint8_t a);
+
+/**
+ * Coefficient of data fragment col in parity row
+ * Requires k + row <= 255.
+ */
+uint8_t fec_coeff(uint8_t k, uint8_t row, uint8_t col);
+
+/**
+ * acc ^= coeff * src, bytewise
+ * Builds parity fragments (one call per data fragment) and syndromes.
+ */
+void fec_accumulate(uint8_t *acc, const uint8_t *src, size_t len, uint8_t coeff);
+
+/**
+ * Invert an n x n matrix (row-major) in place
+ * @returns 0 on success, -1 if singular or n > FEC_MAX_PARITY
+ */
+int fec_invert(uint8_t *m, uint8_t n);
+
+#endif /* FEC_H_ */
@@ -0,0 +1,66 @@
+/**
+ * gen_ring_tables.c
+ * Build-host generator for ring_tables.c
+ *
+ * Expands the deterministic ring polynomials - the shared element a and
+ * the ring member keys - with the same xorshift32 streams as
+ * ring_expand_a() / generate_ring_member_key(), and prints them as
+ * FLASH_CONST tables. Motes then neither spend boot time expanding them
+ * nor hold RAM copies. verification_test cross-checks the tables against
+ * the runtime generator.
+ *
+ *   cc -I. -o gen_ring_tables gen_ring_tables.c && ./gen_ring_tables > ring_tables.c
+ */
+
+#include <stdio.h>
+#include "crypto_core.h"
+
+static uint32_t xorshift32(uint32_t *state) {
+    uint32_t x = *state;
+    
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+/* One Poly512 initialiser, 6 coefficients per line */
+static void emit_poly(uint32_t seed, const char *indent) {
+    uint32_t state = seed;
+    int i;
+    
+    printf("{{");
+    for (i = 0; i < POLY_DEGREE; i++) {
+        if (i % 6 == 0) printf("%s\n%s    ", i ? "," : "", indent);
+        else printf(", ");
+        printf("%ld", (long)(xorshift32(&state) % MODULUS_Q));
+    }
+    printf("\n%s}}", indent);
+}
+
+int main(void) {
+    int i;
+    
+    printf("/* Generated by gen_ring_tables.c - do not edit */\n\n");
+    printf("#include \"crypto_core.h\"\n\n");
+    printf("#if POLY_DEGREE != %d || RING_SIZE != %d || MODULUS_Q != %ldL\n",
+           POLY_DEGREE, RING_SIZE, (long)MODULUS_Q);
+    printf("#error \"ring_tables.c is stale: rerun gen_ring_tables\"\n");
+    printf("#endif\n\n");
+    
+    printf("/* Shared ring element a (seed RING_A_SEED) */\n");
+    printf("FLASH_CONST Poly512 ring_a_table = ");
+    emit_poly(RING_A_SEED, "");
+    printf(";\n\n");
+    
+    printf("/* Ring member keys (seed RING_MEMBER_SEED(i)) */\n");
+    printf("FLASH_CONST Poly512 ring_member_table[RING_SIZE] = {\n");
+    for (i = 0; i < RING_SIZE; i++) {
+        printf("    ");
+        emit_poly(RING_MEMBER_SEED(i), "    ");
+        printf("%s\n", i + 1 < RING_SIZE ? "," : "");
+    }
+    printf("};\n");
+    return 0;
+}
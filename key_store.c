@@ -0,0 +1,219 @@
+/**
+ * key_store.c
+ * Persistent Gateway Key Material (Contiki CFS)
+ *
+ * One record, written once at provisioning: a header naming the build
+ * parameters, the two key pairs, and a SHA-256 digest over all of it.
+ * The key pairs are streamed straight to and from the caller's structs,
+ * so the store costs no RAM beyond a hash context. A reset during the
+ * write leaves a record that fails the check and the next boot simply
+ * provisions again; there is no second slot as in session_store.c.
+ *
+ * The ticket serial mark is different: losing it would reuse nonces, so
+ * it alternates between two slots with a sequence number, as
+ * session_store.c does, and a torn write leaves the previous mark.
+ */
+
+#include "key_store.h"
+#include "cfs/cfs.h"
+#include "sys/log.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_MODULE "KeyStore"
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+#define KEY_STORE_MAGIC 0x474B4559UL       // "GKEY"
+#define KEY_STORE_FILE "gw.keys"
+#define SERIAL_MAGIC 0x54534552UL          // "TSER"
+#define SERIAL_DIGEST_LEN 8
+
+typedef struct {
+    uint32_t magic;
+    uint32_t modulus;
+    uint16_t poly_degree;
+    uint16_t ldpc_rows;
+    uint16_t ldpc_cols;
+    uint16_t ring_size;
+} key_store_hdr_t;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint32_t limit;                        // First serial not yet reserved
+    uint8_t digest[SERIAL_DIGEST_LEN];
+} serial_record_t;
+
+static const char *serial_slots[2] = { "gw.ser.a", "gw.ser.b" };
+
+/* Last serial record written */
+static serial_record_t serial_rec;
+static uint8_t serial_next_slot;
+
+/* Header for this build: keys stored by a build with other parameters
+ * are not loaded */
+static void hdr_fill(key_store_hdr_t *h) {
+    memset(h, 0, sizeof(*h));
+    h->magic = KEY_STORE_MAGIC;
+    h->modulus = (uint32_t)MODULUS_Q;
+    h->poly_degree = POLY_DEGREE;
+    h->ldpc_rows = LDPC_ROWS;
+    h->ldpc_cols = LDPC_COLS;
+    h->ring_size = RING_SIZE;
+}
+
+static void record_digest(uint8_t *out, const key_store_hdr_t *h,
+                          const RingLWEKeyPair *ring_keypair,
+                          const LDPCKeyPair *ldpc_keypair) {
+    sha256_ctx_t hash;
+    
+    sha256_init(&hash);
+    sha256_update(&hash, (const uint8_t *)h, sizeof(*h));
+    sha256_update(&hash, (const uint8_t *)ring_keypair, sizeof(*ring_keypair));
+    sha256_update(&hash, (const uint8_t *)ldpc_keypair, sizeof(*ldpc_keypair));
+    sha256_final(&hash, out);
+}
+
+int key_store_load(RingLWEKeyPair *ring_keypair, LDPCKeyPair *ldpc_keypair) {
+    key_store_hdr_t hdr, expect;
+    uint8_t stored[SHA256_DIGEST_SIZE];
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    int fd, ok;
+    
+    fd = cfs_open(KEY_STORE_FILE, CFS_READ);
+    if (fd < 0) {
+        LOG_INFO("No stored keys\n");
+        return -1;
+    }
+    hdr_fill(&expect);
+    ok = cfs_read(fd, &hdr, sizeof(hdr)) == sizeof(hdr);
+    if (ok && memcmp(&hdr, &expect, sizeof(hdr)) != 0) {
+        LOG_WARN("Stored keys are for other parameters\n");
+        ok = 0;
+    }
+    ok = ok &&
+         cfs_read(fd, ring_keypair, sizeof(*ring_keypair)) == sizeof(*ring_keypair) &&
+         cfs_read(fd, ldpc_keypair, sizeof(*ldpc_keypair)) == sizeof(*ldpc_keypair) &&
+         cfs_read(fd, stored, sizeof(stored)) == sizeof(stored);
+    cfs_close(fd);
+    
+    if (ok) {
+        record_digest(digest, &hdr, ring_keypair, ldpc_keypair);
+        ok = constant_time_compare(digest, stored, SHA256_DIGEST_SIZE) == 0;
+        if (!ok) LOG_WARN("Stored keys fail the integrity check\n");
+    }
+    if (!ok) {
+        secure_zero(ring_keypair, sizeof(*ring_keypair));
+        secure_zero(ldpc_keypair, sizeof(*ldpc_keypair));
+        return -1;
+    }
+    LOG_INFO("Restored gateway keys\n");
+    return 0;
+}
+
+int key_store_save(const RingLWEKeyPair *ring_keypair, const LDPCKeyPair *ldpc_keypair) {
+    key_store_hdr_t hdr;
+    uint8_t digest[SHA256_DIGEST_SIZE];
+    int fd, ok;
+    
+    hdr_fill(&hdr);
+    record_digest(digest, &hdr, ring_keypair, ldpc_keypair);
+    
+    /* Replace rather than overwrite, so no stale tail can follow the record */
+    cfs_remove(KEY_STORE_FILE);
+    fd = cfs_open(KEY_STORE_FILE, CFS_WRITE);
+    if (fd < 0) {
+        LOG_ERR("Cannot open %s\n", KEY_STORE_FILE);
+        return -1;
+    }
+    ok = cfs_write(fd, &hdr, sizeof(hdr)) == sizeof(hdr) &&
+         cfs_write(fd, ring_keypair, sizeof(*ring_keypair)) == sizeof(*ring_keypair) &&
+         cfs_write(fd, ldpc_keypair, sizeof(*ldpc_keypair)) == sizeof(*ldpc_keypair) &&
+         cfs_write(fd, digest, sizeof(digest)) == sizeof(digest);
+    cfs_close(fd);
+    
+    if (!ok) {
+        LOG_ERR("Short write to %s\n", KEY_STORE_FILE);
+        cfs_remove(KEY_STORE_FILE);
+        return -1;
+    }
+    LOG_INFO("Gateway keys stored (%u bytes)\n",
+             (unsigned)(sizeof(hdr) + sizeof(*ring_keypair) + sizeof(*ldpc_keypair) +
+                        sizeof(digest)));
+    return 0;
+}
+
+void key_store_clear(void) {
+    cfs_remove(KEY_STORE_FILE);
+}
+
+/* ========== TICKET SERIALS ========== */
+
+static void serial_digest(uint8_t *out, const serial_record_t *r) {
+    uint8_t h[SHA256_DIGEST_SIZE];
+    sha256_hash(h, (const uint8_t *)r, offsetof(serial_record_t, digest));
+    memcpy(out, h, SERIAL_DIGEST_LEN);
+}
+
+static int serial_read(int slot, serial_record_t *r) {
+    uint8_t d[SERIAL_DIGEST_LEN];
+    int fd = cfs_open(serial_slots[slot], CFS_READ);
+    int n;
+    
+    if (fd < 0) return -1;
+    n = cfs_read(fd, r, sizeof(*r));
+    cfs_close(fd);
+    if (n != sizeof(*r) || r->magic != SERIAL_MAGIC) return -1;
+    serial_digest(d, r);
+    return memcmp(d, r->digest, SERIAL_DIGEST_LEN) == 0 ? 0 : -1;
+}
+
+static int serial_commit(uint32_t limit) {
+    int fd, n;
+    
+    serial_rec.magic = SERIAL_MAGIC;
+    serial_rec.seq++;
+    serial_rec.limit = limit;
+    serial_digest(serial_rec.digest, &serial_rec);
+    
+    fd = cfs_open(serial_slots[serial_next_slot], CFS_WRITE);
+    if (fd < 0) {
+        LOG_ERR("Cannot open %s\n", serial_slots[serial_next_slot]);
+        return -1;
+    }
+    n = cfs_write(fd, &serial_rec, sizeof(serial_rec));
+    cfs_close(fd);
+    if (n != sizeof(serial_rec)) {
+        LOG_ERR("Short write to %s\n", serial_slots[serial_next_slot]);
+        return -1;
+    }
+    serial_next_slot ^= 1;
+    return 0;
+}
+
+int key_store_serial_load(uint32_t *serial) {
+    serial_record_t slot[2];
+    int ok0 = (serial_read(0, &slot[0]) == 0);
+    int ok1 = (serial_read(1, &slot[1]) == 0);
+    
+    memset(&serial_rec, 0, sizeof(serial_rec));
+    serial_next_slot = 0;
+    if (ok0 || ok1) {
+        int best = (ok0 && (!ok1 || slot[0].seq >= slot[1].seq)) ? 0 : 1;
+        serial_rec = slot[best];
+        serial_next_slot = best ^ 1;
+    }
+    /* Everything below the stored limit may have been sealed */
+    *serial = serial_rec.limit;
+    LOG_INFO("Ticket serials continue at %lu\n", (unsigned long)*serial);
+    return serial_commit(*serial + KEY_STORE_SERIAL_BLOCK);
+}
+
+int key_store_serial_reserve(uint32_t serial) {
+    if (serial < serial_rec.limit) {
+        return 0;
+    }
+    /* Block exhausted: checkpoint the next limit before sealing */
+    return serial_commit(serial + KEY_STORE_SERIAL_BLOCK);
+}
@@ -0,0 +1,60 @@
+/**
+ * key_store.h
+ * Persistent Gateway Key Material (Contiki CFS)
+ *
+ * Keeps the gateway's long-term Ring-LWE and LDPC key pairs in flash so
+ * a watchdog reset does not rerun keygen: keys are generated once, at
+ * provisioning (first boot, or when the stored record fails its
+ * integrity check), and loaded on every later boot. On the native target
+ * CFS is file-backed (cfs-posix); linux_gateway's shim maps it to files.
+ * Only this n=128 tree and gatewayd use it: the n=512 and n=32 variants
+ * still run keygen at every boot.
+ *
+ * Ticket keys are derived deterministically, so the store also keeps a
+ * high-water mark of issued ticket serials. Serials are reserved in
+ * blocks as session_store.h reserves counters: a restart continues above
+ * every serial ever sealed and no (key epoch, serial) nonce is reused.
+ */
+
+#ifndef KEY_STORE_H_
+#define KEY_STORE_H_
+
+#include "crypto_core.h"
+
+#ifndef KEY_STORE_SERIAL_BLOCK
+#define KEY_STORE_SERIAL_BLOCK 32          // Ticket serials reserved per flash write
+#endif
+
+/**
+ * Load the stored key pairs
+ * The record is rejected if its digest does not match or it was written
+ * by a build with other parameters (n, q, ring size, LDPC dimensions).
+ * @returns 0 if both key pairs were restored, -1 if the gateway must provision
+ */
+int key_store_load(RingLWEKeyPair *ring_keypair, LDPCKeyPair *ldpc_keypair);
+
+/**
+ * Persist freshly generated key pairs (provisioning)
+ */
+int key_store_save(const RingLWEKeyPair *ring_keypair, const LDPCKeyPair *ldpc_keypair);
+
+/**
+ * Erase the stored key pairs (the next boot provisions again)
+ */
+void key_store_clear(void);
+
+/**
+ * Load the ticket serial high-water mark and reserve the first block
+ * @param serial: Receives the first serial this boot may seal (0 if none stored)
+ * @returns 0, or -1 if the block could not be reserved (issue no tickets)
+ */
+int key_store_serial_load(uint32_t *serial);
+
+/**
+ * Make sure serial is covered by the reserved block
+ * Call before sealing every ticket; writes flash only when a block runs out.
+ * @returns 0 if the serial may be used, -1 if the checkpoint write failed
+ */
+int key_store_serial_reserve(uint32_t serial);
+
+#endif /* KEY_STORE_H_ */
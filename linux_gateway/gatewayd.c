@@ -0,0 +1,1261 @@
+/**
+ * gatewayd.c
+ * Multi-Core Linux Gateway Daemon
+ *
+ * Speaks the node-gateway.c wire protocol (AUTH_FRAG / AUTH_FEC ->
+ * FRAG_ACK, AUTH_ACK, DATA, SESSION_UNKNOWN, RESUME -> RESUME_ACK,
+ * KEY_UPDATE -> KEY_UPDATE_ACK) on top of the shared crypto_core,
+ * crypto_core_session and reassembly sources.
+ *
+ * One worker thread per core, each with its own SO_REUSEPORT UDP socket
+ * and epoll loop. The kernel hashes a sender's 4-tuple to one socket, so
+ * every fragment of a handshake reaches the same worker, which keeps its
+ * reassembly pool, PRNG and AES key schedule thread-local. Sessions are
+ * sharded by SID (sessions.h): a worker creates them in its own shard and
+ * any worker can look one up, e.g. after the sender's port changed.
+ *
+ * Work is split into two priority classes (pool.h). DATA records are
+ * decrypted by the receiving worker before anything else. A completed
+ * AUTH is copied out of the reassembly pool into a handshake task that
+ * any idle worker may steal, and is verified one ring_verify_step()
+ * slice at a time between socket reads, so a handshake flood delays
+ * DATA by at most one slice.
+ *
+ * I/O is batched: one recvmmsg() reads up to a batch of datagrams, the
+ * DATA records among them are grouped by SID for one session lookup and
+ * one session_decrypt_batch() per session, and every reply (FRAG_ACK,
+ * AUTH_ACK, SESSION_UNKNOWN, RESUME_ACK, KEY_UPDATE_ACK) is queued for a
+ * single sendmmsg().
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "crypto_core.h"
+#include "key_store.h"
+#include "pool.h"
+#include "reassembly.h"
+#include "sessions.h"
+#include "wire.h"
+#include "sys/log.h"
+
+#define LOG_MODULE "Gatewayd"
+#define LOG_LEVEL LOG_LEVEL_DBG
+
+#define MAX_WORKERS 256                    // Shards are addressed by one SID byte
+#define RX_BUF_SIZE 2048
+#define SOCKET_RCVBUF (4 * 1024 * 1024)
+#define STATUS_INTERVAL 60                 // Seconds between status lines
+#define RX_BATCH 64                        // Datagrams per recvmmsg() (-b lowers it)
+#define TX_BATCH 64                        // Replies per sendmmsg()
+#define TX_MSG_MAX sizeof(reply_msg_t)     // Largest reply
+#define DEFAULT_SESSIONS 4096              // Per shard
+#define TICKET_SECRET_FILE "gw.ticket"     // Random ticket secret, 0600
+#define REDEEMED_CACHE 4096                // Redeemed ticket serials remembered (all workers)
+
+/* Largest fragment we accept: no 6LoWPAN below us, the shared limit only */
+#define GATEWAY_MAX_FRAG_SIZE AUTH_FRAG_MAX_SIZE
+
+/* ========== TASKS ========== */
+
+/* DATA record waiting for its worker's decrypt pass */
+typedef struct {
+    pool_task_t task;
+    struct sockaddr_in6 peer;
+    uint16_t len;
+    uint8_t data[DATA_HDR_LEN + MESSAGE_MAX_SIZE + AEAD_TAG_LEN];
+} data_task_t;
+
+/* Complete AUTH, copied out of the receiving worker's thread-local
+ * reassembly pool so that any worker can verify it */
+typedef struct {
+    pool_task_t task;
+    struct sockaddr_in6 peer;
+    ring_verify_ctx_t verify_ctx;
+    AuthMessageView auth_view;
+    PolyView verify_keys[RING_SIZE];
+    int started;
+    uint8_t wire[AUTH_MSG_WIRE_LEN];
+} handshake_task_t;
+
+/* ========== WORKER STATE ========== */
+
+typedef union {
+    AuthAckMessage auth_ack;
+    ResumeAckMessage resume_ack;
+    KeyUpdateAckMessage key_update_ack;
+} reply_msg_t;
+
+typedef struct {
+    pthread_t thread;
+    unsigned id;                           // Also the worker's session shard
+    int fd;
+    int epfd;
+    uint64_t rx_ns;                        // Kernel timestamp of the packet in hand
+    handshake_task_t *current;             // Handshake being verified, if any
+    data_task_t *data_free;                // Recycled DATA tasks (never stolen: owner only)
+    /* Replies waiting for the next sendmmsg() */
+    struct mmsghdr tx_msgs[TX_BATCH];
+    struct iovec tx_iov[TX_BATCH];
+    struct sockaddr_in6 tx_peer[TX_BATCH];
+    uint8_t tx_buf[TX_BATCH][TX_MSG_MAX];
+    unsigned tx_count;
+    /* Ticket keys of the current and previous wall-clock epochs, from
+     * the shared secret */
+    uint8_t ticket_key[32];
+    uint8_t ticket_key_prev[32];
+    uint32_t ticket_epoch;
+    /* Statistics */
+    uint64_t rx_packets;
+    uint64_t rx_calls;                     // recvmmsg() calls that returned data
+    uint64_t tx_packets;
+    uint64_t tx_calls;
+    uint64_t cpu_ns;                       // Thread CPU time, set on exit
+    uint64_t data_ok;
+    uint64_t data_drops;
+    uint64_t handshakes_ok;
+    uint64_t handshakes_failed;
+    uint64_t resumes;
+    uint64_t key_updates;
+    int handshakes_peak;
+} worker_t;
+
+static worker_t *workers;
+static unsigned worker_count;
+static volatile sig_atomic_t stopping;
+static struct timespec boot_time;
+static int inline_handshakes;              // -i: verify on arrival, no pool (comparison)
+static unsigned io_batch = RX_BATCH;       // -b: datagrams per recvmmsg() / sendmmsg()
+static int no_key_store;                   // -k: keygen at every start (comparison)
+static int keys_stored;                    // Keys came from the key store
+
+/* ========== CRYPTOGRAPHIC STATE (read-only once workers run) ========== */
+
+static RingLWEKeyPair gateway_keypair;
+static LDPCKeyPair gateway_ldpc_keypair;
+static uint8_t ticket_secret[SHA256_DIGEST_SIZE];
+static uint32_t ticket_serial;             // Next serial, under ticket_lock
+static int ticket_serial_ok;               // Serials reserved in the key store
+static pthread_mutex_t ticket_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Serials of redeemed tickets, under ticket_lock. When the cache is full
+ * the lowest serial is dropped and every serial up to it is refused from
+ * then on, as on the Contiki gateway. The cache is not stored: a ticket
+ * redeemed before a restart can be replayed once, which retires the
+ * session it was issued for but yields no usable key. */
+static uint32_t redeemed_serials[REDEEMED_CACHE];
+static unsigned redeemed_count;
+static uint32_t redeemed_floor;
+
+/* ========== HELPERS ========== */
+
+static double ms_since_boot(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - boot_time.tv_sec) * 1e3 + (now.tv_nsec - boot_time.tv_nsec) / 1e6;
+}
+
+static uint32_t uptime(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)(now.tv_sec - boot_time.tv_sec);
+}
+
+static void random_bytes(uint8_t *buf, size_t len) {
+    if (getrandom(buf, len, 0) != (ssize_t)len) {
+        crypto_secure_random(buf, len);
+    }
+}
+
+/* Reassembly is keyed by a 16-byte peer address; here a peer is address
+ * and port (many senders share 127.0.0.1 / ::1 in tests, or a NAT) */
+static void peer_key(uint8_t key[16], const struct sockaddr_in6 *peer) {
+    uint8_t in[18];
+    uint8_t digest[SHA256_DIGEST_SIZE];
+
+    memcpy(in, &peer->sin6_addr, 16);
+    memcpy(in + 16, &peer->sin6_port, 2);
+    sha256_hash(digest, in, sizeof(in));
+    memcpy(key, digest, 16);
+}
+
+/* ========== REPLIES ========== */
+
+static void tx_init(worker_t *w) {
+    unsigned i;
+
+    memset(w->tx_msgs, 0, sizeof(w->tx_msgs));
+    for (i = 0; i < TX_BATCH; i++) {
+        w->tx_iov[i].iov_base = w->tx_buf[i];
+        w->tx_msgs[i].msg_hdr.msg_name = &w->tx_peer[i];
+        w->tx_msgs[i].msg_hdr.msg_namelen = sizeof(w->tx_peer[i]);
+        w->tx_msgs[i].msg_hdr.msg_iov = &w->tx_iov[i];
+        w->tx_msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+static void tx_flush(worker_t *w) {
+    unsigned sent = 0;
+
+    while (sent < w->tx_count) {
+        int n = sendmmsg(w->fd, &w->tx_msgs[sent], w->tx_count - sent, 0);
+        if (n < 0) {
+            /* The reply at 'sent' failed: skip it, the sender retransmits */
+            LOG_WARN("[w%u] sendmmsg: %s\n", w->id, strerror(errno));
+            n = 1;
+        }
+        sent += (unsigned)n;
+    }
+    w->tx_packets += w->tx_count;
+    w->tx_calls++;
+    w->tx_count = 0;
+}
+
+/* Queue a reply; it leaves with the rest of this batch */
+static void send_to(worker_t *w, const void *msg, size_t len,
+                    const struct sockaddr_in6 *peer) {
+    unsigned i = w->tx_count;
+
+    memcpy(w->tx_buf[i], msg, len);
+    w->tx_iov[i].iov_len = len;
+    w->tx_peer[i] = *peer;
+    if (++w->tx_count >= io_batch) {
+        tx_flush(w);
+    }
+}
+
+/* ========== TICKETS ========== */
+
+/* The ticket secret is this daemon's own: random, kept in
+ * TICKET_SECRET_FILE, and never shared with the Contiki gateway, whose
+ * keys come from a fixed seed. Seal nonces are (epoch, serial); the
+ * serial continues across restarts through the key store's high-water
+ * mark. A stored secret without a serial mark (the mark was lost) is
+ * replaced, as its serials may already have been used. */
+static int ticket_keys_init(void) {
+    int fd, loaded = 0;
+
+    ticket_serial_ok = (key_store_serial_load(&ticket_serial) == 0);
+    if (!ticket_serial_ok) {
+        LOG_WARN("Ticket serials not reserved, AUTH_ACK carries no ticket\n");
+    }
+
+    fd = open(TICKET_SECRET_FILE, O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        loaded = read(fd, ticket_secret, sizeof(ticket_secret)) ==
+                 (ssize_t)sizeof(ticket_secret) && ticket_serial > 0;
+        close(fd);
+    }
+    if (loaded) return 0;
+
+    if (getrandom(ticket_secret, sizeof(ticket_secret), 0) !=
+        (ssize_t)sizeof(ticket_secret)) {
+        return -1;
+    }
+    fd = open(TICKET_SECRET_FILE, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0 ||
+        write(fd, ticket_secret, sizeof(ticket_secret)) != (ssize_t)sizeof(ticket_secret) ||
+        fsync(fd) != 0) {
+        /* Tickets issued now would not open after a restart */
+        LOG_WARN("Cannot store %s: %s\n", TICKET_SECRET_FILE, strerror(errno));
+    }
+    if (fd >= 0) close(fd);
+    return 0;
+}
+
+/* Wall clock, so tickets keep their expiry across restarts */
+static uint32_t ticket_epoch_now(void) {
+    return (uint32_t)(time(NULL) / TICKET_KEY_ROTATION);
+}
+
+/* Next serial, reserving a new block in the key store when one runs out */
+static int ticket_serial_next(uint32_t *serial) {
+    int ret = -1;
+
+    pthread_mutex_lock(&ticket_lock);
+    if (ticket_serial_ok && key_store_serial_reserve(ticket_serial) == 0) {
+        *serial = ticket_serial++;
+        ret = 0;
+    } else {
+        ticket_serial_ok = 0;
+    }
+    pthread_mutex_unlock(&ticket_lock);
+    return ret;
+}
+
+static void ticket_keys_rotate(worker_t *w, uint32_t epoch) {
+    if (epoch == w->ticket_epoch) return;
+    if (epoch == w->ticket_epoch + 1) {
+        memcpy(w->ticket_key_prev, w->ticket_key, sizeof(w->ticket_key));
+    } else {
+        ticket_key_derive(w->ticket_key_prev, ticket_secret, epoch - 1);
+    }
+    ticket_key_derive(w->ticket_key, ticket_secret, epoch);
+    w->ticket_epoch = epoch;
+}
+
+/* Without a serial the ticket is left zeroed: it never opens and the
+ * sender falls back to a full handshake */
+static void ticket_issue(worker_t *w, uint8_t *ticket, const session_entry_t *se) {
+    session_ticket_state_t st;
+    uint32_t serial;
+
+    if (ticket_serial_next(&serial) != 0) {
+        memset(ticket, 0, TICKET_LEN);
+        return;
+    }
+
+    memcpy(st.K_master, se->K_master, MASTER_KEY_LEN);
+    memcpy(st.sid, se->sid, SID_LEN);
+    st.counter = se->last_seq;
+    st.expiry_epoch = w->ticket_epoch + TICKET_LIFETIME_EPOCHS;
+    st.resume_count = se->resume_count;
+
+    ticket_seal(ticket, &st, w->ticket_key, w->ticket_epoch, serial);
+    secure_zero(&st, sizeof(st));
+}
+
+/* Opens a ticket sealed under the current or the previous epoch key.
+ * Epochs follow the wall clock on every worker, so there is nothing to
+ * fast-forward as on the Contiki gateway. */
+static int ticket_redeem(worker_t *w, session_ticket_state_t *st, const uint8_t *ticket) {
+    uint32_t epoch = ticket_key_epoch(ticket);
+
+    if (epoch == w->ticket_epoch) {
+        if (ticket_open(st, ticket, w->ticket_key) != 0) return -1;
+    } else if (epoch + 1 == w->ticket_epoch) {
+        if (ticket_open(st, ticket, w->ticket_key_prev) != 0) return -1;
+    } else {
+        return -1;
+    }
+
+    if (st->expiry_epoch < w->ticket_epoch) {
+        secure_zero(st, sizeof(*st));
+        return -1;
+    }
+    return 0;
+}
+
+/* Marks a serial redeemed. Check and mark are one step, so two workers
+ * cannot both accept the same ticket.
+ * @returns 0, or -1 if it was redeemed before */
+static int ticket_claim(uint32_t serial) {
+    unsigned i, low = 0;
+    int ret = 0;
+
+    pthread_mutex_lock(&ticket_lock);
+    if (serial < redeemed_floor) {
+        ret = -1;
+    }
+    for (i = 0; ret == 0 && i < redeemed_count; i++) {
+        if (redeemed_serials[i] == serial) ret = -1;
+    }
+    if (ret == 0 && redeemed_count < REDEEMED_CACHE) {
+        redeemed_serials[redeemed_count++] = serial;
+    } else if (ret == 0) {
+        /* Full: raise the floor past the lowest serial and reuse its slot */
+        for (i = 1; i < REDEEMED_CACHE; i++) {
+            if (redeemed_serials[i] < redeemed_serials[low]) low = i;
+        }
+        redeemed_floor = redeemed_serials[low] + 1;
+        redeemed_serials[low] = serial;
+    }
+    pthread_mutex_unlock(&ticket_lock);
+    return ret;
+}
+
+/* ========== HANDSHAKE ========== */
+
+static void handshake_started(worker_t *w) {
+    int active = reassembly_in_use();
+
+    if (active > w->handshakes_peak) {
+        w->handshakes_peak = active;
+    }
+    LOG_DBG("[w%u] handshake started, active=%d\n", w->id, active);
+}
+
+/* Ring signature OK: LDPC, session in the receiving worker's shard
+ * (where the peer's DATA arrives), AUTH_ACK */
+static void handshake_finish(worker_t *w, handshake_task_t *t) {
+    ErrorVector recovered_error;
+    AuthAckMessage ack_msg;
+    uint8_t K_master[MASTER_KEY_LEN];
+    gw_session_t *s;
+
+    if (sldspa_decode(&recovered_error, t->auth_view.syndrome, &gateway_ldpc_keypair) != 0) {
+        LOG_WARN("[w%u] LDPC decoding failed\n", w->id);
+        w->handshakes_failed++;
+        return;
+    }
+
+    ack_msg.type = MSG_TYPE_AUTH_ACK;
+    random_bytes(ack_msg.N_G, sizeof(ack_msg.N_G));
+    derive_master_key(K_master, recovered_error.bits, sizeof(recovered_error.bits),
+                      ack_msg.N_G, sizeof(ack_msg.N_G));
+    secure_zero(&recovered_error, sizeof(recovered_error));
+
+    s = sessions_create(t->task.owner, K_master, &t->peer, uptime());
+    memcpy(ack_msg.SID, s->se.sid, SID_LEN);
+    ticket_issue(w, ack_msg.ticket, &s->se);
+    sessions_unlock(s);
+    secure_zero(K_master, sizeof(K_master));
+
+    /* All workers' sockets share the port, so any of them can answer */
+    send_to(w, &ack_msg, sizeof(ack_msg), &t->peer);
+    LOG_DBG("[w%u] session [%02x%02x%02x%02x...] established\n", w->id,
+            ack_msg.SID[0], ack_msg.SID[1], ack_msg.SID[2], ack_msg.SID[3]);
+    w->handshakes_ok++;
+}
+
+/* One verification slice
+ * @returns 0 while pending, 1 when the handshake is finished (either way) */
+static int handshake_step(worker_t *w, handshake_task_t *t) {
+    int verify_result;
+    int i;
+
+    if (!t->started) {
+        auth_msg_view(&t->auth_view, t->wire, sizeof(t->wire));
+        /* Received public key is ring member 0 */
+        t->verify_keys[0] = t->auth_view.public_key;
+        for (i = 1; i < RING_SIZE; i++) {
+            t->verify_keys[i] = poly_view(&ring_member_table[i]);
+        }
+        t->started = 1;
+        verify_result = ring_verify_view_start(&t->verify_ctx, &t->auth_view.signature,
+                                               t->verify_keys);
+    } else {
+        verify_result = ring_verify_step(&t->verify_ctx);
+    }
+    if (verify_result == RING_VERIFY_PENDING) return 0;
+
+    secure_zero(&t->verify_ctx, sizeof(t->verify_ctx));
+    if (verify_result != 1) {
+        LOG_WARN("[w%u] ring signature verification FAILED\n", w->id);
+        w->handshakes_failed++;
+        return 1;
+    }
+    handshake_finish(w, t);
+    return 1;
+}
+
+static void handshake_done(worker_t *w, handshake_task_t *t) {
+    pool_done(w->id, &t->task);
+    free(t);
+}
+
+/* Complete AUTH: erasure-decode in place, then hand a copy to the pool
+ * and give the reassembly context back (it lives in this thread's pool) */
+static void handshake_queue(worker_t *w, reassembly_ctx_t *ctx,
+                            const struct sockaddr_in6 *peer) {
+    handshake_task_t *t;
+
+    reassembly_take(ctx);
+
+    if (ctx->coded && ctx->parity_count > 0 && reassembly_fec_decode(ctx) != 0) {
+        LOG_WARN("[w%u] erasure decoding failed\n", w->id);
+        goto failed;
+    }
+    if (ctx->length != AUTH_MSG_WIRE_LEN) {
+        LOG_WARN("[w%u] AUTH payload has %u bytes, expected %u\n", w->id,
+                 (unsigned)ctx->length, (unsigned)AUTH_MSG_WIRE_LEN);
+        goto failed;
+    }
+    t = malloc(sizeof(*t));
+    if (t == NULL) {
+        LOG_WARN("[w%u] no memory for a handshake task\n", w->id);
+        goto failed;
+    }
+    t->task.cls = POOL_CLASS_HANDSHAKE;
+    t->task.enqueued_ns = w->rx_ns;
+    t->task.owner = (uint16_t)w->id;
+    t->peer = *peer;
+    t->started = 0;
+    memcpy(t->wire, ctx->buf, AUTH_MSG_WIRE_LEN);
+    reassembly_release(ctx);
+
+    if (inline_handshakes) {
+        while (!handshake_step(w, t)) {
+        }
+        handshake_done(w, t);
+    } else if (pool_push(w->id, &t->task) != 0) {
+        /* Filled up since the last fragment was admitted: the sender
+         * times out waiting for AUTH_ACK and tries again */
+        LOG_DBG("[w%u] handshake queue full, AUTH dropped\n", w->id);
+        free(t);
+    }
+    return;
+
+failed:
+    w->handshakes_failed++;
+    reassembly_release(ctx);
+}
+
+/* ========== MESSAGE HANDLERS ========== */
+
+static void handle_auth_frag(worker_t *w, const uint8_t *data, size_t datalen,
+                             const struct sockaddr_in6 *peer) {
+    const AuthFragment *frag = (const AuthFragment *)data;
+    uint16_t handshake_id = ntohs(frag->session_id);
+    uint16_t frag_size = ntohs(frag->frag_size);
+    reassembly_ctx_t *ctx;
+    uint8_t key[16];
+    uint8_t created;
+    FragmentAck ack;
+    uint16_t cum_ack = 0;
+    uint32_t sack = 0;
+    int ret;
+
+    if (datalen < AUTH_FRAG_HDR_LEN) return;
+    /* Handshake queue full: drop unacknowledged, the sender retransmits */
+    if (!inline_handshakes && !pool_admit(w->id, POOL_CLASS_HANDSHAKE)) {
+        pool_drop(w->id, POOL_CLASS_HANDSHAKE);
+        return;
+    }
+
+    peer_key(key, peer);
+    ret = reassembly_add(key, handshake_id, frag->fragment_id, frag->total_frags,
+                         frag_size, frag->payload, datalen - AUTH_FRAG_HDR_LEN,
+                         uptime(), &ctx, &created);
+
+    /* No ACK when the fragment was not stored: the sender retransmits */
+    if (ret == REASSEMBLY_ERR_FULL || ret == REASSEMBLY_ERR_INVALID) {
+        LOG_DBG("[w%u] fragment %u of %04x dropped (%d)\n", w->id,
+                (unsigned)frag->fragment_id, handshake_id, ret);
+        return;
+    }
+    if (ret == REASSEMBLY_STALE) {
+        /* Late retransmit of a finished handshake: all of it is in */
+        cum_ack = frag->total_frags;
+    } else if (ret != REASSEMBLY_ERR_FRAG_SIZE) {
+        if (created) {
+            handshake_started(w);
+        }
+        reassembly_ack_state(ctx, &cum_ack, &sack);
+    }
+
+    ack.type = MSG_TYPE_FRAG_ACK;
+    ack.handshake_id = frag->session_id;
+    ack.fragment_id = frag->fragment_id;
+    ack.cum_ack = cum_ack;
+    ack.sack = htonl(sack);
+    ack.max_frag_size = htons(reassembly_max_frag_size());
+    send_to(w, &ack, sizeof(ack), peer);
+
+    if (ret == REASSEMBLY_COMPLETE) {
+        handshake_queue(w, ctx, peer);
+    }
+}
+
+static void handle_auth_fec(worker_t *w, const uint8_t *data, size_t datalen,
+                            const struct sockaddr_in6 *peer) {
+    const AuthFecFragment *frag = (const AuthFecFragment *)data;
+    uint16_t handshake_id = ntohs(frag->session_id);
+    reassembly_ctx_t *ctx;
+    uint8_t key[16];
+    uint8_t created;
+    FragmentAck ack;
+    int ret;
+
+    if (datalen < AUTH_FEC_HDR_LEN) return;
+    if (!inline_handshakes && !pool_admit(w->id, POOL_CLASS_HANDSHAKE)) {
+        pool_drop(w->id, POOL_CLASS_HANDSHAKE);
+        return;
+    }
+
+    peer_key(key, peer);
+    ret = reassembly_add_coded(key, handshake_id, frag->fragment_id, frag->k,
+                               ntohs(frag->frag_size), ntohs(frag->payload_len),
+                               frag->payload, datalen - AUTH_FEC_HDR_LEN,
+                               uptime(), &ctx, &created);
+
+    if (ret == REASSEMBLY_ERR_FULL || ret == REASSEMBLY_ERR_INVALID) {
+        return;
+    }
+    if (created) {
+        handshake_started(w);
+    }
+    /* Only the fragment completing the set (or a late one) is answered */
+    if (ret == REASSEMBLY_PENDING ||
+        (ret == REASSEMBLY_DUPLICATE && ctx->state == REASSEMBLY_RECEIVING)) {
+        return;
+    }
+
+    memset(&ack, 0, sizeof(ack));
+    ack.type = MSG_TYPE_FRAG_ACK;
+    ack.handshake_id = frag->session_id;
+    ack.fragment_id = frag->fragment_id;
+    if (ret == REASSEMBLY_STALE) {
+        /* Late parity of a finished handshake: repeat the answer */
+        ack.cum_ack = frag->k;
+        ack.sack = htonl(frag->fragment_id);
+    } else if (ret != REASSEMBLY_ERR_FRAG_SIZE) {
+        ack.cum_ack = frag->k;
+        ack.sack = htonl(ctx->max_coded_id);
+    }
+    ack.max_frag_size = htons(reassembly_max_frag_size());
+    send_to(w, &ack, sizeof(ack), peer);
+
+    if (ret == REASSEMBLY_COMPLETE) {
+        handshake_queue(w, ctx, peer);
+    }
+}
+
+/* ========== RESUMPTION AND KEY UPDATE ========== */
+
+/* 1-RTT resumption from a ticket. The resumed session goes into the
+ * receiving worker's shard, as a handshake's does. */
+static void handle_resume(worker_t *w, const uint8_t *data, size_t datalen,
+                          const struct sockaddr_in6 *peer) {
+    const ResumeMessage *req = (const ResumeMessage *)data;
+    session_ticket_state_t st;
+    ResumeAckMessage rack;
+    uint8_t binder[RESUME_BINDER_LEN];
+    uint8_t K_master[MASTER_KEY_LEN];
+    gw_session_t *s;
+
+    if (datalen < sizeof(ResumeMessage)) return;
+    if (ticket_redeem(w, &st, req->ticket) != 0) {
+        LOG_DBG("[w%u] resumption ticket rejected\n", w->id);
+        return;
+    }
+
+    /* One use per ticket, claimed only once the binder proves the sender
+     * holds the ticket's K_master */
+    resume_binder(binder, st.K_master, req->ticket, req->N_S);
+    if (constant_time_compare(binder, req->binder, RESUME_BINDER_LEN) != 0 ||
+        st.resume_count >= TICKET_MAX_RESUMES ||
+        ticket_claim(ticket_serial_of(req->ticket)) != 0) {
+        LOG_DBG("[w%u] resumption refused (binder/limit/redeemed)\n", w->id);
+        secure_zero(&st, sizeof(st));
+        return;
+    }
+
+    /* Retire the old SID if it is still live */
+    s = sessions_find(st.sid, uptime());
+    if (s != NULL) {
+        sessions_retire(s);
+    }
+
+    rack.type = MSG_TYPE_RESUME_ACK;
+    random_bytes(rack.N_G, sizeof(rack.N_G));
+    derive_resumed_master_key(K_master, st.K_master, req->N_S, rack.N_G);
+
+    s = sessions_create(w->id, K_master, peer, uptime());
+    s->se.resume_count = st.resume_count + 1;
+    memcpy(rack.SID, s->se.sid, SID_LEN);
+    ticket_issue(w, rack.ticket, &s->se);
+    sessions_unlock(s);
+    resume_confirm(rack.confirm, K_master, rack.type, rack.N_G, rack.SID, rack.ticket);
+    secure_zero(&st, sizeof(st));
+    secure_zero(K_master, sizeof(K_master));
+
+    send_to(w, &rack, sizeof(rack), peer);
+    LOG_DBG("[w%u] session [%02x%02x%02x%02x...] resumed\n", w->id,
+            rack.SID[0], rack.SID[1], rack.SID[2], rack.SID[3]);
+    w->resumes++;
+}
+
+/* In-session ratchet to epoch + 1, or a re-ACK if our ACK was lost */
+static void handle_key_update(worker_t *w, const uint8_t *data, size_t datalen,
+                              const struct sockaddr_in6 *peer) {
+    const KeyUpdateMessage *ku = (const KeyUpdateMessage *)data;
+    KeyUpdateAckMessage kack;
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+    uint16_t epoch;
+    gw_session_t *s;
+
+    if (datalen < sizeof(KeyUpdateMessage)) return;
+    epoch = ((uint16_t)ku->epoch[0] << 8) | ku->epoch[1];
+    s = sessions_find(ku->SID, uptime());
+    if (s == NULL) {
+        LOG_DBG("[w%u] KEY_UPDATE for unknown session\n", w->id);
+        return;
+    }
+
+    if (epoch == (uint16_t)(s->se.epoch + 1)) {
+        uint8_t K_next[MASTER_KEY_LEN];
+
+        session_ratchet_key(K_next, s->se.K_master, s->se.sid, epoch);
+        key_update_tag(tag, K_next, s->se.sid, epoch, KEY_UPDATE_REQ);
+        if (constant_time_compare(tag, ku->tag, KEY_UPDATE_TAG_LEN) != 0) {
+            secure_zero(K_next, sizeof(K_next));
+            sessions_unlock(s);
+            LOG_WARN("[w%u] KEY_UPDATE tag mismatch\n", w->id);
+            return;
+        }
+
+        /* Commit; the old epoch stays decryptable until DATA shows the
+         * sender has switched. Counters restart under the new key. */
+        s->prev = s->se;
+        memcpy(s->se.K_master, K_next, MASTER_KEY_LEN);
+        secure_zero(K_next, sizeof(K_next));
+        s->se.epoch = epoch;
+        replay_window_reset(&s->se);
+        w->key_updates++;
+    } else if (epoch == s->se.epoch) {
+        key_update_tag(tag, s->se.K_master, s->se.sid, epoch, KEY_UPDATE_REQ);
+        if (constant_time_compare(tag, ku->tag, KEY_UPDATE_TAG_LEN) != 0) {
+            sessions_unlock(s);
+            return;
+        }
+    } else {
+        LOG_DBG("[w%u] KEY_UPDATE epoch %u out of sequence (at %u)\n", w->id,
+                (unsigned)epoch, (unsigned)s->se.epoch);
+        sessions_unlock(s);
+        return;
+    }
+
+    kack.type = MSG_TYPE_KEY_UPDATE_ACK;
+    memcpy(kack.SID, s->se.sid, SID_LEN);
+    kack.epoch[0] = (epoch >> 8) & 0xFF;
+    kack.epoch[1] = epoch & 0xFF;
+    key_update_tag(kack.tag, s->se.K_master, s->se.sid, epoch, KEY_UPDATE_RSP);
+    ticket_issue(w, kack.ticket, &s->se);
+    sessions_unlock(s);
+
+    send_to(w, &kack, sizeof(kack), peer);
+}
+
+/* ========== DATA ========== */
+
+static data_task_t *data_task_alloc(worker_t *w) {
+    data_task_t *t = w->data_free;
+
+    if (t == NULL) return malloc(sizeof(*t));
+    w->data_free = (data_task_t *)t->task.next;
+    return t;
+}
+
+static void data_task_free(worker_t *w, data_task_t *t) {
+    t->task.next = (pool_task_t *)w->data_free;
+    w->data_free = t;
+}
+
+/* Decrypt records of one SID: one lookup, one lock, one batch */
+static void data_run_session(worker_t *w, data_task_t **tasks, unsigned count) {
+    const uint8_t *sid = tasks[0]->data + 1;
+    session_record_t recs[RX_BATCH];
+    uint8_t plaintext[RX_BATCH][MESSAGE_MAX_SIZE + 1];
+    gw_session_t *s;
+    unsigned i, n = 0;
+
+    for (i = 0; i < count; i++) {
+        const uint8_t *data = tasks[i]->data;
+        uint16_t cipher_len = ((uint16_t)data[5 + SID_LEN] << 8) | data[6 + SID_LEN];
+
+        if (cipher_len > tasks[i]->len - DATA_HDR_LEN ||
+            cipher_len > MESSAGE_MAX_SIZE + AEAD_TAG_LEN) {
+            w->data_drops++;
+            continue;
+        }
+        recs[n].counter = ((uint32_t)data[1 + SID_LEN] << 24) |
+                          ((uint32_t)data[2 + SID_LEN] << 16) |
+                          ((uint32_t)data[3 + SID_LEN] << 8) | (uint32_t)data[4 + SID_LEN];
+        recs[n].ct = data + DATA_HDR_LEN;
+        recs[n].ct_len = cipher_len;
+        recs[n].out = plaintext[n];
+        tasks[n] = tasks[i];               // Keep tasks[k] <-> recs[k]
+        n++;
+    }
+    if (n == 0) return;
+
+    s = sessions_find(sid, uptime());
+    if (s == NULL) {
+        /* Tell each sender so it can resume or re-authenticate */
+        uint8_t nack[1 + SID_LEN];
+        nack[0] = MSG_TYPE_SESSION_UNKNOWN;
+        memcpy(nack + 1, sid, SID_LEN);
+        for (i = 0; i < n; i++) {
+            send_to(w, nack, sizeof(nack), &tasks[i]->peer);
+        }
+        w->data_drops += n;
+        return;
+    }
+    session_decrypt_batch(&s->se, recs, n);
+
+    /* After a KEY_UPDATE, records that fail under the new key may still
+     * be under the previous one (all our ACKs lost, or reordered); a
+     * record that verifies under the new key retires it */
+    if (s->prev.in_use) {
+        session_record_t retry[RX_BATCH];
+        unsigned idx[RX_BATCH], m = 0;
+        int confirmed = 0;
+
+        for (i = 0; i < n; i++) {
+            if (recs[i].result == SESSION_OK) confirmed = 1;
+            if (recs[i].result == SESSION_ERR_AEAD) {
+                idx[m] = i;
+                retry[m++] = recs[i];
+            }
+        }
+        if (m > 0) {
+            session_decrypt_batch(&s->prev, retry, m);
+            for (i = 0; i < m; i++) {
+                recs[idx[i]] = retry[i];
+            }
+        }
+        if (confirmed) {
+            secure_zero(&s->prev, sizeof(s->prev));
+            LOG_DBG("[w%u] epoch %u confirmed by DATA\n", w->id, (unsigned)s->se.epoch);
+        }
+    }
+    sessions_unlock(s);
+
+    for (i = 0; i < n; i++) {
+        if (recs[i].result != SESSION_OK) {
+            LOG_DBG("[w%u] DATA counter=%u dropped (%d)\n", w->id,
+                    (unsigned)recs[i].counter, recs[i].result);
+            w->data_drops++;
+            continue;
+        }
+        plaintext[i][recs[i].out_len] = '\0';
+        LOG_DBG("[w%u] DATA counter=%u: %s\n", w->id, (unsigned)recs[i].counter,
+                plaintext[i]);
+        w->data_ok++;
+    }
+}
+
+/* Run up to RX_BATCH queued DATA records (class 0, on the receiving
+ * worker), grouped by SID
+ * @returns Records taken off the queue */
+static unsigned data_drain(worker_t *w) {
+    data_task_t *batch[RX_BATCH];
+    data_task_t *group[RX_BATCH];
+    pool_task_t *t;
+    unsigned n = 0, i, j;
+
+    while (n < RX_BATCH && (t = pool_pop(w->id, POOL_CLASS_DATA)) != NULL) {
+        batch[n++] = (data_task_t *)t;
+    }
+
+    /* Stable insertion sort by SID: sessions become runs, each in arrival
+     * order (the replay window prefers ascending counters) */
+    for (i = 1; i < n; i++) {
+        data_task_t *x = batch[i];
+        for (j = i; j > 0 && memcmp(batch[j - 1]->data + 1, x->data + 1, SID_LEN) > 0; j--) {
+            batch[j] = batch[j - 1];
+        }
+        batch[j] = x;
+    }
+    for (i = 0; i < n; i = j) {
+        for (j = i + 1; j < n && memcmp(batch[j]->data + 1, batch[i]->data + 1, SID_LEN) == 0; j++) {
+        }
+        /* data_run_session() reorders its array: give it a copy */
+        memcpy(group, batch + i, (j - i) * sizeof(group[0]));
+        data_run_session(w, group, j - i);
+    }
+
+    for (i = 0; i < n; i++) {
+        pool_done(w->id, &batch[i]->task);
+        data_task_free(w, batch[i]);
+    }
+    return n;
+}
+
+static void handle_data(worker_t *w, const uint8_t *data, size_t datalen,
+                        const struct sockaddr_in6 *peer) {
+    data_task_t *t;
+
+    if (datalen < DATA_HDR_LEN) return;
+    if (datalen > sizeof(t->data) || (t = data_task_alloc(w)) == NULL) {
+        w->data_drops++;
+        return;
+    }
+    t->task.cls = POOL_CLASS_DATA;
+    t->task.enqueued_ns = w->rx_ns;
+    t->peer = *peer;
+    t->len = (uint16_t)datalen;
+    memcpy(t->data, data, datalen);
+    if (pool_push(w->id, &t->task) != 0) {
+        w->data_drops++;
+        data_task_free(w, t);
+    }
+}
+
+static void handle_packet(worker_t *w, const uint8_t *data, size_t datalen,
+                          const struct sockaddr_in6 *peer) {
+    if (datalen == 0) return;
+
+    switch (data[0]) {
+    case MSG_TYPE_AUTH_FRAG:
+        handle_auth_frag(w, data, datalen, peer);
+        break;
+    case MSG_TYPE_AUTH_FEC:
+        handle_auth_fec(w, data, datalen, peer);
+        break;
+    case MSG_TYPE_DATA:
+        handle_data(w, data, datalen, peer);
+        break;
+    case MSG_TYPE_RESUME:
+    case MSG_TYPE_KEY_UPDATE:
+        /* The peer's DATA read before this (same socket, so this worker's
+         * queue) goes first: a resume retires the session, a key update
+         * replaces its key */
+        while (data_drain(w) > 0) {
+        }
+        if (data[0] == MSG_TYPE_RESUME) {
+            handle_resume(w, data, datalen, peer);
+        } else {
+            handle_key_update(w, data, datalen, peer);
+        }
+        break;
+    default:
+        LOG_DBG("[w%u] message type 0x%02x not handled\n", w->id, data[0]);
+        break;
+    }
+}
+
+/* ========== WORKER LOOP ========== */
+
+static void housekeeping(worker_t *w, uint32_t now) {
+    int dropped = reassembly_expire(now);
+
+    if (dropped > 0) {
+        LOG_INFO("[w%u] %d abandoned handshakes dropped\n", w->id, dropped);
+    }
+    ticket_keys_rotate(w, ticket_epoch_now());
+}
+
+/* One recvmmsg() of up to io_batch datagrams. Fragments are handled on
+ * the spot (reassembly is cheap); DATA and complete AUTHs become tasks.
+ * @returns Datagrams read */
+static int worker_ingest(worker_t *w) {
+    static THREAD_LOCAL uint8_t bufs[RX_BATCH][RX_BUF_SIZE];
+    static THREAD_LOCAL struct sockaddr_in6 peers[RX_BATCH];
+    static THREAD_LOCAL union {
+        char buf[CMSG_SPACE(sizeof(struct timespec))];
+        struct cmsghdr align;
+    } control[RX_BATCH];
+    static THREAD_LOCAL struct iovec iov[RX_BATCH];
+    static THREAD_LOCAL struct mmsghdr msgs[RX_BATCH];
+    int count, i;
+
+    for (i = 0; i < (int)io_batch; i++) {
+        iov[i].iov_base = bufs[i];
+        iov[i].iov_len = RX_BUF_SIZE;
+        memset(&msgs[i].msg_hdr, 0, sizeof(msgs[i].msg_hdr));
+        msgs[i].msg_hdr.msg_name = &peers[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+        msgs[i].msg_hdr.msg_iov = &iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+        msgs[i].msg_hdr.msg_control = control[i].buf;
+        msgs[i].msg_hdr.msg_controllen = sizeof(control[i].buf);
+    }
+    count = recvmmsg(w->fd, msgs, io_batch, 0, NULL);
+    if (count <= 0) return 0;
+    w->rx_calls++;
+
+    for (i = 0; i < count; i++) {
+        struct cmsghdr *cm;
+
+        /* Latency is measured from the kernel's receive timestamp, so time
+         * spent in the socket queue behind other work counts too */
+        w->rx_ns = 0;
+        for (cm = CMSG_FIRSTHDR(&msgs[i].msg_hdr); cm != NULL;
+             cm = CMSG_NXTHDR(&msgs[i].msg_hdr, cm)) {
+            if (cm->cmsg_level == SOL_SOCKET && cm->cmsg_type == SCM_TIMESTAMPNS) {
+                struct timespec ts;
+                memcpy(&ts, CMSG_DATA(cm), sizeof(ts));
+                w->rx_ns = (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+            }
+        }
+        if (w->rx_ns == 0) w->rx_ns = pool_now_ns();
+
+        w->rx_packets++;
+        handle_packet(w, bufs[i], msgs[i].msg_len, &peers[i]);
+    }
+    return count;
+}
+
+static void *worker_main(void *arg) {
+    worker_t *w = arg;
+    uint32_t next_tick = 0, next_status = STATUS_INTERVAL;
+    struct timespec cpu;
+    uint32_t seed;
+    cpu_set_t cpus;
+
+    /* One event loop per core */
+    CPU_ZERO(&cpus);
+    CPU_SET(w->id % sysconf(_SC_NPROCESSORS_ONLN), &cpus);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+    random_bytes((uint8_t *)&seed, sizeof(seed));
+    crypto_prng_init(seed | 1);
+    reassembly_init(GATEWAY_MAX_FRAG_SIZE);
+    w->ticket_epoch = UINT32_MAX;
+    ticket_keys_rotate(w, ticket_epoch_now());
+    tx_init(w);
+
+    while (!stopping) {
+        int busy = worker_ingest(w) > 0;
+        uint32_t now;
+
+        /* Class 0 first: every DATA record read so far */
+        while (data_drain(w) > 0) {
+            busy = 1;
+        }
+
+        /* Then one handshake slice (ours or stolen) before the socket is
+         * looked at again */
+        if (w->current == NULL) {
+            w->current = (handshake_task_t *)pool_pop(w->id, POOL_CLASS_HANDSHAKE);
+        }
+        if (w->current != NULL) {
+            if (handshake_step(w, w->current)) {
+                handshake_done(w, w->current);
+                w->current = NULL;
+            }
+            busy = 1;
+        }
+
+        now = uptime();
+        if (now >= next_tick) {
+            housekeeping(w, now);
+            next_tick = now + 1;
+        }
+        if (now >= next_status) {
+            LOG_INFO("[w%u] status: rx=%llu data=%llu drops=%llu handshakes=%llu/%llu "
+                     "sessions=%u peak_handshakes=%d\n", w->id,
+                     (unsigned long long)w->rx_packets, (unsigned long long)w->data_ok,
+                     (unsigned long long)w->data_drops, (unsigned long long)w->handshakes_ok,
+                     (unsigned long long)w->handshakes_failed, sessions_sweep(w->id, now),
+                     w->handshakes_peak);
+            next_status = now + STATUS_INTERVAL;
+        }
+
+        if (w->tx_count > 0) {
+            tx_flush(w);
+        }
+
+        /* Idle: sleep until a packet arrives or another worker queues a
+         * handshake we could steal */
+        if (!busy && pool_park(w->id) == 0) {
+            struct epoll_event ev;
+            epoll_wait(w->epfd, &ev, 1, 1000);
+            pool_unpark(w->id);
+        }
+    }
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    w->cpu_ns = (uint64_t)cpu.tv_sec * 1000000000u + (uint64_t)cpu.tv_nsec;
+    return NULL;
+}
+
+/* SO_REUSEPORT socket on [::]:port, dual-stack, with its own epoll (which
+ * also watches the pool's wake-up eventfd) */
+static int worker_socket(worker_t *w, uint16_t port) {
+    struct sockaddr_in6 addr;
+    struct epoll_event ev;
+    int one = 1, zero = 0, rcvbuf = SOCKET_RCVBUF;
+
+    w->fd = socket(AF_INET6, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (w->fd < 0) return -1;
+    setsockopt(w->fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    setsockopt(w->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+    setsockopt(w->fd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one));
+    if (setsockopt(w->fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0) {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = in6addr_any;
+    addr.sin6_port = htons(port);
+    if (bind(w->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) return -1;
+
+    w->epfd = epoll_create1(0);
+    if (w->epfd < 0) return -1;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = w;
+    if (epoll_ctl(w->epfd, EPOLL_CTL_ADD, w->fd, &ev) < 0) return -1;
+    return epoll_ctl(w->epfd, EPOLL_CTL_ADD, pool_wake_fd(w->id), &ev);
+}
+
+/* ========== STARTUP ========== */
+
+/* Same long-term keys as node-gateway.c (fixed PRNG seed). They are
+ * generated once and then loaded from the key store (gw.keys in the
+ * working directory), as on the motes. The ticket secret is not derived
+ * from them (ticket_keys_init). */
+static int keys_init(void) {
+    crypto_prng_init(0xCAFEBABE);
+    keys_stored = !no_key_store &&
+                  key_store_load(&gateway_keypair, &gateway_ldpc_keypair) == 0;
+    if (!keys_stored) {
+        if (ring_lwe_keygen(&gateway_keypair) != 0) return -1;
+        if (ldpc_keygen(&gateway_ldpc_keypair) != 0) return -1;
+        if (!no_key_store &&
+            key_store_save(&gateway_keypair, &gateway_ldpc_keypair) != 0) {
+            LOG_WARN("Keys not stored; the next start generates them again\n");
+        }
+    }
+
+    return ticket_keys_init();
+}
+
+/* Per-class queue depth and latency (kernel receive -> task done) */
+static void pool_report(void) {
+    static const char *const names[POOL_CLASSES] = { "data", "handshake" };
+    unsigned c;
+
+    for (c = 0; c < POOL_CLASSES; c++) {
+        pool_class_stats_t st;
+
+        pool_stats(c, &st);
+        fprintf(stderr, "  pool %-9s done=%llu stolen=%llu depth=%llu peak=%llu dropped=%llu "
+                "p50=%lluus p99=%lluus p99.9=%lluus max=%lluus\n", names[c],
+                (unsigned long long)st.done, (unsigned long long)st.stolen,
+                (unsigned long long)st.depth, (unsigned long long)st.depth_peak,
+                (unsigned long long)st.dropped,
+                (unsigned long long)st.p50_us, (unsigned long long)st.p99_us,
+                (unsigned long long)st.p999_us, (unsigned long long)st.max_us);
+    }
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-p port] [-t threads] [-s sessions] [-b batch] [-i] [-k] [-v]...\n"
+            "  -p  UDP port (default %d)\n"
+            "  -t  worker threads, one per core (default: online CPUs)\n"
+            "  -s  sessions per worker shard (default %d)\n"
+            "  -b  datagrams per recvmmsg() / sendmmsg(), 1..%d (default %d; 1 = unbatched)\n"
+            "  -i  verify handshakes inline on arrival, bypassing the pool (comparison)\n"
+            "  -k  generate keys at every start, ignoring the key store (comparison)\n"
+            "  -v  more logging (-v info, -vv per-packet debug)\n"
+            "SIGUSR1 prints the pool's queue depths and latency percentiles.\n",
+            prog, UDP_PORT, DEFAULT_SESSIONS, RX_BATCH, RX_BATCH);
+}
+
+int main(int argc, char **argv) {
+    unsigned threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned sessions_per_shard = DEFAULT_SESSIONS;
+    uint16_t port = UDP_PORT;
+    uint64_t rx = 0, data_ok = 0, drops = 0, hs_ok = 0, hs_failed = 0, cpu_ns = 0;
+    uint64_t resumes = 0, key_updates = 0;
+    sigset_t sigs;
+    unsigned i;
+    double keys_ms;
+    int opt, sig;
+
+    while ((opt = getopt(argc, argv, "p:t:s:b:ikvh")) != -1) {
+        switch (opt) {
+        case 'p': port = (uint16_t)atoi(optarg); break;
+        case 't': threads = (unsigned)atoi(optarg); break;
+        case 's': sessions_per_shard = (unsigned)atoi(optarg); break;
+        case 'b': io_batch = (unsigned)atoi(optarg); break;
+        case 'i': inline_handshakes = 1; break;
+        case 'k': no_key_store = 1; break;
+        case 'v': log_level++; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (threads == 0 || threads > MAX_WORKERS) {
+        fprintf(stderr, "threads must be 1..%d\n", MAX_WORKERS);
+        return 1;
+    }
+    if (io_batch == 0 || io_batch > RX_BATCH) {
+        fprintf(stderr, "batch must be 1..%d\n", RX_BATCH);
+        return 1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &boot_time);
+    if (keys_init() != 0) {
+        LOG_ERR("Key setup failed\n");
+        return 1;
+    }
+    keys_ms = ms_since_boot();
+    if (sessions_init(threads, sessions_per_shard) != 0) {
+        LOG_ERR("Cannot allocate %u x %u sessions\n", threads, sessions_per_shard);
+        return 1;
+    }
+    if (pool_init(threads) != 0) {
+        LOG_ERR("Cannot set up the task pool\n");
+        return 1;
+    }
+
+    workers = calloc(threads, sizeof(worker_t));
+    if (workers == NULL) return 1;
+    worker_count = threads;
+    for (i = 0; i < threads; i++) {
+        workers[i].id = i;
+        if (worker_socket(&workers[i], port) != 0) {
+            LOG_ERR("Socket for worker %u on port %u: %s\n", i, port, strerror(errno));
+            return 1;
+        }
+    }
+
+    /* Workers inherit a blocked SIGINT/SIGTERM/SIGUSR1; main waits for them */
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGINT);
+    sigaddset(&sigs, SIGTERM);
+    sigaddset(&sigs, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+    for (i = 0; i < threads; i++) {
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    }
+    fprintf(stderr, "gatewayd: %u workers on UDP port %u (n=%d, ring=%d, %u sessions/shard, "
+            "batch %u%s)\n", threads, port, POLY_DEGREE, RING_SIZE, sessions_per_shard, io_batch,
+            inline_handshakes ? ", inline handshakes" : "");
+    fprintf(stderr, "gatewayd: ready in %.1f ms, keys %.3f ms (%s)\n", ms_since_boot(),
+            keys_ms, keys_stored ? "from store" : "generated");
+
+    for (;;) {
+        struct timespec interval = { STATUS_INTERVAL, 0 };
+
+        sig = sigtimedwait(&sigs, NULL, &interval);
+        if (sig == SIGINT || sig == SIGTERM) break;
+        if (sig == SIGUSR1 || log_level >= LOG_LEVEL_INFO) {
+            pool_report();
+        }
+    }
+    stopping = 1;
+
+    for (i = 0; i < threads; i++) {
+        worker_t *w = &workers[i];
+        pthread_join(w->thread, NULL);
+        fprintf(stderr, "  worker %u: rx=%llu data=%llu drops=%llu handshakes=%llu failed=%llu "
+                "rx/call=%.1f tx/call=%.1f cpu=%.2fs\n",
+                i, (unsigned long long)w->rx_packets, (unsigned long long)w->data_ok,
+                (unsigned long long)w->data_drops, (unsigned long long)w->handshakes_ok,
+                (unsigned long long)w->handshakes_failed,
+                w->rx_calls ? (double)w->rx_packets / w->rx_calls : 0.0,
+                w->tx_calls ? (double)w->tx_packets / w->tx_calls : 0.0, w->cpu_ns / 1e9);
+        rx += w->rx_packets;
+        data_ok += w->data_ok;
+        drops += w->data_drops;
+        hs_ok += w->handshakes_ok;
+        hs_failed += w->handshakes_failed;
+        resumes += w->resumes;
+        key_updates += w->key_updates;
+        cpu_ns += w->cpu_ns;
+        close(w->fd);
+        close(w->epfd);
+    }
+    /* Packets per CPU-second: independent of how busy the senders kept us */
+    fprintf(stderr, "gatewayd: rx=%llu data=%llu drops=%llu handshakes=%llu failed=%llu "
+            "resumes=%llu key_updates=%llu (%.0f pkt/s per core)\n",
+            (unsigned long long)rx, (unsigned long long)data_ok, (unsigned long long)drops,
+            (unsigned long long)hs_ok, (unsigned long long)hs_failed,
+            (unsigned long long)resumes, (unsigned long long)key_updates,
+            cpu_ns ? rx * 1e9 / cpu_ns : 0.0);
+    pool_report();
+    return 0;
+}
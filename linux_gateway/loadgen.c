@@ -0,0 +1,483 @@
+/**
+ * loadgen.c
+ * Load Generator / Test Client for the Linux Gateway
+ *
+ * Runs many node-sender.c handshakes over UDP (ring signature, AUTH
+ * fragments with SACK-driven retransmission, AUTH_ACK, key derivation)
+ * and then streams DATA records on each session, optionally with a
+ * KEY_UPDATE every -u records and a RESUME from the last ticket (-r).
+ * Every client uses its own socket, i.e. its own source port, so
+ * SO_REUSEPORT spreads them over the gateway's workers.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#include "crypto_core.h"
+#include "reassembly.h"
+#include "wire.h"
+
+#define ACK_TIMEOUT_MS 200                 // Retransmit the missing fragments after this
+#define MAX_ROUNDS 25                      // Retransmission rounds before giving up
+#define REPLY_TIMEOUT_MS 1000              // Wait for KEY_UPDATE_ACK / RESUME_ACK
+#define KEY_UPDATE_RETRIES 3
+
+typedef struct {
+    pthread_t thread;
+    unsigned first_client;
+    unsigned clients;
+    /* Results */
+    unsigned handshakes_ok;
+    double handshake_ms;                   // Sum over successful handshakes
+    uint64_t data_sent;
+    unsigned key_updates;
+    unsigned resumes;
+    unsigned failures;                     // Key updates / resumes not acknowledged
+    crypto_ctx_t crypto;                   // The thread's own DRBG and signing scratch
+} client_thread_t;
+
+static struct sockaddr_storage gateway_addr;
+static socklen_t gateway_addr_len;
+static unsigned messages = 100;
+static unsigned frag_size_wanted = AUTH_FRAG_MAX_SIZE;
+static unsigned data_gap_us;
+static unsigned key_update_every;
+static int resume_once;
+
+static double now_ms(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e3 + t.tv_nsec / 1e6;
+}
+
+/* ========== HANDSHAKE ========== */
+
+static void send_fragment(int fd, auth_cursor_t *cur, uint16_t handshake_id,
+                          unsigned idx, unsigned total, unsigned frag_size) {
+    uint8_t pkt[AUTH_FRAG_HDR_LEN + REASSEMBLY_MAX_FRAG_SIZE];
+    AuthFragment *frag = (AuthFragment *)pkt;
+    size_t len;
+
+    frag->type = MSG_TYPE_AUTH_FRAG;
+    frag->session_id = htons(handshake_id);
+    frag->fragment_id = (uint8_t)idx;
+    frag->total_frags = (uint8_t)total;
+    frag->frag_size = htons(frag_size);
+    auth_cursor_seek(cur, (size_t)idx * frag_size);
+    len = auth_cursor_read(cur, frag->payload, frag_size);
+    send(fd, pkt, AUTH_FRAG_HDR_LEN + len, 0);
+}
+
+/* Full AUTH exchange on a connected socket
+ * @returns 0 with K_master / SID filled in, -1 on failure */
+static int handshake(int fd, session_ctx_t *session, uint8_t *ticket, crypto_ctx_t *crypto) {
+    static THREAD_LOCAL AuthMessage auth_msg;
+    RingLWEKeyPair keypair;
+    PolyView ring_keys[RING_SIZE];
+    LDPCPublicKey ldpc_pubkey;
+    ErrorVector error;
+    uint8_t keyword[KEYWORD_SIZE];
+    uint8_t acked[256];
+    auth_cursor_t cur;
+    uint16_t handshake_id;
+    unsigned frag_size = frag_size_wanted, total, i, round;
+    int i_ring;
+
+    if (crypto_ring_lwe_keygen(crypto, &keypair) != 0) return -1;
+    ring_keys[0] = poly_view(&keypair.public);
+    for (i_ring = 1; i_ring < RING_SIZE; i_ring++) {
+        ring_keys[i_ring] = poly_view(&ring_member_table[i_ring]);
+    }
+
+    ldpc_keygen((LDPCKeyPair *)&ldpc_pubkey);
+    generate_error_vector(&error, 50);
+
+    memset(keyword, 0, KEYWORD_SIZE);
+    strcpy((char *)keyword, "AUTH_REQUEST");
+    auth_msg.type = MSG_TYPE_AUTH;
+    ldpc_encode(auth_msg.syndrome, &error, &ldpc_pubkey);
+    auth_msg.public_key = keypair.public;
+    if (crypto_ring_sign(crypto, &auth_msg.signature, keyword, &keypair, ring_keys, 0) != 0) {
+        return -1;
+    }
+    auth_cursor_init(&cur, &auth_msg);
+
+    getrandom(&handshake_id, sizeof(handshake_id), 0);
+    if (handshake_id == 0) handshake_id = 1;
+
+restart:
+    total = (AUTH_MSG_WIRE_LEN + frag_size - 1) / frag_size;
+    if (total > 255) return -1;
+    memset(acked, 0, sizeof(acked));
+
+    for (round = 0; round < MAX_ROUNDS; round++) {
+        double deadline;
+
+        for (i = 0; i < total; i++) {
+            if (!acked[i]) send_fragment(fd, &cur, handshake_id, i, total, frag_size);
+        }
+
+        deadline = now_ms() + ACK_TIMEOUT_MS;
+        for (;;) {
+            struct pollfd pfd = { fd, POLLIN, 0 };
+            uint8_t buf[512];
+            ssize_t n;
+            int wait = (int)(deadline - now_ms());
+
+            if (wait <= 0 || poll(&pfd, 1, wait) <= 0) break;
+            n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) continue;
+
+            if (buf[0] == MSG_TYPE_AUTH_ACK && (size_t)n >= sizeof(AuthAckMessage)) {
+                const AuthAckMessage *ack = (const AuthAckMessage *)buf;
+
+                memcpy(session->sid, ack->SID, SID_LEN);
+                memcpy(ticket, ack->ticket, TICKET_LEN);
+                derive_master_key(session->K_master, error.bits, sizeof(error.bits),
+                                  ack->N_G, sizeof(ack->N_G));
+                session->counter = 1;
+                session->epoch = 0;
+                session->active = 1;
+                secure_zero(&error, sizeof(error));
+                return 0;
+            }
+            if (buf[0] == MSG_TYPE_FRAG_ACK && (size_t)n >= sizeof(FragmentAck)) {
+                const FragmentAck *fa = (const FragmentAck *)buf;
+                uint32_t sack = ntohl(fa->sack);
+                uint16_t max_size = ntohs(fa->max_frag_size);
+
+                if (ntohs(fa->handshake_id) != handshake_id) continue;
+                if (fa->cum_ack == 0 && sack == 0 && max_size < frag_size) {
+                    /* Gateway refused our size: restart smaller */
+                    frag_size = max_size;
+                    handshake_id++;
+                    goto restart;
+                }
+                for (i = 0; i < fa->cum_ack && i < total; i++) acked[i] = 1;
+                for (i = 0; i < 32; i++) {
+                    if ((sack >> i) & 1 && fa->cum_ack + 1 + i < total) {
+                        acked[fa->cum_ack + 1 + i] = 1;
+                    }
+                }
+            }
+        }
+    }
+    return -1;
+}
+
+/* ========== DATA ========== */
+
+#define SEND_BATCH 64                      // DATA records per sendmmsg() when -g 0
+
+typedef struct {
+    uint8_t wire[DATA_HDR_LEN + MESSAGE_MAX_SIZE + AEAD_TAG_LEN];
+    size_t len;
+} data_record_t;
+
+/* Records are sealed before the first one is sent, so the send loop
+ * (back-to-back sendmmsg() bursts with -g 0) is not throttled by our
+ * own encryption */
+static uint64_t send_data(int fd, session_ctx_t *session, unsigned client,
+                          unsigned records) {
+    data_record_t *recs = malloc(records * sizeof(data_record_t));
+    struct mmsghdr msgs[SEND_BATCH];
+    struct iovec iov[SEND_BATCH];
+    uint64_t sent = 0;
+    unsigned m, count = 0;
+
+    if (recs == NULL) return 0;
+    for (m = 0; m < records; m++) {
+        uint8_t *wire = recs[m].wire;
+        char msg[MESSAGE_MAX_SIZE];
+        size_t cipher_len;
+        int len;
+
+        len = snprintf(msg, sizeof(msg), "loadgen %u #%u", client,
+                       (unsigned)session->counter);
+        if (session_encrypt(session, (uint8_t *)msg, len + 1,
+                            wire + DATA_HDR_LEN, &cipher_len) != 0) {
+            break;
+        }
+        wire[0] = MSG_TYPE_DATA;
+        memcpy(wire + 1, session->sid, SID_LEN);
+        wire[1 + SID_LEN] = (session->counter >> 24) & 0xFF;
+        wire[2 + SID_LEN] = (session->counter >> 16) & 0xFF;
+        wire[3 + SID_LEN] = (session->counter >> 8) & 0xFF;
+        wire[4 + SID_LEN] = session->counter & 0xFF;
+        wire[5 + SID_LEN] = (cipher_len >> 8) & 0xFF;
+        wire[6 + SID_LEN] = cipher_len & 0xFF;
+        recs[m].len = DATA_HDR_LEN + cipher_len;
+        session->counter++;
+        count++;
+    }
+
+    for (m = 0; m < count; ) {
+        unsigned burst = data_gap_us ? 1 : SEND_BATCH, i;
+        int n;
+
+        if (burst > count - m) burst = count - m;
+        memset(msgs, 0, burst * sizeof(msgs[0]));
+        for (i = 0; i < burst; i++) {
+            iov[i].iov_base = recs[m + i].wire;
+            iov[i].iov_len = recs[m + i].len;
+            msgs[i].msg_hdr.msg_iov = &iov[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        n = sendmmsg(fd, msgs, burst, 0);
+        if (n <= 0) break;
+        sent += (unsigned)n;
+        m += (unsigned)n;
+        if (data_gap_us) usleep(data_gap_us);
+    }
+    secure_zero(recs, records * sizeof(data_record_t));
+    free(recs);
+    return sent;
+}
+
+/* ========== KEY UPDATE AND RESUMPTION ========== */
+
+/* Waits for a reply of the given type
+ * @returns Its length, or 0 on timeout */
+static size_t recv_reply(int fd, uint8_t type, uint8_t *buf, size_t size, int timeout_ms) {
+    double deadline = now_ms() + timeout_ms;
+
+    for (;;) {
+        struct pollfd pfd = { fd, POLLIN, 0 };
+        int wait = (int)(deadline - now_ms());
+        ssize_t n;
+
+        if (wait <= 0 || poll(&pfd, 1, wait) <= 0) return 0;
+        n = recv(fd, buf, size, 0);
+        if (n > 0 && buf[0] == type) return (size_t)n;
+    }
+}
+
+/* Ratchets to epoch + 1 once the gateway has proved it did the same */
+static int key_update(int fd, session_ctx_t *session, uint8_t *ticket) {
+    KeyUpdateMessage ku;
+    uint8_t K_next[MASTER_KEY_LEN];
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+    uint8_t buf[512];
+    uint16_t epoch = session->epoch + 1;
+    int attempt;
+
+    session_ratchet_key(K_next, session->K_master, session->sid, epoch);
+    ku.type = MSG_TYPE_KEY_UPDATE;
+    memcpy(ku.SID, session->sid, SID_LEN);
+    ku.epoch[0] = (epoch >> 8) & 0xFF;
+    ku.epoch[1] = epoch & 0xFF;
+    key_update_tag(ku.tag, K_next, session->sid, epoch, KEY_UPDATE_REQ);
+    key_update_tag(tag, K_next, session->sid, epoch, KEY_UPDATE_RSP);
+
+    for (attempt = 0; attempt < KEY_UPDATE_RETRIES; attempt++) {
+        const KeyUpdateAckMessage *kack = (const KeyUpdateAckMessage *)buf;
+
+        send(fd, &ku, sizeof(ku), 0);
+        if (recv_reply(fd, MSG_TYPE_KEY_UPDATE_ACK, buf, sizeof(buf), REPLY_TIMEOUT_MS) <
+            sizeof(KeyUpdateAckMessage)) {
+            continue;
+        }
+        if (memcmp(kack->SID, session->sid, SID_LEN) != 0 ||
+            constant_time_compare(tag, kack->tag, KEY_UPDATE_TAG_LEN) != 0) {
+            continue;
+        }
+        memcpy(session->K_master, K_next, MASTER_KEY_LEN);
+        session->epoch = epoch;
+        session->counter = 1;
+        memcpy(ticket, kack->ticket, TICKET_LEN);
+        secure_zero(K_next, sizeof(K_next));
+        return 0;
+    }
+    secure_zero(K_next, sizeof(K_next));
+    return -1;
+}
+
+/* 1-RTT resumption from the last ticket, sealed over the current key.
+ * Sent once: the gateway redeems a ticket only once. */
+static int resume(int fd, session_ctx_t *session, uint8_t *ticket) {
+    ResumeMessage req;
+    uint8_t K_master[MASTER_KEY_LEN];
+    uint8_t mac[RESUME_BINDER_LEN];
+    uint8_t buf[512];
+    const ResumeAckMessage *rack = (const ResumeAckMessage *)buf;
+
+    req.type = MSG_TYPE_RESUME;
+    memcpy(req.ticket, ticket, TICKET_LEN);
+    getrandom(req.N_S, sizeof(req.N_S), 0);
+    resume_binder(req.binder, session->K_master, req.ticket, req.N_S);
+    send(fd, &req, sizeof(req), 0);
+
+    if (recv_reply(fd, MSG_TYPE_RESUME_ACK, buf, sizeof(buf), REPLY_TIMEOUT_MS) <
+        sizeof(ResumeAckMessage)) {
+        return -1;
+    }
+    derive_resumed_master_key(K_master, session->K_master, req.N_S, rack->N_G);
+    resume_confirm(mac, K_master, rack->type, rack->N_G, rack->SID, rack->ticket);
+    if (constant_time_compare(mac, rack->confirm, RESUME_BINDER_LEN) != 0) {
+        secure_zero(K_master, sizeof(K_master));
+        return -1;
+    }
+    memcpy(session->sid, rack->SID, SID_LEN);
+    memcpy(session->K_master, K_master, MASTER_KEY_LEN);
+    session->counter = 1;
+    session->epoch = 0;
+    memcpy(ticket, rack->ticket, TICKET_LEN);
+    secure_zero(K_master, sizeof(K_master));
+    return 0;
+}
+
+/* -n DATA records, with a KEY_UPDATE after every -u of them */
+static void run_session(client_thread_t *t, int fd, session_ctx_t *session,
+                        uint8_t *ticket, unsigned client) {
+    unsigned left = messages;
+
+    while (left > 0) {
+        unsigned burst = (key_update_every && key_update_every < left) ? key_update_every : left;
+
+        t->data_sent += send_data(fd, session, client, burst);
+        left -= burst;
+        if (left == 0) break;
+        if (key_update(fd, session, ticket) == 0) {
+            t->key_updates++;
+        } else {
+            t->failures++;
+        }
+    }
+}
+
+static void *client_thread(void *arg) {
+    client_thread_t *t = arg;
+    uint32_t seed;
+    unsigned c;
+
+    getrandom(&seed, sizeof(seed), 0);
+    crypto_ctx_init(&t->crypto, seed);
+
+    for (c = 0; c < t->clients; c++) {
+        session_ctx_t session;
+        uint8_t ticket[TICKET_LEN];
+        double start;
+        int fd = socket(gateway_addr.ss_family, SOCK_DGRAM, 0);
+
+        if (fd < 0 || connect(fd, (struct sockaddr *)&gateway_addr, gateway_addr_len) < 0) {
+            fprintf(stderr, "loadgen: socket: %s\n", strerror(errno));
+            if (fd >= 0) close(fd);
+            continue;
+        }
+        start = now_ms();
+        if (handshake(fd, &session, ticket, &t->crypto) == 0) {
+            t->handshake_ms += now_ms() - start;
+            t->handshakes_ok++;
+            run_session(t, fd, &session, ticket, t->first_client + c);
+            if (resume_once && resume(fd, &session, ticket) == 0) {
+                t->resumes++;
+                run_session(t, fd, &session, ticket, t->first_client + c);
+            } else if (resume_once) {
+                t->failures++;
+            }
+            secure_zero(&session, sizeof(session));
+            secure_zero(ticket, sizeof(ticket));
+        }
+        close(fd);
+    }
+    return NULL;
+}
+
+/* ========== MAIN ========== */
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [-H host] [-p port] [-c clients] [-t threads] [-n messages]\n"
+            "          [-f frag_size] [-g gap_us] [-u every] [-r]\n"
+            "  -H  gateway address (default ::1)\n"
+            "  -c  clients (handshakes), split over -t threads (default 8 / 4)\n"
+            "  -n  DATA messages per client (default 100)\n"
+            "  -f  AUTH fragment payload bytes (default 1024)\n"
+            "  -g  microseconds between DATA messages (default 0: sendmmsg bursts)\n"
+            "  -u  KEY_UPDATE after every this many DATA messages (default 0: never)\n"
+            "  -r  resume from the ticket after the DATA, then send -n more\n", prog);
+}
+
+int main(int argc, char **argv) {
+    const char *host = "::1";
+    char port_str[8];
+    unsigned clients = 8, threads = 4, i, ok = 0, updates = 0, resumes = 0, failures = 0;
+    uint16_t port = UDP_PORT;
+    uint64_t data = 0;
+    double hs_ms = 0, start, elapsed;
+    struct addrinfo hints, *res;
+    client_thread_t *t;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "H:p:c:t:n:f:g:u:rh")) != -1) {
+        switch (opt) {
+        case 'H': host = optarg; break;
+        case 'p': port = (uint16_t)atoi(optarg); break;
+        case 'c': clients = (unsigned)atoi(optarg); break;
+        case 't': threads = (unsigned)atoi(optarg); break;
+        case 'n': messages = (unsigned)atoi(optarg); break;
+        case 'f': frag_size_wanted = (unsigned)atoi(optarg); break;
+        case 'g': data_gap_us = (unsigned)atoi(optarg); break;
+        case 'u': key_update_every = (unsigned)atoi(optarg); break;
+        case 'r': resume_once = 1; break;
+        default: usage(argv[0]); return 1;
+        }
+    }
+    if (threads == 0 || threads > clients) threads = clients ? clients : 1;
+    if (frag_size_wanted < AUTH_FRAG_MIN || frag_size_wanted > REASSEMBLY_MAX_FRAG_SIZE) {
+        fprintf(stderr, "frag_size must be %d..%d\n", AUTH_FRAG_MIN, REASSEMBLY_MAX_FRAG_SIZE);
+        return 1;
+    }
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_socktype = SOCK_DGRAM;
+    snprintf(port_str, sizeof(port_str), "%u", port);
+    if (getaddrinfo(host, port_str, &hints, &res) != 0) {
+        fprintf(stderr, "loadgen: cannot resolve %s\n", host);
+        return 1;
+    }
+    memcpy(&gateway_addr, res->ai_addr, res->ai_addrlen);
+    gateway_addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    t = calloc(threads, sizeof(client_thread_t));
+    if (t == NULL) return 1;
+
+    start = now_ms();
+    for (i = 0; i < threads; i++) {
+        t[i].first_client = i * (clients / threads) + (i < clients % threads ? i : clients % threads);
+        t[i].clients = clients / threads + (i < clients % threads);
+        pthread_create(&t[i].thread, NULL, client_thread, &t[i]);
+    }
+    for (i = 0; i < threads; i++) {
+        pthread_join(t[i].thread, NULL);
+        ok += t[i].handshakes_ok;
+        hs_ms += t[i].handshake_ms;
+        data += t[i].data_sent;
+        updates += t[i].key_updates;
+        resumes += t[i].resumes;
+        failures += t[i].failures;
+    }
+    elapsed = now_ms() - start;
+
+    printf("loadgen: %u/%u handshakes in %.0f ms (mean %.2f ms each incl. signing), "
+           "%llu DATA sent (%.0f msg/s), %u key updates, %u resumes, %u failed\n",
+           ok, clients, elapsed, ok ? hs_ms / ok : 0.0,
+           (unsigned long long)data, elapsed > 0 ? data * 1e3 / elapsed : 0.0,
+           updates, resumes, failures);
+    free(t);
+    return ok == clients && failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+/**
+ * pool.c
+ * Work-Stealing Task Scheduler with Priority Classes (Linux gateway)
+ */
+
+#include "pool.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Only handshakes move between workers: DATA stays on the socket's worker */
+static const uint8_t class_stealable[POOL_CLASSES] = { 0, 1 };
+
+typedef struct {
+    pthread_mutex_t lock;
+    pool_task_t *head;                    // Owner end
+    pool_task_t *tail;                    // Thief end
+    unsigned depth;                        // Written under lock, peeked without
+} deque_t;
+
+/* Counters are written by their worker only and read racily by reports */
+typedef struct {
+    deque_t q[POOL_CLASSES];
+    uint64_t hist[POOL_CLASSES][POOL_HIST_BUCKETS];
+    uint64_t done[POOL_CLASSES];
+    uint64_t stolen[POOL_CLASSES];
+    uint64_t max_ns[POOL_CLASSES];
+    uint64_t dropped[POOL_CLASSES];
+    int wake_fd;
+    int parked;
+} __attribute__((aligned(64))) pool_worker_t;
+
+static pool_worker_t *workers;
+static unsigned worker_count;
+static uint64_t class_depth[POOL_CLASSES];
+static uint64_t class_depth_peak[POOL_CLASSES];
+
+/* ========== HISTOGRAM ========== */
+
+/* Log-linear: exact below POOL_HIST_SUB us, then POOL_HIST_SUB buckets
+ * per power of two (at most 25% wide) */
+static unsigned hist_bucket(uint64_t us) {
+    unsigned e;
+
+    if (us < POOL_HIST_SUB) return (unsigned)us;
+    if (us > 0xFFFFFFFFu) us = 0xFFFFFFFFu;
+    e = 63 - __builtin_clzll(us);
+    return (e - 1) * POOL_HIST_SUB + (unsigned)((us >> (e - 2)) & (POOL_HIST_SUB - 1));
+}
+
+static uint64_t hist_upper(unsigned b) {
+    unsigned e = b / POOL_HIST_SUB + 1;
+
+    if (b < POOL_HIST_SUB) return b;
+    return ((uint64_t)(POOL_HIST_SUB + b % POOL_HIST_SUB + 1) << (e - 2)) - 1;
+}
+
+static void counter_add(uint64_t *c, uint64_t v) {
+    __atomic_store_n(c, __atomic_load_n(c, __ATOMIC_RELAXED) + v, __ATOMIC_RELAXED);
+}
+
+/* ========== DEQUES ========== */
+
+static void deque_push_back(deque_t *q, pool_task_t *t) {
+    t->next = NULL;
+    t->prev = q->tail;
+    if (q->tail != NULL) q->tail->next = t;
+    else q->head = t;
+    q->tail = t;
+    __atomic_store_n(&q->depth, q->depth + 1, __ATOMIC_RELAXED);
+}
+
+static pool_task_t *deque_take(deque_t *q, int from_back) {
+    pool_task_t *t;
+
+    if (__atomic_load_n(&q->depth, __ATOMIC_RELAXED) == 0) return NULL;
+    pthread_mutex_lock(&q->lock);
+    t = from_back ? q->tail : q->head;
+    if (t != NULL) {
+        if (t->prev != NULL) t->prev->next = t->next;
+        else q->head = t->next;
+        if (t->next != NULL) t->next->prev = t->prev;
+        else q->tail = t->prev;
+        __atomic_store_n(&q->depth, q->depth - 1, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return t;
+}
+
+/* ========== SCHEDULER ========== */
+
+int pool_init(unsigned count) {
+    unsigned i, c;
+
+    workers = aligned_alloc(64, count * sizeof(pool_worker_t));
+    if (workers == NULL) return -1;
+    memset(workers, 0, count * sizeof(pool_worker_t));
+
+    for (i = 0; i < count; i++) {
+        for (c = 0; c < POOL_CLASSES; c++) {
+            pthread_mutex_init(&workers[i].q[c].lock, NULL);
+        }
+        workers[i].wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (workers[i].wake_fd < 0) return -1;
+    }
+    worker_count = count;
+    return 0;
+}
+
+uint64_t pool_now_ns(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/* Wake one parked worker other than self (the pusher is awake anyway) */
+static void wake_one(unsigned self) {
+    unsigned i;
+
+    for (i = 1; i < worker_count; i++) {
+        pool_worker_t *sw = &workers[(self + i) % worker_count];
+        int expected = 1;
+
+        if (__atomic_compare_exchange_n(&sw->parked, &expected, 0, 0,
+                                        __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+            uint64_t one = 1;
+            if (write(sw->wake_fd, &one, sizeof(one)) < 0) {
+                /* Counter saturated: it is readable already */
+            }
+            return;
+        }
+    }
+}
+
+int pool_push(unsigned worker, pool_task_t *t) {
+    deque_t *q = &workers[worker].q[t->cls];
+    uint64_t depth, peak;
+
+    /* Claim a slot under the global cap first, then the worker's. SEQ_CST
+     * pairs with pool_park(): either the parker sees the depth or we see
+     * it parked (a parker that sees the claim early just polls again). */
+    depth = __atomic_add_fetch(&class_depth[t->cls], 1, __ATOMIC_SEQ_CST);
+    if (depth > POOL_DEPTH_MAX) {
+        __atomic_sub_fetch(&class_depth[t->cls], 1, __ATOMIC_RELAXED);
+        pool_drop(worker, t->cls);
+        return -1;
+    }
+    t->owner = (uint16_t)worker;
+    pthread_mutex_lock(&q->lock);
+    if (q->depth >= POOL_WORKER_DEPTH_MAX) {
+        pthread_mutex_unlock(&q->lock);
+        __atomic_sub_fetch(&class_depth[t->cls], 1, __ATOMIC_RELAXED);
+        pool_drop(worker, t->cls);
+        return -1;
+    }
+    deque_push_back(q, t);
+    pthread_mutex_unlock(&q->lock);
+
+    peak = __atomic_load_n(&class_depth_peak[t->cls], __ATOMIC_RELAXED);
+    while (depth > peak &&
+           !__atomic_compare_exchange_n(&class_depth_peak[t->cls], &peak, depth, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+    if (class_stealable[t->cls]) {
+        wake_one(worker);
+    }
+    return 0;
+}
+
+int pool_admit(unsigned worker, unsigned cls) {
+    return __atomic_load_n(&class_depth[cls], __ATOMIC_RELAXED) < POOL_DEPTH_MAX &&
+           __atomic_load_n(&workers[worker].q[cls].depth, __ATOMIC_RELAXED) <
+               POOL_WORKER_DEPTH_MAX;
+}
+
+void pool_drop(unsigned worker, unsigned cls) {
+    counter_add(&workers[worker].dropped[cls], 1);
+}
+
+pool_task_t *pool_pop(unsigned worker, unsigned cls) {
+    pool_task_t *t = deque_take(&workers[worker].q[cls], 0);
+    unsigned i;
+
+    if (t == NULL && class_stealable[cls] &&
+        __atomic_load_n(&class_depth[cls], __ATOMIC_RELAXED) > 0) {
+        for (i = 1; i < worker_count && t == NULL; i++) {
+            t = deque_take(&workers[(worker + i) % worker_count].q[cls], 1);
+        }
+    }
+    if (t != NULL) {
+        __atomic_sub_fetch(&class_depth[cls], 1, __ATOMIC_RELAXED);
+    }
+    return t;
+}
+
+void pool_done(unsigned worker, const pool_task_t *t) {
+    pool_worker_t *sw = &workers[worker];
+    uint64_t now = pool_now_ns();
+    uint64_t ns = now > t->enqueued_ns ? now - t->enqueued_ns : 0;
+
+    counter_add(&sw->hist[t->cls][hist_bucket(ns / 1000)], 1);
+    counter_add(&sw->done[t->cls], 1);
+    if (t->owner != worker) {
+        counter_add(&sw->stolen[t->cls], 1);
+    }
+    if (ns > sw->max_ns[t->cls]) {
+        __atomic_store_n(&sw->max_ns[t->cls], ns, __ATOMIC_RELAXED);
+    }
+}
+
+/* ========== PARKING ========== */
+
+int pool_wake_fd(unsigned worker) {
+    return workers[worker].wake_fd;
+}
+
+int pool_park(unsigned worker) {
+    unsigned c;
+
+    __atomic_store_n(&workers[worker].parked, 1, __ATOMIC_SEQ_CST);
+    for (c = 0; c < POOL_CLASSES; c++) {
+        if (class_stealable[c] && __atomic_load_n(&class_depth[c], __ATOMIC_SEQ_CST) > 0) {
+            __atomic_store_n(&workers[worker].parked, 0, __ATOMIC_RELAXED);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void pool_unpark(unsigned worker) {
+    uint64_t count;
+
+    __atomic_store_n(&workers[worker].parked, 0, __ATOMIC_RELAXED);
+    if (read(workers[worker].wake_fd, &count, sizeof(count)) < 0) {
+        /* Not woken through the eventfd */
+    }
+}
+
+/* ========== STATISTICS ========== */
+
+/* Upper bound of the bucket holding the permille-th sample, capped at
+ * the largest sample seen (the bucket bound may lie above it) */
+static uint64_t hist_percentile(const uint64_t *hist, uint64_t total, unsigned permille,
+                                uint64_t max_us) {
+    uint64_t seen = 0;
+    uint64_t upper = hist_upper(POOL_HIST_BUCKETS - 1);
+    unsigned b;
+
+    if (total == 0) return 0;
+    for (b = 0; b < POOL_HIST_BUCKETS; b++) {
+        seen += hist[b];
+        if (seen * 1000 >= total * permille) {
+            upper = hist_upper(b);
+            break;
+        }
+    }
+    return upper < max_us ? upper : max_us;
+}
+
+void pool_stats(unsigned cls, pool_class_stats_t *st) {
+    uint64_t hist[POOL_HIST_BUCKETS];
+    uint64_t total = 0;
+    unsigned i, b;
+
+    memset(st, 0, sizeof(*st));
+    memset(hist, 0, sizeof(hist));
+    for (i = 0; i < worker_count; i++) {
+        pool_worker_t *sw = &workers[i];
+        uint64_t max_ns = __atomic_load_n(&sw->max_ns[cls], __ATOMIC_RELAXED);
+
+        for (b = 0; b < POOL_HIST_BUCKETS; b++) {
+            hist[b] += __atomic_load_n(&sw->hist[cls][b], __ATOMIC_RELAXED);
+        }
+        st->done += __atomic_load_n(&sw->done[cls], __ATOMIC_RELAXED);
+        st->stolen += __atomic_load_n(&sw->stolen[cls], __ATOMIC_RELAXED);
+        st->dropped += __atomic_load_n(&sw->dropped[cls], __ATOMIC_RELAXED);
+        if (max_ns / 1000 > st->max_us) st->max_us = max_ns / 1000;
+    }
+    st->depth = __atomic_load_n(&class_depth[cls], __ATOMIC_RELAXED);
+    st->depth_peak = __atomic_load_n(&class_depth_peak[cls], __ATOMIC_RELAXED);
+
+    /* Percentiles over the merged histogram (racy reads may not sum to done) */
+    for (b = 0; b < POOL_HIST_BUCKETS; b++) total += hist[b];
+    st->p50_us = hist_percentile(hist, total, 500, st->max_us);
+    st->p99_us = hist_percentile(hist, total, 990, st->max_us);
+    st->p999_us = hist_percentile(hist, total, 999, st->max_us);
+}
@@ -0,0 +1,132 @@
+/**
+ * pool.h
+ * Work-Stealing Task Scheduler with Priority Classes (Linux gateway)
+ *
+ * Every worker owns one deque per class. A worker takes its own work
+ * from the front; when a stealable class is empty locally it steals
+ * from the back of the other workers' deques. Classes are strict
+ * priorities, lowest number first: the worker loop asks for class 0
+ * until it is dry before it touches class 1.
+ *
+ * DATA decryption is class 0 and stays with the worker whose socket
+ * received it (no cross-core session traffic, per-session order kept).
+ * Handshake verification is class 1 and stealable: a flood landing on
+ * one socket is spread over every idle worker, and each worker runs it
+ * in ring_verify_step() slices so DATA never waits more than one slice.
+ *
+ * Queues are bounded per class, at each worker and over all workers, so
+ * a flood cannot grow memory without limit: a push beyond either cap is
+ * refused and counted, and the caller drops the work unacknowledged.
+ *
+ * Tasks are intrusive (pool_task_t first in the concrete task). The
+ * time from enqueue (the kernel receive timestamp for packets) to
+ * pool_done() is kept per worker and class in log-linear histograms.
+ */
+
+#ifndef POOL_H_
+#define POOL_H_
+
+#include <stdint.h>
+
+#define POOL_CLASS_DATA 0
+#define POOL_CLASS_HANDSHAKE 1
+#define POOL_CLASSES 2
+
+#ifndef POOL_WORKER_DEPTH_MAX
+#define POOL_WORKER_DEPTH_MAX 256          // Tasks of one class queued at one worker
+#endif
+#ifndef POOL_DEPTH_MAX
+#define POOL_DEPTH_MAX 1024                // Tasks of one class queued over all workers
+#endif
+
+#define POOL_HIST_SUB 4                   // Linear sub-buckets per power of two
+#define POOL_HIST_BUCKETS (32 * POOL_HIST_SUB)
+
+typedef struct pool_task {
+    struct pool_task *prev;
+    struct pool_task *next;
+    uint64_t enqueued_ns;                  // CLOCK_REALTIME, as SO_TIMESTAMPNS
+    uint16_t owner;                        // Worker whose deque it was pushed to
+    uint8_t cls;
+} pool_task_t;
+
+/**
+ * Snapshot of one class over all workers
+ */
+typedef struct {
+    uint64_t done;                         // Tasks completed
+    uint64_t stolen;                       // ... of which by another worker
+    uint64_t depth;                        // Queued now
+    uint64_t depth_peak;
+    uint64_t dropped;                      // Refused at a queue cap
+    uint64_t p50_us;                       // Latency bucket upper bounds
+    uint64_t p99_us;
+    uint64_t p999_us;
+    uint64_t max_us;
+} pool_class_stats_t;
+
+/**
+ * Allocate the deques and wake-up eventfds
+ * @returns 0, or -1 on out of memory / no eventfd
+ */
+int pool_init(unsigned workers);
+
+/**
+ * Now on the task clock (CLOCK_REALTIME, ns)
+ */
+uint64_t pool_now_ns(void);
+
+/**
+ * Queue t (cls and enqueued_ns set by the caller) at the back of the
+ * worker's deque. A stealable class wakes one parked worker.
+ * @returns 0, or -1 if a queue cap was reached (counted as dropped; the
+ *          caller still owns t)
+ */
+int pool_push(unsigned worker, pool_task_t *t);
+
+/**
+ * Whether a task of the class would fit under both caps now (a racy
+ * peek, checked before accepting work that would become one)
+ */
+int pool_admit(unsigned worker, unsigned cls);
+
+/**
+ * Count work of the class turned away after pool_admit() said no
+ */
+void pool_drop(unsigned worker, unsigned cls);
+
+/**
+ * Next task of a class: own deque first, then (stealable classes only)
+ * the back of the other workers' deques
+ * @returns The task, or NULL if there is none
+ */
+pool_task_t *pool_pop(unsigned worker, unsigned cls);
+
+/**
+ * Record a finished task's latency; the caller frees it afterwards
+ */
+void pool_done(unsigned worker, const pool_task_t *t);
+
+/**
+ * eventfd the worker adds to its epoll set: readable when stealable
+ * work was queued while it was parked
+ */
+int pool_wake_fd(unsigned worker);
+
+/**
+ * Mark the worker idle before it blocks
+ * @returns 0 if parked, -1 if stealable work is already queued (do not block)
+ */
+int pool_park(unsigned worker);
+
+/**
+ * Clear the idle mark after blocking and drain the eventfd
+ */
+void pool_unpark(unsigned worker);
+
+/**
+ * Merge the workers' counters and histograms for one class
+ */
+void pool_stats(unsigned cls, pool_class_stats_t *st);
+
+#endif /* POOL_H_ */
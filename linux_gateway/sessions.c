@@ -0,0 +1,241 @@
+/**
+ * sessions.c
+ * SID-Sharded Session Table (Linux gateway)
+ */
+
+#include "sessions.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/random.h>
+
+typedef struct {
+    pthread_mutex_t lock;
+    gw_session_t *slots;
+    int32_t *sid_head;                     // Chains by SID hash
+    int32_t *peer_head;                    // Chains by peer hash
+    int32_t free_head;                     // Free slots, linked through sid_next
+    uint32_t mask;                         // Buckets - 1
+    unsigned used;
+} shard_t;
+
+static shard_t *shards;
+static unsigned shard_count;
+static unsigned shard_capacity;
+
+/* ========== HASHING ========== */
+
+/* SIDs are random: bytes 1..4 index directly (byte 0 carries the shard) */
+static uint32_t sid_hash(const uint8_t *sid) {
+    return ((uint32_t)sid[1] << 24) | ((uint32_t)sid[2] << 16) |
+           ((uint32_t)sid[3] << 8) | (uint32_t)sid[4];
+}
+
+static uint32_t peer_hash(const struct sockaddr_in6 *peer) {
+    const uint8_t *a = peer->sin6_addr.s6_addr;
+    uint32_t h = 2166136261u;              // FNV-1a
+    int i;
+
+    for (i = 0; i < 16; i++) h = (h ^ a[i]) * 16777619u;
+    h = (h ^ (peer->sin6_port & 0xFF)) * 16777619u;
+    h = (h ^ (peer->sin6_port >> 8)) * 16777619u;
+    return h;
+}
+
+static int peer_equal(const struct sockaddr_in6 *a, const struct sockaddr_in6 *b) {
+    return a->sin6_port == b->sin6_port &&
+           memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(a->sin6_addr)) == 0;
+}
+
+/* ========== CHAINS ========== */
+
+static void chain_unlink(shard_t *sh, int32_t *head, int32_t idx, int by_peer) {
+    int32_t *link = head;
+
+    while (*link != -1) {
+        gw_session_t *s = &sh->slots[*link];
+        if (*link == idx) {
+            *link = by_peer ? s->peer_next : s->sid_next;
+            return;
+        }
+        link = by_peer ? &s->peer_next : &s->sid_next;
+    }
+}
+
+static void slot_free(shard_t *sh, gw_session_t *s) {
+    int32_t idx = (int32_t)(s - sh->slots);
+
+    chain_unlink(sh, &sh->sid_head[sid_hash(s->se.sid) & sh->mask], idx, 0);
+    chain_unlink(sh, &sh->peer_head[peer_hash(&s->peer) & sh->mask], idx, 1);
+    secure_zero(&s->se, sizeof(s->se));
+    secure_zero(&s->prev, sizeof(s->prev));
+    s->sid_next = sh->free_head;
+    sh->free_head = idx;
+    sh->used--;
+}
+
+/* ========== TABLE ========== */
+
+int sessions_init(unsigned count, unsigned capacity) {
+    unsigned i, j, buckets = 1;
+
+    if (count == 0 || count > 256 || capacity == 0) return -1;
+    while (buckets < capacity) buckets <<= 1;
+
+    shards = calloc(count, sizeof(shard_t));
+    if (shards == NULL) return -1;
+
+    for (i = 0; i < count; i++) {
+        shard_t *sh = &shards[i];
+
+        sh->slots = calloc(capacity, sizeof(gw_session_t));
+        sh->sid_head = malloc(buckets * sizeof(int32_t));
+        sh->peer_head = malloc(buckets * sizeof(int32_t));
+        if (sh->slots == NULL || sh->sid_head == NULL || sh->peer_head == NULL) {
+            return -1;
+        }
+        pthread_mutex_init(&sh->lock, NULL);
+        for (j = 0; j < buckets; j++) {
+            sh->sid_head[j] = -1;
+            sh->peer_head[j] = -1;
+        }
+        for (j = 0; j < capacity; j++) {
+            sh->slots[j].shard = i;
+            sh->slots[j].sid_next = (j + 1 < capacity) ? (int32_t)(j + 1) : -1;
+        }
+        sh->free_head = 0;
+        sh->mask = buckets - 1;
+    }
+    shard_count = count;
+    shard_capacity = capacity;
+    return 0;
+}
+
+unsigned sessions_shard_of(const uint8_t *sid) {
+    return sid[0] % shard_count;
+}
+
+/* Random SID whose first byte maps to shard */
+static void sid_generate(uint8_t *sid, unsigned shard) {
+    unsigned base;
+
+    if (getrandom(sid, SID_LEN, 0) != SID_LEN) {
+        crypto_secure_random(sid, SID_LEN);
+    }
+    base = (sid[0] / shard_count) * shard_count;
+    if (base + shard > 255) base -= shard_count;
+    sid[0] = (uint8_t)(base + shard);
+}
+
+gw_session_t *sessions_create(unsigned shard, const uint8_t *K_master,
+                              const struct sockaddr_in6 *peer, uint32_t now) {
+    shard_t *sh = &shards[shard];
+    uint32_t overlap_end = now + SESSION_OVERLAP;
+    uint32_t ph = peer_hash(peer) & sh->mask;
+    gw_session_t *oldest_peer = NULL;
+    gw_session_t *s;
+    int peer_sessions = 0;
+    int32_t idx;
+
+    pthread_mutex_lock(&sh->lock);
+
+    /* Make-before-break, as node-gateway.c: the peer's previous session
+     * stays usable for SESSION_OVERLAP seconds */
+    for (idx = sh->peer_head[ph]; idx != -1; idx = sh->slots[idx].peer_next) {
+        gw_session_t *e = &sh->slots[idx];
+        if (!peer_equal(&e->peer, peer)) continue;
+
+        peer_sessions++;
+        if (e->se.expiry_ts > overlap_end) {
+            e->se.expiry_ts = overlap_end;
+        }
+        if (oldest_peer == NULL || e->se.expiry_ts < oldest_peer->se.expiry_ts) {
+            oldest_peer = e;
+        }
+    }
+    if (peer_sessions >= MAX_SESSIONS_PER_PEER) {
+        slot_free(sh, oldest_peer);
+    }
+
+    /* Full: evict the session closest to expiry */
+    if (sh->free_head == -1) {
+        gw_session_t *victim = &sh->slots[0];
+        unsigned i;
+        for (i = 1; i < shard_capacity; i++) {
+            if (sh->slots[i].se.expiry_ts < victim->se.expiry_ts) {
+                victim = &sh->slots[i];
+            }
+        }
+        slot_free(sh, victim);
+    }
+
+    idx = sh->free_head;
+    s = &sh->slots[idx];
+    sh->free_head = s->sid_next;
+    sh->used++;
+
+    /* SIDs are 64-bit random: a collision inside one shard is not checked */
+    sid_generate(s->se.sid, shard);
+    memcpy(s->se.K_master, K_master, MASTER_KEY_LEN);
+    memcpy(s->se.peer_addr, &peer->sin6_addr, 16);
+    replay_window_reset(&s->se);
+    s->se.epoch = 0;
+    s->se.resume_count = 0;
+    s->se.expiry_ts = now + SESSION_LIFETIME;
+    s->se.in_use = 1;
+    s->peer = *peer;
+
+    s->sid_next = sh->sid_head[sid_hash(s->se.sid) & sh->mask];
+    sh->sid_head[sid_hash(s->se.sid) & sh->mask] = idx;
+    s->peer_next = sh->peer_head[ph];
+    sh->peer_head[ph] = idx;
+    return s;
+}
+
+gw_session_t *sessions_find(const uint8_t *sid, uint32_t now) {
+    shard_t *sh = &shards[sessions_shard_of(sid)];
+    int32_t idx;
+
+    pthread_mutex_lock(&sh->lock);
+    for (idx = sh->sid_head[sid_hash(sid) & sh->mask]; idx != -1;
+         idx = sh->slots[idx].sid_next) {
+        gw_session_t *s = &sh->slots[idx];
+        if (memcmp(s->se.sid, sid, SID_LEN) != 0) continue;
+
+        if (s->se.expiry_ts < now) {
+            slot_free(sh, s);
+            break;
+        }
+        return s;
+    }
+    pthread_mutex_unlock(&sh->lock);
+    return NULL;
+}
+
+void sessions_unlock(gw_session_t *s) {
+    pthread_mutex_unlock(&shards[s->shard].lock);
+}
+
+void sessions_retire(gw_session_t *s) {
+    shard_t *sh = &shards[s->shard];
+
+    slot_free(sh, s);
+    pthread_mutex_unlock(&sh->lock);
+}
+
+unsigned sessions_sweep(unsigned shard, uint32_t now) {
+    shard_t *sh = &shards[shard];
+    unsigned i, live;
+
+    pthread_mutex_lock(&sh->lock);
+    for (i = 0; i < shard_capacity; i++) {
+        gw_session_t *s = &sh->slots[i];
+        if (s->se.in_use && s->se.expiry_ts < now) {
+            slot_free(sh, s);
+        }
+    }
+    live = sh->used;
+    pthread_mutex_unlock(&sh->lock);
+    return live;
+}
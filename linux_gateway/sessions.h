@@ -0,0 +1,84 @@
+/**
+ * sessions.h
+ * SID-Sharded Session Table (Linux gateway)
+ *
+ * Sessions are split into shards, one per worker thread, each with its
+ * own lock and hash index. The shard is encoded in the SID (first byte
+ * modulo the shard count), so any worker finds a session from the DATA
+ * header alone. A worker creates sessions in its own shard; as the
+ * kernel steers a sender's packets to one worker, locks are almost
+ * never contended.
+ */
+
+#ifndef SESSIONS_H_
+#define SESSIONS_H_
+
+#include <netinet/in.h>
+#include <stdint.h>
+#include "crypto_core.h"
+
+#ifndef SESSION_LIFETIME
+#define SESSION_LIFETIME 3600              // Seconds a session stays valid
+#endif
+#define SESSION_OVERLAP 120                // Seconds a peer's previous session survives renewal
+#define MAX_SESSIONS_PER_PEER 2            // Current session + the one it replaces
+
+/**
+ * Gateway session: the shared session_entry_t plus the peer's full UDP
+ * address (peers behind one IP are told apart by port)
+ */
+typedef struct {
+    session_entry_t se;
+    session_entry_t prev;                  // Epoch before the last KEY_UPDATE, until
+                                           // DATA under se verifies (prev.in_use)
+    struct sockaddr_in6 peer;
+    int32_t sid_next;                      // Hash chains (slot indices, -1 = end)
+    int32_t peer_next;
+    uint16_t shard;
+} gw_session_t;
+
+/**
+ * Allocate shards x capacity sessions
+ * @returns 0, or -1 on bad arguments / out of memory
+ */
+int sessions_init(unsigned shards, unsigned capacity);
+
+/**
+ * Shard a SID belongs to
+ */
+unsigned sessions_shard_of(const uint8_t *sid);
+
+/**
+ * New session in the given shard with a fresh random SID tagged for it.
+ * The peer's older sessions are cut to SESSION_OVERLAP seconds, the
+ * oldest retired beyond MAX_SESSIONS_PER_PEER, and the soonest-expiring
+ * session evicted if the shard is full.
+ * @returns The session, locked (never NULL)
+ */
+gw_session_t *sessions_create(unsigned shard, const uint8_t *K_master,
+                              const struct sockaddr_in6 *peer, uint32_t now);
+
+/**
+ * Look up a live session by SID (expired ones are removed)
+ * @returns The session, locked, or NULL
+ */
+gw_session_t *sessions_find(const uint8_t *sid, uint32_t now);
+
+/**
+ * Release the lock taken by sessions_create() / sessions_find()
+ */
+void sessions_unlock(gw_session_t *s);
+
+/**
+ * Remove a locked session (e.g. the one a ticket was resumed from) and
+ * release its lock
+ */
+void sessions_retire(gw_session_t *s);
+
+/**
+ * Remove expired sessions from a shard
+ * @returns Sessions still live in the shard
+ */
+unsigned sessions_sweep(unsigned shard, uint32_t now);
+
+#endif /* SESSIONS_H_ */
@@ -0,0 +1,29 @@
+/**
+ * cfs/cfs.h (Linux gateway shim)
+ * The subset of Contiki-NG's file system API the shared sources use,
+ * backed by ordinary files in the working directory as cfs-posix does.
+ */
+
+#ifndef CFS_SHIM_H_
+#define CFS_SHIM_H_
+
+#include <sys/types.h>
+
+#define CFS_READ 1
+#define CFS_WRITE 2
+#define CFS_APPEND 4
+
+#define CFS_SEEK_SET 0
+#define CFS_SEEK_CUR 1
+#define CFS_SEEK_END 2
+
+typedef off_t cfs_offset_t;
+
+int cfs_open(const char *name, int flags);
+void cfs_close(int fd);
+int cfs_read(int fd, void *buf, unsigned int len);
+int cfs_write(int fd, const void *buf, unsigned int len);
+cfs_offset_t cfs_seek(int fd, cfs_offset_t offset, int whence);
+int cfs_remove(const char *name);
+
+#endif /* CFS_SHIM_H_ */
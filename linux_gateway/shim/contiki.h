@@ -0,0 +1,12 @@
+/**
+ * contiki.h (Linux gateway shim)
+ * The few Contiki-NG symbols the shared crypto and reassembly sources
+ * use, so they build unchanged as ordinary Linux objects.
+ */
+
+#ifndef CONTIKI_SHIM_H_
+#define CONTIKI_SHIM_H_
+
+void watchdog_periodic(void);
+
+#endif /* CONTIKI_SHIM_H_ */
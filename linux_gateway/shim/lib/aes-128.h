@@ -0,0 +1,23 @@
+/**
+ * lib/aes-128.h (Linux gateway shim)
+ * Same driver interface as Contiki-NG; the software implementation in
+ * shim.c keeps its key schedule per thread.
+ */
+
+#ifndef AES_128_SHIM_H_
+#define AES_128_SHIM_H_
+
+#include <stdint.h>
+
+#define AES_128_BLOCK_SIZE 16
+#define AES_128_KEY_LENGTH 16
+
+struct aes_128_driver {
+    void (*set_key)(const uint8_t *key);
+    void (*encrypt)(uint8_t *plaintext_and_result);
+};
+
+extern const struct aes_128_driver aes_128_driver;
+#define AES_128 aes_128_driver
+
+#endif /* AES_128_SHIM_H_ */
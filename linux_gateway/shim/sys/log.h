@@ -0,0 +1,33 @@
+/**
+ * sys/log.h (Linux gateway shim)
+ * Contiki-style LOG_* macros on stderr. A message is printed if it is
+ * within both the module's LOG_LEVEL and the run-time log_level (-v).
+ */
+
+#ifndef LOG_SHIM_H_
+#define LOG_SHIM_H_
+
+#include <stdio.h>
+#include "contiki.h"
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DBG 4
+
+extern int log_level;
+
+#define LOG_OUTPUT(level, name, ...) do { \
+        if ((level) <= LOG_LEVEL && (level) <= log_level) { \
+            fprintf(stderr, "[%-4s: %-8s] ", name, LOG_MODULE); \
+            fprintf(stderr, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_ERR(...) LOG_OUTPUT(LOG_LEVEL_ERR, "ERR", __VA_ARGS__)
+#define LOG_WARN(...) LOG_OUTPUT(LOG_LEVEL_WARN, "WARN", __VA_ARGS__)
+#define LOG_INFO(...) LOG_OUTPUT(LOG_LEVEL_INFO, "INFO", __VA_ARGS__)
+#define LOG_DBG(...) LOG_OUTPUT(LOG_LEVEL_DBG, "DBG", __VA_ARGS__)
+
+#endif /* LOG_SHIM_H_ */
@@ -0,0 +1,12 @@
+/**
+ * sys/node-id.h (Linux gateway shim)
+ */
+
+#ifndef NODE_ID_SHIM_H_
+#define NODE_ID_SHIM_H_
+
+#include <stdint.h>
+
+extern uint16_t node_id;
+
+#endif /* NODE_ID_SHIM_H_ */
@@ -0,0 +1,71 @@
+/**
+ * wire.h
+ * Gateway Wire Protocol (Linux gateway and load generator)
+ *
+ * The message types and layouts node-gateway.c and node-sender.c use;
+ * AuthFragment, AuthFecFragment and FragmentAck come from crypto_core.h.
+ * All multi-byte fields are big-endian.
+ */
+
+#ifndef WIRE_H_
+#define WIRE_H_
+
+#include "crypto_core.h"
+
+#define MSG_TYPE_AUTH 0x01
+#define MSG_TYPE_AUTH_ACK 0x02
+#define MSG_TYPE_DATA 0x03
+#define MSG_TYPE_AUTH_FRAG 0x04
+#define MSG_TYPE_FRAG_ACK 0x05
+#define MSG_TYPE_RESUME 0x06
+#define MSG_TYPE_RESUME_ACK 0x07
+#define MSG_TYPE_SESSION_UNKNOWN 0x08
+#define MSG_TYPE_KEY_UPDATE 0x09
+#define MSG_TYPE_KEY_UPDATE_ACK 0x0A
+#define MSG_TYPE_AUTH_FEC 0x0B
+
+#ifndef UDP_PORT
+#define UDP_PORT 5678
+#endif
+
+typedef struct {
+    uint8_t type;
+    uint8_t N_G[32];
+    uint8_t SID[SID_LEN];
+    uint8_t ticket[TICKET_LEN];
+} AuthAckMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t ticket[TICKET_LEN];
+    uint8_t N_S[RESUME_NONCE_LEN];
+    uint8_t binder[RESUME_BINDER_LEN];
+} ResumeMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t N_G[RESUME_NONCE_LEN];
+    uint8_t SID[SID_LEN];
+    uint8_t ticket[TICKET_LEN];
+    uint8_t confirm[RESUME_BINDER_LEN];
+} ResumeAckMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t SID[SID_LEN];
+    uint8_t epoch[2];
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+} KeyUpdateMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t SID[SID_LEN];
+    uint8_t epoch[2];
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+    uint8_t ticket[TICKET_LEN];
+} KeyUpdateAckMessage;
+
+/* DATA: type || SID || counter(4) || cipher_len(2) || ciphertext + tag */
+#define DATA_HDR_LEN (1 + SID_LEN + 4 + 2)
+
+#endif /* WIRE_H_ */
@@ -10,6 +10,8 @@
 #include "net/ipv6/simple-udp.h"
 #include "sys/log.h"
 #include "crypto_core.h"
+#include "reassembly.h"
+#include "key_store.h"
 
 #include <string.h>
 #include <stdio.h>
@@ -27,45 +29,169 @@ static struct simple_udp_connection udp_conn;
 #define MSG_TYPE_DATA 0x03
 #define MSG_TYPE_AUTH_FRAG 0x04
 #define MSG_TYPE_FRAG_ACK 0x05
-
-/* Reassembly buffer */
-static uint8_t reassembly_buf[3000];
+#define MSG_TYPE_RESUME 0x06
+#define MSG_TYPE_RESUME_ACK 0x07
+#define MSG_TYPE_SESSION_UNKNOWN 0x08
+#define MSG_TYPE_KEY_UPDATE 0x09
+#define MSG_TYPE_KEY_UPDATE_ACK 0x0A
+#define MSG_TYPE_AUTH_FEC 0x0B
 
 /* ========== MESSAGE STRUCTURES ========== */
 
 typedef struct {
     uint8_t type;
-    uint8_t syndrome[LDPC_ROWS / 8];
-    Poly512 public_key; /* Added Public Key */
-    RingSignature signature;
-} AuthMessage;
+    uint8_t N_G[32];
+    uint8_t SID[SID_LEN];
+    uint8_t ticket[TICKET_LEN];
+} AuthAckMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t ticket[TICKET_LEN];
+    uint8_t N_S[RESUME_NONCE_LEN];
+    uint8_t binder[RESUME_BINDER_LEN];
+} ResumeMessage;
 
 typedef struct {
     uint8_t type;
-    uint8_t N_G[32];
     uint8_t SID[SID_LEN];
-} AuthAckMessage;
+    uint8_t epoch[2];
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+} KeyUpdateMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t SID[SID_LEN];
+    uint8_t epoch[2];
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+    uint8_t ticket[TICKET_LEN];
+} KeyUpdateAckMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t N_G[RESUME_NONCE_LEN];
+    uint8_t SID[SID_LEN];
+    uint8_t ticket[TICKET_LEN];
+    uint8_t confirm[RESUME_BINDER_LEN];
+} ResumeAckMessage;
 
 /* ========== CRYPTOGRAPHIC STATE ========== */
 
 static RingLWEKeyPair gateway_keypair;
 static LDPCKeyPair gateway_ldpc_keypair;
-static Poly512 ring_public_keys[RING_SIZE];
 
 /* ========== SESSION MANAGEMENT ========== */
 
 static session_entry_t session_table[MAX_SESSIONS];
 
+#define SESSION_LIFETIME 3600              /* Seconds a session stays valid */
+#define SESSION_OVERLAP 120                /* Seconds a peer's previous session survives renewal */
+#define MAX_SESSIONS_PER_PEER 2            /* Current session + the one it replaces */
+#define KEY_UPDATE_OVERLAP_SLOTS 4         /* Sessions holding their previous epoch at once */
+
+/* Previous key epoch of a session whose KEY_UPDATE we answered. The
+ * sender switches only once our ACK arrives, so until the first DATA
+ * under the new epoch verifies, its DATA may still use the old key (all
+ * ACKs lost, or old-epoch DATA reordered). Each entry is a copy of the
+ * session entry, key and replay window, matched by SID. */
+static session_entry_t prev_epoch_table[KEY_UPDATE_OVERLAP_SLOTS];
+static uint8_t prev_epoch_next;
+
+/* ========== HANDSHAKE TRACKING ========== */
+
+/* Every handshake in flight holds a reassembly context from its first
+ * fragment until handshake_process is done with it, so the pool usage
+ * is the gateway's handshake concurrency (peak is logged) */
+static uint8_t handshakes_peak;
+
+/* Largest fragment we accept: one IPv6 datagram (6LoWPAN fragments it
+ * below us), capped by AUTH_FRAG_MAX_SIZE as the sender's first try is */
+#define GATEWAY_MAX_FRAG_SIZE \
+    (UIP_BUFSIZE - UIP_IPUDPH_LEN - AUTH_FRAG_HDR_LEN < AUTH_FRAG_MAX_SIZE ? \
+     UIP_BUFSIZE - UIP_IPUDPH_LEN - AUTH_FRAG_HDR_LEN : AUTH_FRAG_MAX_SIZE)
+
+/* ========== RESUMPTION TICKET KEYS ========== */
+
+/* Ticket keys are derived from the long-term Ring-LWE secret, so tickets
+ * issued before a reboot still open afterwards. Only the current and the
+ * previous epoch keys are cached. The epoch restarts at 0 on every boot,
+ * so the serial (the other half of the seal nonce) is reserved through
+ * key_store and never repeats across reboots. */
+static uint8_t ticket_secret[SHA256_DIGEST_SIZE];
+static uint8_t ticket_key_cur[32];
+static uint8_t ticket_key_prev[32];
+static uint32_t ticket_epoch;
+static uint32_t ticket_epoch_offset;
+static uint32_t ticket_serial;
+static uint8_t ticket_serial_ok;
+
+/* Serials of redeemed tickets. When the cache is full the lowest serial
+ * is dropped and every serial up to it is refused from then on; an older
+ * ticket that was never redeemed then costs its holder a full handshake.
+ * The cache lives in RAM: a gateway reset forgets it, and a ticket
+ * redeemed before the reset can be replayed once. The replay cannot
+ * produce a usable session (the resumed key needs the ticket's K_master),
+ * but it does retire the live session it was issued for. */
+static uint32_t redeemed_serials[TICKET_REDEEMED_CACHE];
+static uint8_t redeemed_count;
+static uint32_t redeemed_floor;
+
 PROCESS(gateway_process, "Ring-LWE Gateway Process");
+PROCESS(handshake_process, "Ring-LWE Handshake Process");
 AUTOSTART_PROCESSES(&gateway_process);
 
 /* ========== SESSION FUNCTIONS ========== */
 
+static session_entry_t *prev_epoch_find(const uint8_t *sid) {
+    int i;
+    for (i = 0; i < KEY_UPDATE_OVERLAP_SLOTS; i++) {
+        if (prev_epoch_table[i].in_use &&
+            memcmp(prev_epoch_table[i].sid, sid, SID_LEN) == 0) {
+            return &prev_epoch_table[i];
+        }
+    }
+    return NULL;
+}
+
+static void prev_epoch_drop(const uint8_t *sid) {
+    session_entry_t *prev = prev_epoch_find(sid);
+    if (prev != NULL) {
+        secure_zero(prev, sizeof(session_entry_t));
+    }
+}
+
+/* Keep se's current epoch before it is replaced */
+static void prev_epoch_keep(const session_entry_t *se) {
+    session_entry_t *prev = prev_epoch_find(se->sid);
+    int i;
+    
+    for (i = 0; prev == NULL && i < KEY_UPDATE_OVERLAP_SLOTS; i++) {
+        if (!prev_epoch_table[i].in_use) prev = &prev_epoch_table[i];
+    }
+    if (prev == NULL) {
+        /* All taken: that sender's old-epoch DATA is lost if its ACK was */
+        prev = &prev_epoch_table[prev_epoch_next];
+        prev_epoch_next = (prev_epoch_next + 1) % KEY_UPDATE_OVERLAP_SLOTS;
+        LOG_INFO("Dropping previous epoch of SID [%02x%02x%02x%02x...]\n",
+                 prev->sid[0], prev->sid[1], prev->sid[2], prev->sid[3]);
+    }
+    *prev = *se;
+}
+
+static void session_zero(session_entry_t *se) {
+    prev_epoch_drop(se->sid);
+    secure_zero(se, sizeof(session_entry_t));
+}
+
 static session_entry_t* find_session(const uint8_t *sid) {
     int i;
     for (i = 0; i < MAX_SESSIONS; i++) {
         if (session_table[i].in_use &&
             memcmp(session_table[i].sid, sid, SID_LEN) == 0) {
+            if (session_table[i].expiry_ts < clock_seconds()) {
+                session_zero(&session_table[i]);
+                return NULL;
+            }
             return &session_table[i];
         }
     }
@@ -76,8 +202,33 @@ static session_entry_t* create_session(const uint8_t *sid,
                                       const uint8_t *K_master,
                                       const uip_ipaddr_t *peer) {
     session_entry_t *se = NULL;
+    session_entry_t *oldest_peer = NULL;
+    uint32_t overlap_end = clock_seconds() + SESSION_OVERLAP;
+    int peer_sessions = 0;
     int i;
     
+    /* Make-before-break: the peer's previous session stays usable for
+     * SESSION_OVERLAP seconds so DATA sent under the old SID still decrypts */
+    for (i = 0; i < MAX_SESSIONS; i++) {
+        session_entry_t *e = &session_table[i];
+        if (!e->in_use || memcmp(e->peer_addr, peer, 16) != 0) continue;
+        
+        peer_sessions++;
+        if (e->expiry_ts > overlap_end) {
+            e->expiry_ts = overlap_end;
+        }
+        if (oldest_peer == NULL || e->expiry_ts < oldest_peer->expiry_ts) {
+            oldest_peer = e;
+        }
+    }
+    if (peer_sessions >= MAX_SESSIONS_PER_PEER) {
+        LOG_INFO("Retiring oldest session of renewing peer\n");
+        session_zero(oldest_peer);
+    } else if (peer_sessions > 0) {
+        LOG_INFO("Peer renewing: previous session kept for %us overlap\n",
+                 (unsigned)SESSION_OVERLAP);
+    }
+    
     /* Find free slot */
     for (i = 0; i < MAX_SESSIONS; i++) {
         if (!session_table[i].in_use) {
@@ -95,20 +246,161 @@ static session_entry_t* create_session(const uint8_t *sid,
             }
         }
         LOG_INFO("Evicting old session\n");
-        secure_zero(se->K_master, MASTER_KEY_LEN);
+        session_zero(se);
     }
     
     /* Initialize session */
     memcpy(se->sid, sid, SID_LEN);
     memcpy(se->K_master, K_master, MASTER_KEY_LEN);
     memcpy(se->peer_addr, peer, 16);
-    se->last_seq = 0;
-    se->expiry_ts = 3600; // Placeholder
+    replay_window_reset(se);
+    se->epoch = 0;
+    se->resume_count = 0;
+    se->expiry_ts = clock_seconds() + SESSION_LIFETIME;
     se->in_use = 1;
     
     return se;
 }
 
+/* ========== HANDSHAKE TRACKING FUNCTIONS ========== */
+
+static void handshake_started(void) {
+    int active = reassembly_in_use();
+    
+    if (active > handshakes_peak) {
+        handshakes_peak = active;
+    }
+    LOG_INFO("[Handshake] started, active=%d peak=%u\n",
+             active, handshakes_peak);
+}
+
+static void handshake_finished(reassembly_ctx_t *ctx) {
+    uint32_t elapsed = clock_seconds() - ctx->started;
+    
+    reassembly_release(ctx);
+    LOG_INFO("[Handshake] finished in %lus, active=%d peak=%u\n",
+             (unsigned long)elapsed, reassembly_in_use(), handshakes_peak);
+}
+
+static void handshake_sweep(void) {
+    int dropped = reassembly_expire(clock_seconds());
+    
+    if (dropped > 0) {
+        LOG_INFO("[Handshake] %d abandoned, active=%d peak=%u\n",
+                 dropped, reassembly_in_use(), handshakes_peak);
+    }
+}
+
+/* ========== TICKET FUNCTIONS ========== */
+
+static void ticket_keys_init(void) {
+    uint8_t sk_bytes[POLY_DEGREE * 4];
+    
+    serialize_poly_small(sk_bytes, &gateway_keypair.secret);
+    sha256_hash(ticket_secret, sk_bytes, sizeof(sk_bytes));
+    secure_zero(sk_bytes, sizeof(sk_bytes));
+    
+    ticket_epoch = 0;
+    ticket_epoch_offset = 0;
+    ticket_key_derive(ticket_key_cur, ticket_secret, 0);
+    memset(ticket_key_prev, 0, sizeof(ticket_key_prev));
+    
+    ticket_serial_ok = (key_store_serial_load(&ticket_serial) == 0);
+    if (!ticket_serial_ok) {
+        LOG_ERR("Ticket serials not reserved, resumption disabled\n");
+    }
+    redeemed_count = 0;
+    redeemed_floor = 0;
+}
+
+static void ticket_keys_rotate(uint32_t epoch) {
+    if (epoch == ticket_epoch) return;
+    
+    if (epoch == ticket_epoch + 1) {
+        memcpy(ticket_key_prev, ticket_key_cur, 32);
+    } else {
+        ticket_key_derive(ticket_key_prev, ticket_secret, epoch - 1);
+    }
+    ticket_key_derive(ticket_key_cur, ticket_secret, epoch);
+    ticket_epoch = epoch;
+    LOG_INFO("Ticket key rotated (epoch %u)\n", (unsigned)ticket_epoch);
+}
+
+/* Seals a ticket for se. If no serial can be reserved the ticket is left
+ * zeroed: it never opens and the sender falls back to a full handshake. */
+static int ticket_issue(uint8_t *ticket, const session_entry_t *se) {
+    session_ticket_state_t st;
+    
+    if (!ticket_serial_ok || key_store_serial_reserve(ticket_serial) != 0) {
+        ticket_serial_ok = 0;
+        memset(ticket, 0, TICKET_LEN);
+        return -1;
+    }
+    
+    memcpy(st.K_master, se->K_master, MASTER_KEY_LEN);
+    memcpy(st.sid, se->sid, SID_LEN);
+    st.counter = se->last_seq;
+    st.expiry_epoch = ticket_epoch + TICKET_LIFETIME_EPOCHS;
+    st.resume_count = se->resume_count;
+    
+    ticket_seal(ticket, &st, ticket_key_cur, ticket_epoch, ticket_serial++);
+    secure_zero(&st, sizeof(st));
+    return 0;
+}
+
+static int ticket_redeemed(uint32_t serial) {
+    uint8_t i;
+    
+    if (serial < redeemed_floor) return 1;
+    for (i = 0; i < redeemed_count; i++) {
+        if (redeemed_serials[i] == serial) return 1;
+    }
+    return 0;
+}
+
+static void ticket_mark_redeemed(uint32_t serial) {
+    uint8_t i, low = 0;
+    
+    if (redeemed_count < TICKET_REDEEMED_CACHE) {
+        redeemed_serials[redeemed_count++] = serial;
+        return;
+    }
+    /* Full: raise the floor past the lowest serial and reuse its slot */
+    for (i = 1; i < TICKET_REDEEMED_CACHE; i++) {
+        if (redeemed_serials[i] < redeemed_serials[low]) low = i;
+    }
+    redeemed_floor = redeemed_serials[low] + 1;
+    redeemed_serials[low] = serial;
+}
+
+/* Opens a ticket under the current or previous key. A ticket from a later
+ * epoch than ours means we rebooted: if it authenticates, fast-forward. */
+static int ticket_redeem(session_ticket_state_t *st, const uint8_t *ticket) {
+    uint32_t epoch = ticket_key_epoch(ticket);
+    uint8_t key[32];
+    
+    if (epoch == ticket_epoch) {
+        if (ticket_open(st, ticket, ticket_key_cur) != 0) return -1;
+    } else if (ticket_epoch > 0 && epoch == ticket_epoch - 1) {
+        if (ticket_open(st, ticket, ticket_key_prev) != 0) return -1;
+    } else if (epoch > ticket_epoch) {
+        ticket_key_derive(key, ticket_secret, epoch);
+        int ret = ticket_open(st, ticket, key);
+        secure_zero(key, sizeof(key));
+        if (ret != 0) return -1;
+        ticket_epoch_offset += epoch - ticket_epoch;
+        ticket_keys_rotate(epoch);
+    } else {
+        return -1; // Sealed under a retired key
+    }
+    
+    if (st->expiry_epoch < ticket_epoch) {
+        secure_zero(st, sizeof(*st));
+        return -1;
+    }
+    return 0;
+}
+
 /* ========== UDP RECEIVE CALLBACK ========== */
 
 static void
@@ -129,135 +421,262 @@ udp_rx_callback(struct simple_udp_connection *c,
     LOG_INFO("Received message type 0x%02x\n", msg_type);
     
     if (msg_type == MSG_TYPE_AUTH_FRAG) {
-        AuthFragment *frag = (AuthFragment *)data;
+        if (datalen < AUTH_FRAG_HDR_LEN) {
+            return;
+        }
+        const AuthFragment *frag = (const AuthFragment *)data;
+        
+        uint16_t handshake_id = uip_ntohs(frag->session_id);
+        uint16_t fragment_id = frag->fragment_id;
+        uint16_t total_frags = frag->total_frags;
+        uint16_t frag_size = uip_ntohs(frag->frag_size);
+        uint16_t payload_len = datalen - AUTH_FRAG_HDR_LEN;
+        reassembly_ctx_t *ctx;
+        uint8_t created;
+        FragmentAck ack;
+        uint16_t cum_ack = 0;
+        uint32_t sack = 0;
         
-        uint16_t fragment_id = uip_ntohs(frag->fragment_id);
-        uint16_t total_frags = uip_ntohs(frag->total_frags);
-        uint16_t payload_len = uip_ntohs(frag->payload_len);
+        LOG_INFO("Received Fragment %d/%d (%d of %d bytes) of handshake %04x\n",
+                 fragment_id + 1, total_frags, payload_len, frag_size, handshake_id);
         
-        LOG_INFO("Received Fragment %d/%d (%d bytes)\n",
-                 fragment_id + 1, total_frags, payload_len);
+        int ret = reassembly_add(sender_ip_copy.u8, handshake_id,
+                                 fragment_id, total_frags, frag_size,
+                                 frag->payload, payload_len,
+                                 clock_seconds(), &ctx, &created);
         
-        /* Store payload */
-        size_t offset = fragment_id * 64;
-        if (offset + payload_len <= sizeof(reassembly_buf)) {
-            memcpy(reassembly_buf + offset, frag->payload, payload_len);
+        /* No ACK when the fragment was not stored: the sender retransmits */
+        if (ret == REASSEMBLY_ERR_FULL) {
+            LOG_INFO("[Handshake] reassembly pool full (%d), deferring fragment\n",
+                     REASSEMBLY_POOL_SIZE);
+            return;
+        }
+        if (ret == REASSEMBLY_ERR_INVALID) {
+            LOG_ERR("Invalid AUTH fragment %u/%u dropped\n",
+                    (unsigned)fragment_id, (unsigned)total_frags);
+            return;
+        }
+        if (ret == REASSEMBLY_ERR_FRAG_SIZE) {
+            /* Empty ACK carrying our limit: the sender restarts smaller */
+            LOG_INFO("Fragment size %u refused, advertising %u\n",
+                     (unsigned)frag_size, (unsigned)reassembly_max_frag_size());
+        } else if (ret == REASSEMBLY_STALE) {
+            /* Late retransmit of a finished handshake: all of it is in */
+            cum_ack = total_frags;
+        } else {
+            if (created) {
+                handshake_started();
+            }
+            reassembly_ack_state(ctx, &cum_ack, &sack);
         }
         
-        /* Send ACK */
-        FragmentAck ack;
+        /* Cumulative ACK + SACK so the sender retransmits only the gaps */
         ack.type = MSG_TYPE_FRAG_ACK;
+        ack.handshake_id = frag->session_id;
         ack.fragment_id = frag->fragment_id;
+        ack.cum_ack = cum_ack;
+        ack.sack = uip_htonl(sack);
+        ack.max_frag_size = uip_htons(reassembly_max_frag_size());
         simple_udp_sendto(&udp_conn, &ack, sizeof(FragmentAck), &sender_ip_copy);
         
-        /* Check if last fragment */
-        if (fragment_id == total_frags - 1) {
-            LOG_INFO("Reassembly complete. Verifying signature...\n");
-            
-            static AuthMessage auth_msg_store;
-            AuthMessage *auth_msg = &auth_msg_store;
-            size_t offset = 0;
-            
-            auth_msg->type = reassembly_buf[offset++];
-            memcpy(auth_msg->syndrome, reassembly_buf + offset, LDPC_ROWS / 8);
-            offset += LDPC_ROWS / 8;
-            
-            deserialize_poly512(&auth_msg->public_key, reassembly_buf + offset);
-            offset += POLY_DEGREE * 4;
-            
-            int i;
-            for(i=0; i<RING_SIZE; i++) {
-                deserialize_poly512(&auth_msg->signature.S[i], reassembly_buf + offset);
-                offset += POLY_DEGREE * 4;
-            }
-            deserialize_poly512(&auth_msg->signature.w, reassembly_buf + offset);
-            offset += POLY_DEGREE * 4;
-            
-            memcpy(auth_msg->signature.commitment, reassembly_buf + offset, SHA256_DIGEST_SIZE);
-            offset += SHA256_DIGEST_SIZE;
-            
-            memcpy(auth_msg->signature.keyword, reassembly_buf + offset, KEYWORD_SIZE);
-            offset += KEYWORD_SIZE;
-            
-            /* Use received public key for verification (Index 0) */
-            ring_public_keys[0] = auth_msg->public_key;
-            
-            /* Verify signature */
-            LOG_INFO("Verifying with key[0]:\n");
-            poly_print("Verify Key", &ring_public_keys[0], 8);
-            
-            /* DEBUG: Check Signature integrity */
-            LOG_INFO("DEBUG: Received Signature w (first 8 coeffs):\n");
-            poly_print("Recv Sig.w", &auth_msg->signature.w, 8);
-            LOG_INFO("DEBUG: Received Commitment (first 4 bytes): %02x%02x%02x%02x\n",
-                     auth_msg->signature.commitment[0], auth_msg->signature.commitment[1],
-                     auth_msg->signature.commitment[2], auth_msg->signature.commitment[3]);
-            int verify_result = ring_verify(&auth_msg->signature, ring_public_keys);
-            
-            if (verify_result != 1) {
-                LOG_ERR("Ring signature verification FAILED!\n");
-                return;
-            }
-            
-            LOG_INFO("Ring signature verified: SUCCESS\n");
-            
-            /* Extract syndrome */
-            uint8_t received_syndrome[LDPC_ROWS / 8];
-            memcpy(received_syndrome, auth_msg->syndrome, LDPC_ROWS / 8);
-            
-            /* LDPC decode */
-            LOG_INFO("Decoding LDPC syndrome...\n");
-            ErrorVector recovered_error;
-            int decode_ret = sldspa_decode(&recovered_error, received_syndrome,
-                                          &gateway_ldpc_keypair);
+        /* All fragments present: hand off to handshake_process; a new one
+         * may also extend the prefix it is pre-verifying */
+        if (ret == REASSEMBLY_COMPLETE) {
+            process_poll(&handshake_process);
+            LOG_INFO("Reassembly complete, handshake %04x queued\n", handshake_id);
+        } else if (ret == REASSEMBLY_PENDING) {
+            process_poll(&handshake_process);
+        }
+        return;
+    }
+    
+    if (msg_type == MSG_TYPE_AUTH_FEC) {
+        /* ===== ERASURE-CODED AUTH FRAGMENT ===== */
+        if (datalen < AUTH_FEC_HDR_LEN) {
+            return;
+        }
+        const AuthFecFragment *frag = (const AuthFecFragment *)data;
+        
+        uint16_t handshake_id = uip_ntohs(frag->session_id);
+        uint8_t coded_id = frag->fragment_id;
+        uint8_t k = frag->k;
+        uint16_t frag_size = uip_ntohs(frag->frag_size);
+        uint16_t payload_total = uip_ntohs(frag->payload_len);
+        reassembly_ctx_t *ctx;
+        uint8_t created;
+        FragmentAck ack;
+        
+        int ret = reassembly_add_coded(sender_ip_copy.u8, handshake_id,
+                                       coded_id, k, frag_size, payload_total,
+                                       frag->payload, datalen - AUTH_FEC_HDR_LEN,
+                                       clock_seconds(), &ctx, &created);
+        
+        if (ret == REASSEMBLY_ERR_FULL) {
+            LOG_INFO("[Handshake] reassembly pool full (%d), dropping coded fragment\n",
+                     REASSEMBLY_POOL_SIZE);
+            return;
+        }
+        if (ret == REASSEMBLY_ERR_INVALID) {
+            LOG_ERR("Invalid coded AUTH fragment %u (k=%u) dropped\n",
+                    (unsigned)coded_id, (unsigned)k);
+            return;
+        }
+        if (created) {
+            handshake_started();
+        }
+        /* No per-fragment ACKs: answer only the fragment that completed the
+         * set, or late ones in case that answer was lost */
+        if (ret == REASSEMBLY_PENDING) {
+            process_poll(&handshake_process);
+            return;
+        }
+        if (ret == REASSEMBLY_DUPLICATE && ctx->state == REASSEMBLY_RECEIVING) {
+            return;
+        }
+        
+        memset(&ack, 0, sizeof(ack));
+        ack.type = MSG_TYPE_FRAG_ACK;
+        ack.handshake_id = uip_htons(handshake_id);
+        ack.fragment_id = coded_id;
+        if (ret == REASSEMBLY_ERR_FRAG_SIZE) {
+            LOG_INFO("Fragment size %u refused, advertising %u\n",
+                     (unsigned)frag_size, (unsigned)reassembly_max_frag_size());
+        } else if (ret == REASSEMBLY_STALE) {
+            /* Late parity of a finished handshake: repeat the answer */
+            ack.cum_ack = k;
+            ack.sack = uip_htonl(coded_id);
+        } else {
+            ack.cum_ack = k;
+            ack.sack = uip_htonl(ctx->max_coded_id);
+        }
+        ack.max_frag_size = uip_htons(reassembly_max_frag_size());
+        simple_udp_sendto(&udp_conn, &ack, sizeof(FragmentAck), &sender_ip_copy);
+        
+        if (ret == REASSEMBLY_COMPLETE) {
+            process_poll(&handshake_process);
+            LOG_INFO("Coded reassembly complete (k=%u, %u parity used, highest id %u), "
+                     "handshake %04x queued\n", (unsigned)k, (unsigned)ctx->parity_count,
+                     (unsigned)ctx->max_coded_id, handshake_id);
+        }
+        return;
+    }
+    
+    if (msg_type == MSG_TYPE_RESUME) {
+        /* ===== SESSION RESUMPTION (1-RTT) ===== */
+        if (datalen < sizeof(ResumeMessage)) {
+            return;
+        }
+        
+        const ResumeMessage *req = (const ResumeMessage *)data;
+        session_ticket_state_t st;
+        uint8_t binder[RESUME_BINDER_LEN];
+        
+        if (ticket_redeemed(ticket_serial_of(req->ticket))) {
+            LOG_ERR("Resumption ticket already redeemed\n");
+            return;
+        }
+        if (ticket_redeem(&st, req->ticket) != 0) {
+            LOG_ERR("Resumption ticket rejected\n");
+            return;
+        }
+        
+        resume_binder(binder, st.K_master, req->ticket, req->N_S);
+        if (constant_time_compare(binder, req->binder, RESUME_BINDER_LEN) != 0 ||
+            st.resume_count >= TICKET_MAX_RESUMES) {
+            LOG_ERR("Resumption refused (binder/limit), full handshake required\n");
+            secure_zero(&st, sizeof(st));
+            return;
+        }
+        
+        /* One use per ticket; the resumed session gets a fresh one */
+        ticket_mark_redeemed(ticket_serial_of(req->ticket));
+        
+        /* Retire the old SID if it is still in the table */
+        session_entry_t *old = find_session(st.sid);
+        if (old != NULL) {
+            session_zero(old);
+        }
+        
+        ResumeAckMessage rack;
+        uint8_t K_master[MASTER_KEY_LEN];
+        
+        rack.type = MSG_TYPE_RESUME_ACK;
+        crypto_secure_random(rack.N_G, RESUME_NONCE_LEN);
+        crypto_secure_random(rack.SID, SID_LEN);
+        derive_resumed_master_key(K_master, st.K_master, req->N_S, rack.N_G);
+        
+        uint16_t resume_count = st.resume_count + 1;
+        session_entry_t *se = create_session(rack.SID, K_master, &sender_ip_copy);
+        se->resume_count = resume_count;
+        ticket_issue(rack.ticket, se);
+        
+        resume_confirm(rack.confirm, K_master, rack.type, rack.N_G, rack.SID, rack.ticket);
+        
+        secure_zero(&st, sizeof(st));
+        secure_zero(K_master, MASTER_KEY_LEN);
+        
+        simple_udp_sendto(&udp_conn, &rack, sizeof(ResumeAckMessage), &sender_ip_copy);
+        LOG_INFO("Session resumed from ticket (resume #%u)\n",
+                 (unsigned)resume_count);
+        return;
+    }
+    
+    if (msg_type == MSG_TYPE_KEY_UPDATE) {
+        /* ===== IN-SESSION KEY UPDATE ===== */
+        if (datalen < sizeof(KeyUpdateMessage)) {
+            return;
+        }
+        
+        const KeyUpdateMessage *ku = (const KeyUpdateMessage *)data;
+        uint16_t epoch = ((uint16_t)ku->epoch[0] << 8) | ku->epoch[1];
+        session_entry_t *se = find_session(ku->SID);
+        uint8_t tag[KEY_UPDATE_TAG_LEN];
+        
+        if (se == NULL) {
+            LOG_ERR("KEY_UPDATE for unknown session\n");
+            return;
+        }
+        
+        if (epoch == (uint16_t)(se->epoch + 1)) {
+            uint8_t K_next[MASTER_KEY_LEN];
             
-            if (decode_ret != 0) {
-                LOG_ERR("LDPC decoding failed!\n");
+            session_ratchet_key(K_next, se->K_master, se->sid, epoch);
+            key_update_tag(tag, K_next, se->sid, epoch, KEY_UPDATE_REQ);
+            if (constant_time_compare(tag, ku->tag, KEY_UPDATE_TAG_LEN) != 0) {
+                LOG_ERR("KEY_UPDATE tag mismatch!\n");
+                secure_zero(K_next, MASTER_KEY_LEN);
                 return;
             }
             
-            LOG_INFO("LDPC decoding successful (weight=%u)\n",
-                     recovered_error.hamming_weight);
-            
-            /* Generate session parameters */
-            uint8_t N_G[32];
-            uint8_t SID[SID_LEN];
-            
-            LOG_INFO("Generating session parameters...\n");
-            crypto_secure_random(N_G, 32);
-            crypto_secure_random(SID, SID_LEN);
-            
-            /* Derive master session key */
-            LOG_INFO("Deriving master session key...\n");
-            uint8_t K_master[MASTER_KEY_LEN];
-            derive_master_key(K_master,
-                             recovered_error.bits, sizeof(recovered_error.bits),
-                             N_G, 32);
-            
-            /* Create session entry */
-            LOG_INFO("Creating session entry...\n");
-            session_entry_t *se = create_session(SID, K_master, sender_addr);
-            
-            if (se == NULL) {
-                LOG_ERR("Failed to create session!\n");
+            /* Commit; the old epoch stays decryptable until DATA shows
+             * the sender has switched. Counters restart under the new key. */
+            prev_epoch_keep(se);
+            memcpy(se->K_master, K_next, MASTER_KEY_LEN);
+            secure_zero(K_next, MASTER_KEY_LEN);
+            se->epoch = epoch;
+            replay_window_reset(se);
+            LOG_INFO("Session key ratcheted to epoch %u\n", (unsigned)epoch);
+        } else if (epoch == se->epoch) {
+            /* Retransmitted request (our ACK was lost): re-prove and re-ACK */
+            key_update_tag(tag, se->K_master, se->sid, epoch, KEY_UPDATE_REQ);
+            if (constant_time_compare(tag, ku->tag, KEY_UPDATE_TAG_LEN) != 0) {
                 return;
             }
-            
-            LOG_INFO("Session created\n");
-            
-            /* Zeroize sensitive data */
-            secure_zero(&recovered_error, sizeof(ErrorVector));
-            secure_zero(K_master, MASTER_KEY_LEN);
-            
-            /* Send AUTH_ACK */
-            AuthAckMessage ack_msg;
-            ack_msg.type = MSG_TYPE_AUTH_ACK;
-            memcpy(ack_msg.N_G, N_G, 32);
-            memcpy(ack_msg.SID, SID, SID_LEN);
-            
-            simple_udp_sendto(&udp_conn, &ack_msg, sizeof(AuthAckMessage), &sender_ip_copy);
-            LOG_INFO("ACK sent! Session established.\n");
+        } else {
+            LOG_ERR("KEY_UPDATE epoch %u out of sequence (at %u)\n",
+                    (unsigned)epoch, (unsigned)se->epoch);
+            return;
         }
+        
+        KeyUpdateAckMessage kack;
+        kack.type = MSG_TYPE_KEY_UPDATE_ACK;
+        memcpy(kack.SID, se->sid, SID_LEN);
+        kack.epoch[0] = (epoch >> 8) & 0xFF;
+        kack.epoch[1] = epoch & 0xFF;
+        key_update_tag(kack.tag, se->K_master, se->sid, epoch, KEY_UPDATE_RSP);
+        ticket_issue(kack.ticket, se);
+        
+        simple_udp_sendto(&udp_conn, &kack, sizeof(KeyUpdateAckMessage), &sender_ip_copy);
         return;
     }
     
@@ -294,6 +713,12 @@ udp_rx_callback(struct simple_udp_connection *c,
         
         if (se == NULL) {
             LOG_ERR("Session not found!\n");
+            
+            /* Tell the sender so it can resume from its ticket */
+            uint8_t nack[1 + SID_LEN];
+            nack[0] = MSG_TYPE_SESSION_UNKNOWN;
+            memcpy(nack + 1, sid, SID_LEN);
+            simple_udp_sendto(&udp_conn, nack, sizeof(nack), &sender_ip_copy);
             return;
         }
         
@@ -306,15 +731,42 @@ udp_rx_callback(struct simple_udp_connection *c,
         int ret = session_decrypt(se, counter, ciphertext, cipher_len,
                                  plaintext, &plain_len);
         
-        if (ret != 0) {
-            if (counter <= se->last_seq) {
-                LOG_ERR("Replay attack detected! counter=%u, last_seq=%u\n",
-                        (unsigned)counter, (unsigned)se->last_seq);
-            } else {
-                LOG_ERR("AEAD decryption failed!\n");
+        session_entry_t *prev = prev_epoch_find(sid);
+        if (prev != NULL && ret == SESSION_OK) {
+            /* The sender is on the new epoch: forget the old key */
+            prev_epoch_drop(sid);
+            LOG_INFO("Epoch %u confirmed by DATA, previous key erased\n",
+                     (unsigned)se->epoch);
+        } else if (prev != NULL && ret == SESSION_ERR_AEAD) {
+            ret = session_decrypt(prev, counter, ciphertext, cipher_len,
+                                  plaintext, &plain_len);
+            se = prev;
+            if (ret == SESSION_OK) {
+                LOG_INFO("DATA under previous epoch %u\n", (unsigned)prev->epoch);
             }
+        }
+        
+        if (ret == SESSION_ERR_REPLAY) {
+            LOG_ERR("Replay attack detected! counter=%u, last_seq=%u (replay_drops=%u)\n",
+                    (unsigned)counter, (unsigned)se->last_seq,
+                    (unsigned)se->replay_drops);
             return;
         }
+        if (ret == SESSION_ERR_STALE) {
+            LOG_ERR("Counter outside replay window! counter=%u, last_seq=%u, window=%u (window_drops=%u)\n",
+                    (unsigned)counter, (unsigned)se->last_seq,
+                    (unsigned)REPLAY_WINDOW_SIZE, (unsigned)se->window_drops);
+            return;
+        }
+        if (ret != SESSION_OK) {
+            LOG_ERR("AEAD decryption failed!\n");
+            return;
+        }
+        if (counter < se->last_seq) {
+            LOG_INFO("Late counter %u accepted inside window (last_seq=%u, reordered=%u)\n",
+                     (unsigned)counter, (unsigned)se->last_seq,
+                     (unsigned)se->reordered);
+        }
         
         plaintext[plain_len] = '\0';
         
@@ -322,55 +774,295 @@ udp_rx_callback(struct simple_udp_connection *c,
         LOG_INFO("========================================\n");
         LOG_INFO("*** DECRYPTED MESSAGE: %s ***\n", plaintext);
         LOG_INFO("========================================\n");
+        /* Peer is the Cooja node id (last address byte), for latency matching */
+        LOG_INFO("[Data] peer=%u counter=%u decrypted\n",
+                 sender_ip_copy.u8[15], (unsigned)counter);
     }
 }
 
+/* ========== PIPELINED VERIFICATION ========== */
+
+/* With nothing complete, handshake_process starts verifying the longest
+ * running transfer from the bytes already in order: a*z of the signer
+ * as its z arrives, the hash of w. Only t*c and the final check are left
+ * for after the last fragment. A restart or expiry recycles contexts, so
+ * the pipelined one is matched by pointer, handshake id and peer. */
+static struct {
+    reassembly_ctx_t *ctx;
+    uint16_t handshake_id;
+    uint8_t peer[16];
+} pipe;
+static AuthMessageView auth_view;
+static PolyView verify_keys[RING_SIZE];
+static ring_verify_ctx_t verify_ctx;
+
+static int pipe_valid(void) {
+    return pipe.ctx != NULL && pipe.ctx->state != REASSEMBLY_FREE &&
+           pipe.ctx->handshake_id == pipe.handshake_id &&
+           memcmp(pipe.ctx->peer_addr, pipe.peer, 16) == 0;
+}
+
+/* Views over the slot (it holds a full AUTH message) and the ring keys
+ * in flash, with the received public key as member 0 */
+static void verify_bind(reassembly_ctx_t *ctx) {
+    int i;
+    
+    auth_msg_view(&auth_view, ctx->buf, AUTH_MSG_WIRE_LEN);
+    verify_keys[0] = auth_view.public_key;
+    for (i = 1; i < RING_SIZE; i++) {
+        verify_keys[i] = poly_view(&ring_member_table[i]);
+    }
+}
+
+static void pipe_attach(reassembly_ctx_t *ctx) {
+    uint32_t span;
+    
+    pipe.ctx = NULL;
+    if (ctx == NULL) return;
+    
+    /* Only transfers sized for exactly one AUTH message */
+    span = (uint32_t)ctx->total_frags * ctx->frag_size;
+    if (ctx->coded ? ctx->length != AUTH_MSG_WIRE_LEN :
+        span < AUTH_MSG_WIRE_LEN || span - ctx->frag_size >= AUTH_MSG_WIRE_LEN) {
+        return;
+    }
+    
+    verify_bind(ctx);
+    ring_verify_pipe_start(&verify_ctx, &auth_view.signature, verify_keys,
+                           ctx->buf + reassembly_prefix(ctx));
+    pipe.ctx = ctx;
+    pipe.handshake_id = ctx->handshake_id;
+    memcpy(pipe.peer, ctx->peer_addr, 16);
+    LOG_INFO("[Handshake] pipelining verification of %04x\n", ctx->handshake_id);
+}
+
+/* ========== HANDSHAKE PROCESS ========== */
+
+/* Completes queued handshakes one at a time: ring verification, LDPC
+ * decoding, key derivation and AUTH_ACK. Yields between verification
+ * slices so the UDP callback can serve DATA from other peers; when idle,
+ * pre-verifies the transfer in progress. */
+PROCESS_THREAD(handshake_process, ev, data)
+{
+    static reassembly_ctx_t *ctx;
+    static uip_ipaddr_t peer;
+    static int verify_result;
+    static int slices;
+    static uint8_t pipelined;
+    
+    PROCESS_BEGIN();
+    
+    while(1) {
+        /* The pipelined handshake first once complete, else FIFO */
+        pipelined = 0;
+        if (pipe_valid() && reassembly_take(pipe.ctx) == 0) {
+            ctx = pipe.ctx;
+            pipelined = 1;
+        } else {
+            ctx = reassembly_next_ready();
+        }
+        
+        if (ctx == NULL) {
+            /* Idle: advance verification on the bytes already in order */
+            if (!pipe_valid()) {
+                pipe_attach(reassembly_oldest_receiving());
+            }
+            if (pipe.ctx != NULL) {
+                ring_verify_pipe_avail(&verify_ctx, pipe.ctx->buf + reassembly_prefix(pipe.ctx));
+                if (ring_verify_step(&verify_ctx) == RING_VERIFY_PENDING) {
+                    PROCESS_PAUSE();
+                    continue;
+                }
+            }
+            /* Stalled or nothing in flight: wait for the next fragment */
+            PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+            continue;
+        }
+        
+        /* verify_ctx now belongs to ctx; any other pipelined state is dropped */
+        pipe.ctx = NULL;
+        
+        /* Coded transfers: rebuild lost data fragments from parity */
+        if (ctx->coded && ctx->parity_count > 0) {
+            LOG_INFO("Recovering %u lost fragments from parity\n", (unsigned)ctx->parity_count);
+            if (reassembly_fec_decode(ctx) != 0) {
+                LOG_ERR("Erasure decoding failed\n");
+                handshake_finished(ctx);
+                continue;
+            }
+            PROCESS_PAUSE();
+        }
+        
+        /* Everything below reads the reassembled bytes in place: the
+         * context stays BUSY (buffer untouched) until handshake_finished() */
+        if (auth_msg_view(&auth_view, ctx->buf, ctx->length) != 0) {
+            LOG_ERR("AUTH payload has %u bytes, expected %u\n",
+                    (unsigned)ctx->length, (unsigned)AUTH_MSG_WIRE_LEN);
+            handshake_finished(ctx);
+            continue;
+        }
+        
+        LOG_INFO("Reassembly complete. Verifying signature...\n");
+        
+        memcpy(&peer, ctx->peer_addr, sizeof(peer));
+        
+        /* Use received public key for verification (Index 0); a pipelined
+         * run was bound to the same slot when it started */
+        if (!pipelined) {
+            verify_bind(ctx);
+        }
+        
+        /* Verify signature */
+        LOG_INFO("Verifying with key[0]:\n");
+        poly_view_print("Verify Key", &verify_keys[0], 8);
+        
+        /* DEBUG: Check Signature integrity */
+        LOG_INFO("DEBUG: Received Signature w (first 8 coeffs):\n");
+        poly_view_print("Recv Sig.w", &auth_view.signature.w, 8);
+        LOG_INFO("DEBUG: Received Commitment (first 4 bytes): %02x%02x%02x%02x\n",
+                 auth_view.signature.commitment[0], auth_view.signature.commitment[1],
+                 auth_view.signature.commitment[2], auth_view.signature.commitment[3]);
+        
+        slices = 0;
+        if (pipelined) {
+            ring_verify_pipe_avail(&verify_ctx, NULL);
+            verify_result = RING_VERIFY_PENDING;
+        } else {
+            verify_result = ring_verify_view_start(&verify_ctx, &auth_view.signature, verify_keys);
+        }
+        while (verify_result == RING_VERIFY_PENDING) {
+            PROCESS_PAUSE();
+            verify_result = ring_verify_step(&verify_ctx);
+            slices++;
+        }
+        secure_zero(&verify_ctx, sizeof(verify_ctx));
+        
+        if (verify_result != 1) {
+            LOG_ERR("Ring signature verification FAILED!\n");
+            handshake_finished(ctx);
+            continue;
+        }
+        
+        LOG_INFO("Ring signature verified: SUCCESS (%d slices%s)\n", slices,
+                 pipelined ? " after the last fragment" : "");
+        PROCESS_PAUSE();
+        
+        /* LDPC decode (syndrome read in place) */
+        LOG_INFO("Decoding LDPC syndrome...\n");
+        ErrorVector recovered_error;
+        int decode_ret = sldspa_decode(&recovered_error, auth_view.syndrome,
+                                      &gateway_ldpc_keypair);
+        
+        if (decode_ret != 0) {
+            LOG_ERR("LDPC decoding failed!\n");
+            handshake_finished(ctx);
+            continue;
+        }
+        
+        LOG_INFO("LDPC decoding successful (weight=%u)\n",
+                 recovered_error.hamming_weight);
+        
+        /* Generate session parameters */
+        uint8_t N_G[32];
+        uint8_t SID[SID_LEN];
+        
+        LOG_INFO("Generating session parameters...\n");
+        crypto_secure_random(N_G, 32);
+        crypto_secure_random(SID, SID_LEN);
+        
+        /* Derive master session key */
+        LOG_INFO("Deriving master session key...\n");
+        uint8_t K_master[MASTER_KEY_LEN];
+        derive_master_key(K_master,
+                         recovered_error.bits, sizeof(recovered_error.bits),
+                         N_G, 32);
+        
+        /* Create session entry */
+        LOG_INFO("Creating session entry...\n");
+        session_entry_t *se = create_session(SID, K_master, &peer);
+        
+        /* Zeroize sensitive data */
+        secure_zero(&recovered_error, sizeof(ErrorVector));
+        secure_zero(K_master, MASTER_KEY_LEN);
+        
+        if (se == NULL) {
+            LOG_ERR("Failed to create session!\n");
+            handshake_finished(ctx);
+            continue;
+        }
+        
+        LOG_INFO("Session created\n");
+        
+        /* Send AUTH_ACK */
+        AuthAckMessage ack_msg;
+        ack_msg.type = MSG_TYPE_AUTH_ACK;
+        memcpy(ack_msg.N_G, N_G, 32);
+        memcpy(ack_msg.SID, SID, SID_LEN);
+        ticket_issue(ack_msg.ticket, se);
+        
+        simple_udp_sendto(&udp_conn, &ack_msg, sizeof(AuthAckMessage), &peer);
+        LOG_INFO("ACK sent! Session established.\n");
+        handshake_finished(ctx);
+    }
+    
+    PROCESS_END();
+}
+
 /* ========== GATEWAY PROCESS ========== */
 
 PROCESS_THREAD(gateway_process, ev, data)
 {
     static struct etimer periodic_timer;
+    static clock_time_t boot_time;
+    static uint8_t keys_stored;
     int i;
     
     PROCESS_BEGIN();
     
+    boot_time = clock_time();
     LOG_INFO("=== Ring-LWE Gateway Node Starting ===\n");
     
     /* Initialize PRNG */
     crypto_prng_init(0xCAFEBABE);
     
-    /* ===== KEY GENERATION ===== */
-    LOG_INFO("[Initialization] Generating cryptographic keys...\n");
-    
-    LOG_INFO("1. Generating Ring-LWE keys...\n");
-    if (ring_lwe_keygen(&gateway_keypair) != 0) {
-        LOG_ERR("Failed to generate Ring-LWE key pair!\n");
-        PROCESS_EXIT();
-    }
-    LOG_INFO("   Ring-LWE key generation: SUCCESS\n");
-    
-    LOG_INFO("2. Generating QC-LDPC keys...\n");
-    if (ldpc_keygen(&gateway_ldpc_keypair) != 0) {
-        LOG_ERR("Failed to generate LDPC key pair!\n");
-        PROCESS_EXIT();
+    /* ===== KEYS: LOAD, OR GENERATE ONCE (PROVISIONING) ===== */
+    keys_stored = (key_store_load(&gateway_keypair, &gateway_ldpc_keypair) == 0);
+    if (keys_stored) {
+        LOG_INFO("[Initialization] Long-term keys loaded from the key store\n");
+    } else {
+        LOG_INFO("[Initialization] Provisioning: generating cryptographic keys...\n");
+        
+        LOG_INFO("1. Generating Ring-LWE keys...\n");
+        if (ring_lwe_keygen(&gateway_keypair) != 0) {
+            LOG_ERR("Failed to generate Ring-LWE key pair!\n");
+            PROCESS_EXIT();
+        }
+        LOG_INFO("   Ring-LWE key generation: SUCCESS\n");
+        
+        LOG_INFO("2. Generating QC-LDPC keys...\n");
+        if (ldpc_keygen(&gateway_ldpc_keypair) != 0) {
+            LOG_ERR("Failed to generate LDPC key pair!\n");
+            PROCESS_EXIT();
+        }
+        LOG_INFO("   LDPC matrix generation: SUCCESS\n");
+        
+        /* A failed write only costs the next boot another keygen */
+        if (key_store_save(&gateway_keypair, &gateway_ldpc_keypair) != 0) {
+            LOG_WARN("   Keys not stored; the next boot provisions again\n");
+        }
     }
-    LOG_INFO("   LDPC matrix generation: SUCCESS\n");
     
-    /* Initialize ring public keys */
-    LOG_INFO("3. Initializing ring member public keys...\n");
+    /* Ring public keys: member 0 (Sender) is received in AuthMessage,
+     * the fake members are read in place from ring_member_table */
+    LOG_INFO("3. Ring member public keys: %d from flash table\n", RING_SIZE - 1);
     
-    /* Ring member 0 (Sender) key is received in AuthMessage */
-    /* We initialize it to zero here to be safe */
-    memset(&ring_public_keys[0], 0, sizeof(Poly512));
-    
-    /* Generate fake ring members */
-    for (i = 1; i < RING_SIZE; i++) {
-        generate_ring_member_key(&ring_public_keys[i], i);
-        LOG_INFO("   - Ring member %d public key generated\n", i + 1);
-    }
-    LOG_INFO("   Ring setup complete\n");
+    LOG_INFO("4. Deriving resumption ticket keys...\n");
+    ticket_keys_init();
     
     LOG_INFO("\n=== Gateway Ready ===\n");
+    LOG_INFO("Time to ready: %lu ms (keys %s)\n",
+             (unsigned long)((clock_time() - boot_time) * 1000 / CLOCK_SECOND),
+             keys_stored ? "from store" : "generated");
     LOG_INFO("Configuration:\n");
     LOG_INFO("  - Polynomial degree (n): %d\n", POLY_DEGREE);
     LOG_INFO("  - Modulus (q): %ld\n", (long)MODULUS_Q);
@@ -378,6 +1070,10 @@ PROCESS_THREAD(gateway_process, ev, data)
     LOG_INFO("  - LDPC dimensions: %dx%d\n", LDPC_ROWS, LDPC_COLS);
     LOG_INFO("\nListening on UDP port %d...\n\n", UDP_PORT);
     
+    /* Handshakes are completed outside the UDP callback */
+    reassembly_init(GATEWAY_MAX_FRAG_SIZE);
+    process_start(&handshake_process, NULL);
+    
     /* Initialize UDP */
     simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, udp_rx_callback);
     
@@ -389,6 +1085,25 @@ PROCESS_THREAD(gateway_process, ev, data)
         etimer_set(&periodic_timer, 60 * CLOCK_SECOND);
         PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
         LOG_INFO("[Status] Gateway operational\n");
+        
+        ticket_keys_rotate(ticket_epoch_offset +
+                           clock_seconds() / TICKET_KEY_ROTATION);
+        handshake_sweep();
+        
+        /* Replay window statistics, for tuning REPLAY_WINDOW_SIZE against
+         * the reordering actually seen on the RPL paths */
+        for (i = 0; i < MAX_SESSIONS; i++) {
+            session_entry_t *se = &session_table[i];
+            if (!se->in_use) continue;
+            if (se->expiry_ts < clock_seconds()) {
+                session_zero(se);
+                continue;
+            }
+            LOG_INFO("[Replay] SID [%02x%02x%02x%02x...] last_seq=%u reordered=%u window_drops=%u replay_drops=%u\n",
+                     se->sid[0], se->sid[1], se->sid[2], se->sid[3],
+                     (unsigned)se->last_seq, (unsigned)se->reordered,
+                     (unsigned)se->window_drops, (unsigned)se->replay_drops);
+        }
     }
     
     PROCESS_END();
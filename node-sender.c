@@ -10,11 +10,16 @@
 #include "net/ipv6/simple-udp.h"
 #include "sys/log.h"
 #include "crypto_core.h"
+#include "session_store.h"
+#include "renewal_policy.h"
+#include "fec.h"
 
 #include <string.h>
 #include <stdio.h>
 #include "sys/rtimer.h"
 #include "sys/energest.h"
+#include "sys/node-id.h"
+#include "lib/random.h"
 
 #define LOG_MODULE "Sender"
 #define LOG_LEVEL LOG_LEVEL_INFO
@@ -28,24 +33,123 @@ static struct simple_udp_connection udp_conn;
 #define MSG_TYPE_DATA 0x03
 #define MSG_TYPE_AUTH_FRAG 0x04
 #define MSG_TYPE_FRAG_ACK 0x05
+#define MSG_TYPE_RESUME 0x06
+#define MSG_TYPE_RESUME_ACK 0x07
+#define MSG_TYPE_SESSION_UNKNOWN 0x08
+#define MSG_TYPE_KEY_UPDATE 0x09
+#define MSG_TYPE_KEY_UPDATE_ACK 0x0A
+#define MSG_TYPE_AUTH_FEC 0x0B
 
-/* Fragmentation state */
-static volatile int last_ack_received = -1;
+/* ========== WINDOWED FRAGMENT TRANSPORT ========== */
+
+#define AUTH_MAX_FRAGS ((AUTH_MSG_WIRE_LEN + AUTH_FRAG_MIN - 1) / AUTH_FRAG_MIN)
+
+/* Fragment payload is derived from the path MTU: one fragment per IPv6
+ * datagram, which 6LoWPAN splits into link frames below us. Lower
+ * AUTH_FRAG_MTU (e.g. 138, single-frame fragments) to avoid 6LoWPAN fragmentation.
+ * Never above AUTH_FRAG_MAX_SIZE, so the first handshake after boot is not
+ * refused by a gateway we have not heard from yet. */
+#ifndef AUTH_FRAG_MTU
+#define AUTH_FRAG_MTU UIP_LINK_MTU
+#endif
+#if AUTH_FRAG_MTU > UIP_BUFSIZE
+#define AUTH_FRAG_PATH_MAX (UIP_BUFSIZE - UIP_IPUDPH_LEN - AUTH_FRAG_HDR_LEN)
+#else
+#define AUTH_FRAG_PATH_MAX (AUTH_FRAG_MTU - UIP_IPUDPH_LEN - AUTH_FRAG_HDR_LEN)
+#endif
+#define AUTH_FRAG_MAX \
+    (AUTH_FRAG_PATH_MAX < AUTH_FRAG_MAX_SIZE ? AUTH_FRAG_PATH_MAX : AUTH_FRAG_MAX_SIZE)
+#ifndef FRAG_WINDOW_BYTES
+#define FRAG_WINDOW_BYTES 512              /* Unacknowledged payload in flight */
+#endif
+#define FRAG_MAX_TX 5                      /* Transmissions per fragment before giving up */
+
+/* Retransmission timeout (RFC 6298), in clock ticks */
+#define RTO_INITIAL (2 * CLOCK_SECOND)
+#define RTO_MIN CLOCK_SECOND
+#define RTO_MAX (16 * CLOCK_SECOND)
+
+/* Erasure-coded mode: on lossy links the payload goes out as k data +
+ * r parity fragments with no per-fragment ACKs; any k rebuild it at the
+ * gateway (fec.h). A 6LoWPAN-fragmented datagram dies with any of its
+ * frames, so coded fragments are sized to one link frame. */
+#ifndef FEC_LOSS_THRESHOLD
+#define FEC_LOSS_THRESHOLD 50              /* Frame loss (permille) above which AUTH goes coded */
+#endif
+#ifndef FEC_FRAG_MTU
+#define FEC_FRAG_MTU 138                   /* One 802.15.4 frame after header compression */
+#endif
+#define FEC_FRAG_MAX (FEC_FRAG_MTU - UIP_IPUDPH_LEN - AUTH_FEC_HDR_LEN)
+#define FEC_PACING (CLOCK_SECOND / 16)     /* Gap between coded fragments */
+#define FEC_PARITY_MARGIN 2                /* Parity beyond the expected losses */
+
+/* Fragment loss seen by past transfers, permille (EWMA, gain 1/4) */
+static uint16_t loss_permille;
+
+static struct {
+    uint16_t handshake_id;
+    uint16_t frag_size;                    /* Payload bytes per fragment */
+    uint16_t window;                       /* Fragments in flight */
+    uint16_t total;
+    uint16_t base;                         /* Lowest unacknowledged fragment */
+    uint16_t acked_count;
+    uint32_t acked[(AUTH_MAX_FRAGS + 31) / 32];
+    clock_time_t sent_at[AUTH_MAX_FRAGS];
+    uint8_t tx_count[AUTH_MAX_FRAGS];
+    int32_t srtt8;                         /* Smoothed RTT, ticks * 8 */
+    int32_t rttvar8;                       /* RTT variation, ticks * 8 */
+    clock_time_t rto;
+    uint8_t have_rtt;
+    uint8_t renegotiate;                   /* Gateway refused frag_size */
+    uint8_t active;
+    uint8_t coded;                         /* Erasure-coded transfer, total = k */
+    uint8_t parity;                        /* Parity rows planned up front */
+    uint16_t coded_sent;                   /* Coded fragments transmitted */
+    uint16_t coded_highest;                /* Highest id the gateway had when done */
+} ftx;
+
+/* Largest fragment the gateway advertised in its FRAG_ACKs (0 = unknown) */
+static uint16_t gateway_max_frag;
+static uint8_t frag_frame[AUTH_FRAG_HDR_LEN + AUTH_FRAG_MAX];
 
 /* ========== MESSAGE STRUCTURES ========== */
 
 typedef struct {
     uint8_t type;
-    uint8_t syndrome[LDPC_ROWS / 8];
-    Poly512 public_key; /* Added Public Key for robust verification */
-    RingSignature signature;
-} AuthMessage;
+    uint8_t N_G[32];
+    uint8_t SID[SID_LEN];
+    uint8_t ticket[TICKET_LEN];
+} AuthAckMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t ticket[TICKET_LEN];
+    uint8_t N_S[RESUME_NONCE_LEN];
+    uint8_t binder[RESUME_BINDER_LEN];
+} ResumeMessage;
 
 typedef struct {
     uint8_t type;
-    uint8_t N_G[32];
     uint8_t SID[SID_LEN];
-} AuthAckMessage;
+    uint8_t epoch[2];
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+} KeyUpdateMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t SID[SID_LEN];
+    uint8_t epoch[2];
+    uint8_t tag[KEY_UPDATE_TAG_LEN];
+    uint8_t ticket[TICKET_LEN];
+} KeyUpdateAckMessage;
+
+typedef struct {
+    uint8_t type;
+    uint8_t N_G[RESUME_NONCE_LEN];
+    uint8_t SID[SID_LEN];
+    uint8_t ticket[TICKET_LEN];
+    uint8_t confirm[RESUME_BINDER_LEN];
+} ResumeAckMessage;
 
 typedef struct {
     uint8_t type;
@@ -58,19 +162,240 @@ typedef struct {
 /* ========== CRYPTOGRAPHIC STATE ========== */
 
 static RingLWEKeyPair sender_keypair;
+static PolyView ring_public_keys[RING_SIZE];   // Views: no RAM copy of the ring
 static LDPCPublicKey shared_ldpc_pubkey;
 static session_ctx_t session_ctx;
 static ErrorVector auth_error_vector;
 static uint8_t syndrome[LDPC_ROWS / 8];
 
+/* AUTH message being transferred: fragments (and retransmissions) are
+ * encoded from it on demand, there is no serialised copy */
+static AuthMessage auth_msg;
+static auth_cursor_t auth_cursor;
+
+/* Session from a background handshake, waiting to take over DATA */
+static session_ctx_t pending_ctx;
+static uint8_t pending_ticket[TICKET_LEN];
+static volatile uint8_t handshake_running;
+
+/* auth_msg contents, built ahead of the handshake by payload_process */
+#define PAYLOAD_NONE 0
+#define PAYLOAD_BUILDING 1
+#define PAYLOAD_READY 2                    // Signed, not yet sent
+#define PAYLOAD_FAILED 3
+static volatile uint8_t payload_state;
+static uint8_t keys_ready;                 // sender_keypair / ring_public_keys set
+
+/* Boot -> first DATA sent */
+static clock_time_t boot_time;
+static uint8_t first_data_sent;
+
+/* Gateway address */
+static uip_ipaddr_t dest_ipaddr;
+
+/* Resumption ticket from the last AUTH_ACK / RESUME_ACK */
+static struct {
+    uint8_t ticket[TICKET_LEN];
+    uint8_t K_master[MASTER_KEY_LEN];      /* Key the ticket wraps */
+    uint8_t N_S[RESUME_NONCE_LEN];         /* Nonce of the pending RESUME */
+    uint8_t valid;
+    uint8_t pending;                       /* RESUME sent, ACK not yet in */
+} resume_state;
+
+/* SESSION_UNKNOWN is unauthenticated, so it only prompts a RESUME attempt;
+ * the session is kept until something authenticated replaces it */
+static uint8_t session_hint;
+static unsigned long session_hint_next;    /* clock_seconds() of next allowed hint */
+
+/* Outstanding KEY_UPDATE */
+static struct {
+    uint8_t K_next[MASTER_KEY_LEN];
+    uint8_t ticket[TICKET_LEN];            /* Ticket for the new epoch */
+    uint16_t epoch;
+    uint8_t pending;
+    uint8_t acked;
+} key_update;
+
 /* Message to encrypt */
 static const char *secret_message = "Hello IoT";
-#define RENEW_THRESHOLD 20   /* Renew session after 20 messages */
+#define KEY_UPDATE_TIMEOUT 3 /* Seconds to wait for KEY_UPDATE_ACK */
+#define KEY_UPDATE_RETRIES 3
 #define DATA_INTERVAL 5      /* Send 1 message every 5 seconds */
+#define RESUME_TIMEOUT 5     /* Seconds to wait for RESUME_ACK */
+#define SESSION_HINT_HOLDOFF 30  /* Seconds between SESSION_UNKNOWN-driven resumes */
+#define ROUTE_POLL (CLOCK_SECOND / 4)  /* Route check interval during bring-up */
+#define ROUTE_WAIT_MAX 15    /* Seconds before falling back to multicast */
 
 PROCESS(sender_process, "Ring-LWE Sender Process");
+PROCESS(auth_process, "Ring-LWE Handshake Process");
+PROCESS(payload_process, "Ring-LWE Payload Builder");
 AUTOSTART_PROCESSES(&sender_process);
 
+/* ========== FRAGMENT TRANSPORT FUNCTIONS ========== */
+
+#define FRAG_ACKED(i) (ftx.acked[(i) / 32] & (1UL << ((i) % 32)))
+
+/* Path-MTU size, capped by what the gateway advertised last time */
+static uint16_t frag_size_select(void) {
+    uint16_t size = AUTH_FRAG_MAX;
+    
+    if (gateway_max_frag >= AUTH_FRAG_MIN && gateway_max_frag < size) {
+        size = gateway_max_frag;
+    }
+    return size;
+}
+
+static void frag_transport_start(uint16_t handshake_id, uint16_t frag_size, size_t payload_len) {
+    memset(&ftx, 0, sizeof(ftx));
+    ftx.handshake_id = handshake_id;
+    ftx.frag_size = frag_size;
+    ftx.total = (payload_len + frag_size - 1) / frag_size;
+    /* Bound the bytes, not the datagrams, queued below us; the SACK
+     * bitmap covers 32 fragments past the cumulative ACK */
+    ftx.window = FRAG_WINDOW_BYTES / frag_size;
+    if (ftx.window < 1) ftx.window = 1;
+    if (ftx.window > 32) ftx.window = 32;
+    ftx.rto = RTO_INITIAL;
+    ftx.active = 1;
+}
+
+/* RFC 6298 section 2: alpha = 1/8, beta = 1/4, K = 4, G = 1 tick */
+static void frag_rtt_sample(clock_time_t rtt) {
+    int32_t r8 = (int32_t)rtt * 8;
+    int32_t var;
+    
+    if (!ftx.have_rtt) {
+        ftx.srtt8 = r8;
+        ftx.rttvar8 = r8 / 2;
+        ftx.have_rtt = 1;
+    } else {
+        int32_t err = r8 - ftx.srtt8;
+        ftx.rttvar8 += ((err < 0 ? -err : err) - ftx.rttvar8) / 4;
+        ftx.srtt8 += err / 8;
+    }
+    
+    var = 4 * ftx.rttvar8;
+    if (var < 8) var = 8;
+    ftx.rto = (ftx.srtt8 + var) / 8;
+    if (ftx.rto < RTO_MIN) ftx.rto = RTO_MIN;
+    if (ftx.rto > RTO_MAX) ftx.rto = RTO_MAX;
+}
+
+static void frag_mark_acked(uint16_t i) {
+    if (i >= ftx.total || FRAG_ACKED(i)) return;
+    ftx.acked[i / 32] |= 1UL << (i % 32);
+    ftx.acked_count++;
+}
+
+/* Cumulative ACK + SACK: everything below cum_ack, and bit k of sack
+ * for fragment cum_ack + 1 + k */
+static void frag_ack_apply(uint16_t cum_ack, uint32_t sack, uint16_t trigger) {
+    uint16_t i;
+    
+    /* Karn: only fragments sent once give an unambiguous RTT sample */
+    if (trigger < ftx.total && !FRAG_ACKED(trigger) && ftx.tx_count[trigger] == 1) {
+        frag_rtt_sample(clock_time() - ftx.sent_at[trigger]);
+    }
+    
+    for (i = 0; i < cum_ack && i < ftx.total; i++) {
+        frag_mark_acked(i);
+    }
+    for (i = 0; i < 32; i++) {
+        if (sack & (1UL << i)) {
+            frag_mark_acked(cum_ack + 1 + i);
+        }
+    }
+    while (ftx.base < ftx.total && FRAG_ACKED(ftx.base)) {
+        ftx.base++;
+    }
+}
+
+static void send_fragment(uint16_t idx) {
+    AuthFragment *frag = (AuthFragment *)frag_frame;
+    size_t len;
+    
+    frag->type = MSG_TYPE_AUTH_FRAG;
+    frag->session_id = uip_htons(ftx.handshake_id);
+    frag->fragment_id = idx;
+    frag->total_frags = ftx.total;
+    frag->frag_size = uip_htons(ftx.frag_size);
+    auth_cursor_seek(&auth_cursor, (size_t)idx * ftx.frag_size);
+    len = auth_cursor_read(&auth_cursor, frag->payload, ftx.frag_size);
+    
+    LOG_INFO("Sending Fragment %d/%d (%u bytes, try %u)...\n",
+             idx + 1, ftx.total, (unsigned)len, ftx.tx_count[idx] + 1);
+    /* Unpadded: the short last fragment goes out short */
+    simple_udp_sendto(&udp_conn, frag_frame, AUTH_FRAG_HDR_LEN + len, &dest_ipaddr);
+    
+    ftx.sent_at[idx] = clock_time();
+    ftx.tx_count[idx]++;
+}
+
+/* Coded fragment: data fragment coded_id < k verbatim, else parity row
+ * coded_id - k built from all k (the short last one zero-padded), each
+ * re-encoded into a one-fragment scratch */
+static void send_coded_fragment(uint8_t coded_id) {
+    static uint8_t data_frag[FEC_FRAG_MAX];
+    AuthFecFragment *frag = (AuthFecFragment *)frag_frame;
+    size_t len = ftx.frag_size;
+    uint16_t i;
+    
+    frag->type = MSG_TYPE_AUTH_FEC;
+    frag->session_id = uip_htons(ftx.handshake_id);
+    frag->fragment_id = coded_id;
+    frag->k = ftx.total;
+    frag->frag_size = uip_htons(ftx.frag_size);
+    frag->payload_len = uip_htons(AUTH_MSG_WIRE_LEN);
+    
+    if (coded_id < ftx.total) {
+        auth_cursor_seek(&auth_cursor, (size_t)coded_id * ftx.frag_size);
+        len = auth_cursor_read(&auth_cursor, frag->payload, ftx.frag_size);
+    } else {
+        memset(frag->payload, 0, len);
+        auth_cursor_seek(&auth_cursor, 0);
+        for (i = 0; i < ftx.total; i++) {
+            size_t n = auth_cursor_read(&auth_cursor, data_frag, ftx.frag_size);
+            fec_accumulate(frag->payload, data_frag, n,
+                           fec_coeff(ftx.total, coded_id - ftx.total, i));
+        }
+    }
+    
+    LOG_INFO("Sending coded fragment %u (%s, %u bytes)...\n", coded_id,
+             coded_id < ftx.total ? "data" : "parity", (unsigned)len);
+    simple_udp_sendto(&udp_conn, frag_frame, AUTH_FEC_HDR_LEN + len, &dest_ipaddr);
+    ftx.coded_sent++;
+}
+
+static uint16_t frag_transmissions(void) {
+    uint16_t idx, sent = 0;
+    
+    if (ftx.coded) return ftx.coded_sent;
+    for (idx = 0; idx < ftx.total; idx++) sent += ftx.tx_count[idx];
+    return sent;
+}
+
+/* One loss sample per transfer: fragments that had to be re-sent (ARQ)
+ * or that the gateway never saw before it was done (coded) */
+static void loss_update(uint16_t delivered, uint16_t sent) {
+    uint16_t sample = 0;
+    
+    if (sent > delivered) {
+        sample = (uint32_t)(sent - delivered) * 1000 / sent;
+    }
+    loss_permille = (3 * loss_permille + sample) / 4;
+}
+
+/* Parity for k fragments at the current loss estimate p:
+ * r = k p / (1 - p) expected erasures, plus a quarter and a fixed margin */
+static uint8_t fec_parity_for(uint16_t k) {
+    uint16_t p = loss_permille > 900 ? 900 : loss_permille;
+    uint32_t r = ((uint32_t)k * p + (1000 - p) - 1) / (1000 - p);
+    
+    r += r / 4 + FEC_PARITY_MARGIN;
+    if (r > FEC_MAX_PARITY) r = FEC_MAX_PARITY;
+    return (uint8_t)r;
+}
+
 /* ========== UDP RECEIVE CALLBACK ========== */
 
 static void
@@ -87,15 +412,102 @@ udp_rx_callback(struct simple_udp_connection *c,
     LOG_INFO("Received message type 0x%02x\n", msg_type);
     
     if (msg_type == MSG_TYPE_FRAG_ACK) {
-        FragmentAck *ack = (FragmentAck *)data;
-        uint16_t ack_frag_id = uip_ntohs(ack->fragment_id);
-        LOG_INFO("Received ACK for fragment %d\n", ack_frag_id);
-        last_ack_received = ack_frag_id;
+        const FragmentAck *ack = (const FragmentAck *)data;
+        
+        if (datalen < sizeof(FragmentAck) || !ftx.active ||
+            uip_ntohs(ack->handshake_id) != ftx.handshake_id) {
+            return;
+        }
+        gateway_max_frag = uip_ntohs(ack->max_frag_size);
+        if (gateway_max_frag < ftx.frag_size) {
+            ftx.renegotiate = 1;
+        } else if (ftx.coded) {
+            /* Only sent once any k coded fragments are in */
+            if (ack->cum_ack == ftx.total) {
+                ftx.coded_highest = (uint16_t)uip_ntohl(ack->sack);
+                frag_ack_apply(ftx.total, 0, ftx.total);
+                LOG_INFO("Coded transfer complete at fragment %u\n", ftx.coded_highest);
+            }
+        } else {
+            frag_ack_apply(ack->cum_ack, uip_ntohl(ack->sack), ack->fragment_id);
+            LOG_INFO("ACK: cum=%u sack=%08lx (%u/%u acked)\n",
+                     ack->cum_ack, (unsigned long)uip_ntohl(ack->sack),
+                     ftx.acked_count, ftx.total);
+        }
+        process_poll(&auth_process);
+        return;
+    }
+    
+    if (msg_type == MSG_TYPE_SESSION_UNKNOWN && session_ctx.active &&
+        datalen >= 1 + SID_LEN &&
+        memcmp(data + 1, session_ctx.sid, SID_LEN) == 0) {
+        /* Gateway rebooted or evicted us, or someone claims so: try to
+         * resume, rate-limited so forged hints cannot drive the radio */
+        if (!session_hint && clock_seconds() >= session_hint_next) {
+            session_hint = 1;
+        }
+        return;
+    }
+    
+    if (msg_type == MSG_TYPE_KEY_UPDATE_ACK && key_update.pending &&
+        datalen >= sizeof(KeyUpdateAckMessage)) {
+        const KeyUpdateAckMessage *kack = (const KeyUpdateAckMessage *)data;
+        uint16_t epoch = ((uint16_t)kack->epoch[0] << 8) | kack->epoch[1];
+        uint8_t tag[KEY_UPDATE_TAG_LEN];
+        
+        if (epoch != key_update.epoch ||
+            memcmp(kack->SID, session_ctx.sid, SID_LEN) != 0) {
+            return;
+        }
+        key_update_tag(tag, key_update.K_next, session_ctx.sid, epoch, KEY_UPDATE_RSP);
+        if (constant_time_compare(tag, kack->tag, KEY_UPDATE_TAG_LEN) != 0) {
+            LOG_ERR("KEY_UPDATE_ACK tag mismatch!\n");
+            return;
+        }
+        
+        memcpy(key_update.ticket, kack->ticket, TICKET_LEN);
+        key_update.acked = 1;
         process_poll(&sender_process);
         return;
     }
     
-    if (msg_type == MSG_TYPE_AUTH_ACK && !session_ctx.active) {
+    if (msg_type == MSG_TYPE_RESUME_ACK && resume_state.pending &&
+        resume_state.valid && datalen >= sizeof(ResumeAckMessage)) {
+        const ResumeAckMessage *rack = (const ResumeAckMessage *)data;
+        uint8_t K_master[MASTER_KEY_LEN];
+        uint8_t mac[RESUME_BINDER_LEN];
+        
+        derive_resumed_master_key(K_master, resume_state.K_master,
+                                  resume_state.N_S, rack->N_G);
+        resume_confirm(mac, K_master, rack->type, rack->N_G, rack->SID, rack->ticket);
+        if (constant_time_compare(mac, rack->confirm, RESUME_BINDER_LEN) != 0) {
+            LOG_ERR("RESUME_ACK confirmation failed!\n");
+            secure_zero(K_master, MASTER_KEY_LEN);
+            return;
+        }
+        
+        /* The gateway has retired the old SID; replace it if still held */
+        resume_state.pending = 0;
+        memcpy(session_ctx.sid, rack->SID, SID_LEN);
+        memcpy(session_ctx.K_master, K_master, MASTER_KEY_LEN);
+        session_ctx.counter = 1;
+        session_ctx.epoch = 0;
+        session_ctx.active = 1;
+        session_ctx.expiry_ts = 0;
+        
+        memcpy(resume_state.ticket, rack->ticket, TICKET_LEN);
+        memcpy(resume_state.K_master, K_master, MASTER_KEY_LEN);
+        secure_zero(K_master, MASTER_KEY_LEN);
+        session_store_save(&session_ctx, resume_state.ticket, resume_state.K_master);
+        
+        LOG_INFO("Session resumed! SID: [%02x%02x%02x%02x...]\n",
+                 session_ctx.sid[0], session_ctx.sid[1],
+                 session_ctx.sid[2], session_ctx.sid[3]);
+        process_poll(&sender_process);
+        return;
+    }
+    
+    if (msg_type == MSG_TYPE_AUTH_ACK && handshake_running && !pending_ctx.active) {
         AuthAckMessage *ack = (AuthAckMessage *)data;
         
         LOG_INFO("Authentication ACK received!\n");
@@ -103,102 +515,150 @@ udp_rx_callback(struct simple_udp_connection *c,
         /* Extract N_G and SID */
         uint8_t N_G[32];
         memcpy(N_G, ack->N_G, 32);
-        memcpy(session_ctx.sid, ack->SID, SID_LEN);
+        memcpy(pending_ctx.sid, ack->SID, SID_LEN);
         
         LOG_INFO("SID: [%02x%02x%02x%02x...]\n",
-                 session_ctx.sid[0], session_ctx.sid[1],
-                 session_ctx.sid[2], session_ctx.sid[3]);
+                 pending_ctx.sid[0], pending_ctx.sid[1],
+                 pending_ctx.sid[2], pending_ctx.sid[3]);
         
         /* Derive master session key */
         LOG_INFO("Deriving master session key...\n");
-        derive_master_key(session_ctx.K_master,
+        derive_master_key(pending_ctx.K_master,
                          auth_error_vector.bits, sizeof(auth_error_vector.bits),
                          N_G, 32);
         
-        /* Initialize session */
-        session_ctx.counter = 1;
-        session_ctx.active = 1;
-        session_ctx.expiry_ts = 0;
+        /* Initialize session; the data loop switches to it atomically */
+        pending_ctx.counter = 1;
+        pending_ctx.epoch = 0;
+        pending_ctx.active = 1;
+        pending_ctx.expiry_ts = 0;
+        
+        /* Keep the ticket for 1-RTT resumption */
+        memcpy(pending_ticket, ack->ticket, TICKET_LEN);
         
         /* Zeroize error vector */
         secure_zero(&auth_error_vector, sizeof(ErrorVector));
         
         LOG_INFO("Session initialized! Entering sequence data phase...\n");
-        process_poll(&sender_process);
+        process_poll(&auth_process);
     }
 }
 
-/* ========== SENDER PROCESS ========== */
+/* ========== SESSION RESUMPTION ========== */
 
-PROCESS_THREAD(sender_process, ev, data)
-{
-    static struct etimer periodic_timer;
-    static uip_ipaddr_t dest_ipaddr;
-    int i;
-    
-    PROCESS_BEGIN();
-    
-    LOG_INFO("=== Ring-LWE Sender Node Starting ===\n");
-    
-    /* Initialize PRNG */
-    uint32_t sender_seed = 0x12345678;
-    crypto_prng_init(sender_seed);
+static void send_resume(const uip_ipaddr_t *dest) {
+    ResumeMessage req;
     
-    /* ===== KEY GENERATION ===== */
-    LOG_INFO("[Phase 1] Generating Ring-LWE keys...\n");
+    req.type = MSG_TYPE_RESUME;
+    memcpy(req.ticket, resume_state.ticket, TICKET_LEN);
+    crypto_secure_random(resume_state.N_S, RESUME_NONCE_LEN);
+    memcpy(req.N_S, resume_state.N_S, RESUME_NONCE_LEN);
+    resume_binder(req.binder, resume_state.K_master, req.ticket, req.N_S);
+    resume_state.pending = 1;
     
-    if (ring_lwe_keygen(&sender_keypair) != 0) {
-        LOG_ERR("Failed to generate Ring-LWE key pair!\n");
-        PROCESS_EXIT();
+    simple_udp_sendto(&udp_conn, &req, sizeof(ResumeMessage), dest);
+}
+
+/* ========== MAKE-BEFORE-BREAK SWITCH ========== */
+
+/* Called only between two DATA messages, so no message ever straddles
+ * the old and new SID. The gateway keeps the old session for an overlap
+ * period, so in-flight datagrams still decrypt. */
+static void session_switch(void) {
+    if (session_ctx.active) {
+        LOG_INFO("[Renewal] DATA switched to SID [%02x%02x%02x%02x...] after %u msgs on old SID\n",
+                 pending_ctx.sid[0], pending_ctx.sid[1],
+                 pending_ctx.sid[2], pending_ctx.sid[3],
+                 (unsigned)(session_ctx.counter - 1));
     }
     
-    LOG_INFO("Ring-LWE key generation successful\n");
-    poly_print("Sender PubKey", &sender_keypair.public, 8);
-    
-    /* Generate ring public keys */
-    LOG_INFO("Generating ring public keys...\n");
-    static Poly512 ring_public_keys[RING_SIZE];
+    secure_zero(&session_ctx, sizeof(session_ctx));
+    memcpy(&session_ctx, &pending_ctx, sizeof(session_ctx_t));
     
-    ring_public_keys[0] = sender_keypair.public;
-    LOG_INFO("  - Ring member 1 (Sender): Real key\n");
+    memcpy(resume_state.ticket, pending_ticket, TICKET_LEN);
+    memcpy(resume_state.K_master, session_ctx.K_master, MASTER_KEY_LEN);
+    resume_state.valid = 1;
     
-    for (i = 1; i < RING_SIZE; i++) {
-        generate_ring_member_key(&ring_public_keys[i], i);
-        LOG_INFO("  - Ring member %d: Fake key\n", i + 1);
-    }
+    secure_zero(&pending_ctx, sizeof(pending_ctx));
+    secure_zero(pending_ticket, TICKET_LEN);
+    session_store_save(&session_ctx, resume_state.ticket, resume_state.K_master);
+    renewal_policy_session_start();
+}
+
+/* ========== IN-SESSION KEY UPDATE ========== */
+
+static void send_key_update(const uip_ipaddr_t *dest) {
+    KeyUpdateMessage ku;
     
-    /* Initialize UDP */
-    simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, udp_rx_callback);
+    ku.type = MSG_TYPE_KEY_UPDATE;
+    memcpy(ku.SID, session_ctx.sid, SID_LEN);
+    ku.epoch[0] = (key_update.epoch >> 8) & 0xFF;
+    ku.epoch[1] = key_update.epoch & 0xFF;
+    key_update_tag(ku.tag, key_update.K_next, session_ctx.sid,
+                   key_update.epoch, KEY_UPDATE_REQ);
     
-    /* Wait for network */
-    LOG_INFO("Waiting for network initialization...\n");
-    etimer_set(&periodic_timer, 5 * CLOCK_SECOND);
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+    simple_udp_sendto(&udp_conn, &ku, sizeof(KeyUpdateMessage), dest);
+}
+
+/* ========== PAYLOAD BUILDER ========== */
+
+static unsigned long ms_since_boot(void) {
+    return (unsigned long)((clock_time() - boot_time) * 1000UL / CLOCK_SECOND);
+}
+
+/* Leave payload_process and wake a handshake waiting for the payload */
+#define PAYLOAD_EXIT(state) do { \
+        payload_state = (state); \
+        process_poll(&auth_process); \
+        PROCESS_EXIT(); \
+    } while(0)
+
+/* Builds auth_msg one step at a time (Ring-LWE keys on first use, LDPC
+ * key, error vector and syndrome, ring signature), pausing between steps
+ * so the network stack and the data loop run in the gaps. Started at
+ * boot, while the network comes up, and by auth_process when a later
+ * handshake finds no payload ready. */
+PROCESS_THREAD(payload_process, ev, data)
+{
+    static uint8_t keyword[KEYWORD_SIZE];
+    int i;
     
-    /* Get gateway address */
-    if(NETSTACK_ROUTING.get_root_ipaddr(&dest_ipaddr)) {
-        LOG_INFO("Gateway address obtained\n");
-    } else {
-        uip_create_linklocal_allnodes_mcast(&dest_ipaddr);
-        LOG_INFO("Using multicast for gateway discovery\n");
-    }
+    PROCESS_BEGIN();
     
-    /* Allow routing to stabilize */
-    LOG_INFO("Allowing network routing to stabilize (10s)...\n");
-    etimer_set(&periodic_timer, 10 * CLOCK_SECOND);
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+    payload_state = PAYLOAD_BUILDING;
     
-    // RENEW LOOP: Continuously authenticate and send data
-    while(1) {
-        /* ===== AUTHENTICATION PHASE ===== */
-        LOG_INFO("\n[Phase 2] Starting Ring Signature Authentication...\n");
+    /* ===== KEY GENERATION ===== */
+    if (!keys_ready) {
+        LOG_INFO("[Phase 1] Generating Ring-LWE keys...\n");
+        
+        if (ring_lwe_keygen(&sender_keypair) != 0) {
+            LOG_ERR("Failed to generate Ring-LWE key pair!\n");
+            PAYLOAD_EXIT(PAYLOAD_FAILED);
+        }
+        
+        LOG_INFO("Ring-LWE key generation successful\n");
+        poly_print("Sender PubKey", &sender_keypair.public, 8);
+        
+        /* Ring public keys: own key plus the fake members' flash table */
+        LOG_INFO("Loading ring public keys...\n");
+        ring_public_keys[0] = poly_view(&sender_keypair.public);
+        LOG_INFO("  - Ring member 1 (Sender): Real key\n");
+        
+        for (i = 1; i < RING_SIZE; i++) {
+            ring_public_keys[i] = poly_view(&ring_member_table[i]);
+            LOG_INFO("  - Ring member %d: Fake key\n", i + 1);
+        }
+        keys_ready = 1;
+        PROCESS_PAUSE();
+    }
     
     /* Generate LDPC public key */
     LOG_INFO("Initializing LDPC public key...\n");
     if (ldpc_keygen((LDPCKeyPair *)&shared_ldpc_pubkey) != 0) {
         LOG_ERR("Failed to generate LDPC key!\n");
-        PROCESS_EXIT();
+        PAYLOAD_EXIT(PAYLOAD_FAILED);
     }
+    PROCESS_PAUSE();
     
     /* Generate error vector */
     LOG_INFO("Generating LDPC error vector...\n");
@@ -208,29 +668,23 @@ PROCESS_THREAD(sender_process, ev, data)
     /* Encode syndrome */
     LOG_INFO("Encoding syndrome...\n");
     ldpc_encode(syndrome, &auth_error_vector, &shared_ldpc_pubkey);
+    PROCESS_PAUSE();
     
     /* Prepare keyword */
-    uint8_t keyword[KEYWORD_SIZE];
     memset(keyword, 0, KEYWORD_SIZE);
     strcpy((char *)keyword, "AUTH_REQUEST");
     
     /* Generate ring signature */
     LOG_INFO("Generating ring signature (N=%d members)...\n", RING_SIZE);
     
-    static AuthMessage auth_msg;
     auth_msg.type = MSG_TYPE_AUTH;
     memcpy(auth_msg.syndrome, syndrome, LDPC_ROWS / 8);
     auth_msg.public_key = sender_keypair.public; /* Send PK */
     
-    int sign_result = ring_sign(&auth_msg.signature,
-                                keyword,
-                                &sender_keypair,
-                                ring_public_keys,
-                                0); // Sender is index 0
-    
-    if (sign_result != 0) {
+    if (ring_sign(&auth_msg.signature, keyword, &sender_keypair,
+                  ring_public_keys, 0) != 0) { // Sender is index 0
         LOG_ERR("Ring signature generation failed!\n");
-        PROCESS_EXIT();
+        PAYLOAD_EXIT(PAYLOAD_FAILED);
     }
     
     LOG_INFO("Ring signature generated successfully\n");
@@ -244,178 +698,472 @@ PROCESS_THREAD(sender_process, ev, data)
              auth_msg.signature.commitment[0], auth_msg.signature.commitment[1],
              auth_msg.signature.commitment[2], auth_msg.signature.commitment[3]);
     
-    /* ===== SEND AUTHENTICATION MESSAGE ===== */
-    LOG_INFO("Sending authentication message via fragmentation...\n");
-    
-    /* Serialize AuthMessage manually to avoid padding issues */
-    static uint8_t serialized_buffer[3000]; // Max size
-    size_t offset = 0;
-    
-    serialized_buffer[offset++] = auth_msg.type;
-    memcpy(serialized_buffer + offset, auth_msg.syndrome, LDPC_ROWS / 8);
-    offset += LDPC_ROWS / 8;
+    LOG_INFO("Authentication payload ready (%lu ms after boot)\n", ms_since_boot());
+    PAYLOAD_EXIT(PAYLOAD_READY);
     
-    serialize_poly512(serialized_buffer + offset, &auth_msg.public_key);
-    offset += POLY_DEGREE * 4;
-    
-    /* Signature: S[0..2], w, commitment, keyword */
-    int i;
-    for(i=0; i<RING_SIZE; i++) {
-        serialize_poly512(serialized_buffer + offset, &auth_msg.signature.S[i]);
-        offset += POLY_DEGREE * 4;
-    }
-    serialize_poly512(serialized_buffer + offset, &auth_msg.signature.w);
-    offset += POLY_DEGREE * 4;
+    PROCESS_END();
+}
+
+/* ========== HANDSHAKE PROCESS ========== */
+
+/* Leave auth_process and wake the data loop to decide what to do next */
+#define HANDSHAKE_EXIT() do { \
+        handshake_running = 0; \
+        process_poll(&sender_process); \
+        PROCESS_EXIT(); \
+    } while(0)
+
+/* Runs the full ring-signature + LDPC handshake. Started by the data loop,
+ * either in the foreground (no usable session) or in the background while
+ * the current session keeps carrying DATA. */
+PROCESS_THREAD(auth_process, ev, data)
+{
+    static struct etimer frag_timer;
     
-    memcpy(serialized_buffer + offset, auth_msg.signature.commitment, SHA256_DIGEST_SIZE);
-    offset += SHA256_DIGEST_SIZE;
+    PROCESS_BEGIN();
     
-    memcpy(serialized_buffer + offset, auth_msg.signature.keyword, KEYWORD_SIZE);
-    offset += KEYWORD_SIZE;
+    handshake_running = 1;
+    renewal_policy_handshake_begin();
+    /* Let the caller's data loop carry on before we start burning CPU */
+    PROCESS_PAUSE();
     
-    static uint8_t *serialized_auth;
-    serialized_auth = serialized_buffer;
-    static size_t serialized_len;
-    serialized_len = offset;
+    /* ===== AUTHENTICATION PHASE ===== */
+    LOG_INFO("\n[Phase 2] Starting Ring Signature Authentication...\n");
     
-    static uint16_t total_frags;
-    total_frags = (serialized_len + 63) / 64;
+    /* The first payload is built during network bring-up; later ones
+     * are built here, each handshake sending a fresh one */
+    if (payload_state != PAYLOAD_READY) {
+        if (payload_state != PAYLOAD_BUILDING) {
+            process_start(&payload_process, NULL);
+        }
+        PROCESS_YIELD_UNTIL(payload_state != PAYLOAD_BUILDING);
+    }
+    if (payload_state != PAYLOAD_READY) {
+        payload_state = PAYLOAD_NONE;
+        HANDSHAKE_EXIT();
+    }
+    payload_state = PAYLOAD_NONE;
     
-    LOG_INFO("Total payload: %u bytes (%u fragments)\n",
-             (unsigned)serialized_len, total_frags);
+    /* ===== SEND AUTHENTICATION MESSAGE ===== */
+    LOG_INFO("Sending authentication message via fragmentation...\n");
+
+    /* Fragments are encoded from auth_msg as they go out */
+    auth_cursor_init(&auth_cursor, &auth_msg);
     
-    static int frag_idx;
-    for (frag_idx = 0; frag_idx < total_frags; frag_idx++) {
-        int attempts = 0;
-        int acked = 0;
-        
-        last_ack_received = -1;
+    /* Fresh id per attempt, so the gateway never merges fragments of two
+     * handshakes (ours or another node's) into one reassembly context */
+    static uint16_t handshake_id;
+    static uint8_t negotiations;
+
+    for (negotiations = 0; ; negotiations++) {
+        handshake_id = random_rand();
+        if (handshake_id == 0) handshake_id = 1;
         
-        while(attempts < 5 && !acked) {
-            AuthFragment frag;
-            frag.type = MSG_TYPE_AUTH_FRAG;
-            frag.session_id = uip_htons(0xAB12);
-            frag.fragment_id = uip_htons(frag_idx);
-            frag.total_frags = uip_htons(total_frags);
+        if (loss_permille >= FEC_LOSS_THRESHOLD) {
+            /* Coded: k data fragments then r parity, paced, no per-fragment
+             * ACKs. If the gateway has not reported k after an RTO, keep
+             * adding parity rows until FEC_MAX_PARITY. */
+            static uint16_t coded_next;
+            static uint16_t coded_limit;
+            uint16_t fec_size = frag_size_select() - (AUTH_FEC_HDR_LEN - AUTH_FRAG_HDR_LEN);
+            
+            if (fec_size > FEC_FRAG_MAX) fec_size = FEC_FRAG_MAX;
+            frag_transport_start(handshake_id, fec_size, AUTH_MSG_WIRE_LEN);
+            ftx.coded = 1;
+            ftx.parity = fec_parity_for(ftx.total);
+            coded_next = 0;
+            coded_limit = ftx.total + ftx.parity;
+            
+            LOG_INFO("Total payload: %u bytes (coded: %u data + %u parity fragments of %u bytes, loss %u/1000)\n",
+                     (unsigned)AUTH_MSG_WIRE_LEN, ftx.total, ftx.parity, ftx.frag_size,
+                     loss_permille);
             
-            size_t offset = frag_idx * 64;
-            size_t len = 64;
-            if (offset + len > serialized_len) {
-                len = serialized_len - offset;
+            while (ftx.acked_count < ftx.total && !ftx.renegotiate) {
+                if (coded_next < coded_limit) {
+                    send_coded_fragment(coded_next++);
+                    etimer_set(&frag_timer, coded_next < coded_limit ? FEC_PACING : ftx.rto);
+                } else if (etimer_expired(&frag_timer)) {
+                    uint16_t extra = ftx.parity / 2 < 2 ? 2 : ftx.parity / 2;
+                    
+                    if (coded_limit >= ftx.total + FEC_MAX_PARITY) {
+                        LOG_ERR("Coded transfer failed after %u fragments\n", ftx.coded_sent);
+                        loss_update(0, ftx.coded_sent);
+                        ftx.active = 0;
+                        HANDSHAKE_EXIT();
+                    }
+                    if (coded_limit + extra > ftx.total + FEC_MAX_PARITY) {
+                        extra = ftx.total + FEC_MAX_PARITY - coded_limit;
+                    }
+                    LOG_INFO("No completion after %u fragments, adding %u parity\n",
+                             ftx.coded_sent, extra);
+                    coded_limit += extra;
+                    ftx.rto = ftx.rto * 2 > RTO_MAX ? RTO_MAX : ftx.rto * 2;
+                    continue;
+                }
+                PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL || etimer_expired(&frag_timer));
             }
-            frag.payload_len = uip_htons(len);
-            memcpy(frag.payload, serialized_auth + offset, len);
+        } else {
+            /* Sliding window: keep ftx.window fragments in flight from the lowest
+             * unacknowledged one, retransmit on RTO expiry only what the gateway's
+             * cumulative ACK + SACK has not covered */
+            frag_transport_start(handshake_id, frag_size_select(), AUTH_MSG_WIRE_LEN);
             
-            LOG_INFO("Sending Fragment %d/%d (%u bytes)...\n",
-                     frag_idx + 1, total_frags, (unsigned)len);
-            simple_udp_sendto(&udp_conn, &frag, sizeof(AuthFragment), &dest_ipaddr);
+            LOG_INFO("Total payload: %u bytes (%u fragments of %u bytes, window %u)\n",
+                     (unsigned)AUTH_MSG_WIRE_LEN, ftx.total, ftx.frag_size, ftx.window);
             
-            etimer_set(&periodic_timer, CLOCK_SECOND * 2);
+            while (ftx.acked_count < ftx.total && !ftx.renegotiate) {
+                clock_time_t now = clock_time();
+                clock_time_t wait = ftx.rto;
+                uint8_t timed_out = 0;
+                uint16_t idx;
             
-            while(1) {
-                PROCESS_YIELD();
+                for (idx = ftx.base; idx < ftx.total && idx < ftx.base + ftx.window; idx++) {
+                    if (FRAG_ACKED(idx)) continue;
                 
-                if (ev == PROCESS_EVENT_POLL && last_ack_received == frag_idx) {
-                    acked = 1;
-                    etimer_stop(&periodic_timer);
-                    LOG_INFO("ACK received for fragment %d\n", frag_idx);
-                    break;
+                    if (ftx.tx_count[idx] > 0 && now - ftx.sent_at[idx] < ftx.rto) {
+                        if (ftx.sent_at[idx] + ftx.rto - now < wait) {
+                            wait = ftx.sent_at[idx] + ftx.rto - now;
+                        }
+                        continue;
+                    }
+                    if (ftx.tx_count[idx] >= FRAG_MAX_TX) {
+                        LOG_ERR("Failed to send fragment %d after %d attempts\n",
+                                idx, ftx.tx_count[idx]);
+                        loss_update(ftx.acked_count, frag_transmissions());
+                        ftx.active = 0;
+                        HANDSHAKE_EXIT();
+                    }
+                    if (ftx.tx_count[idx] > 0) {
+                        LOG_INFO("Timeout for fragment %d, retrying...\n", idx);
+                        timed_out = 1;
+                    }
+                    send_fragment(idx);
                 }
-                
-                if (etimer_expired(&periodic_timer)) {
-                    LOG_INFO("Timeout for fragment %d, retrying...\n", frag_idx);
-                    break;
+            
+                /* RFC 6298 (5.5): back off once per expiry */
+                if (timed_out) {
+                    ftx.rto = ftx.rto * 2 > RTO_MAX ? RTO_MAX : ftx.rto * 2;
                 }
+            
+                etimer_set(&frag_timer, wait > 0 ? wait : 1);
+                PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL || etimer_expired(&frag_timer));
             }
-            attempts++;
         }
+        ftx.active = 0;
         
-        if (!acked) {
-            LOG_ERR("Failed to send fragment %d after %d attempts\n", frag_idx, attempts);
-            PROCESS_EXIT();
+        if (!ftx.renegotiate) {
+            break;
         }
+        /* Gateway advertised a smaller limit: restart once at that size */
+        if (negotiations > 0 || gateway_max_frag < AUTH_FRAG_MIN) {
+            LOG_ERR("Gateway fragment limit %u unusable\n", (unsigned)gateway_max_frag);
+            HANDSHAKE_EXIT();
+        }
+        LOG_INFO("Gateway accepts at most %u-byte fragments, restarting transfer\n",
+                 (unsigned)gateway_max_frag);
+    }
+    
+    if (ftx.coded) {
+        /* Gateway finished at coded_highest: everything it missed up to
+         * there was lost */
+        loss_update(ftx.total, ftx.coded_highest + 1);
+        LOG_INFO("Coded transfer: k=%u, %u sent, done at %u (loss now %u/1000)\n",
+                 ftx.total, ftx.coded_sent, ftx.coded_highest, loss_permille);
+    } else {
+        loss_update(ftx.total, frag_transmissions());
+        LOG_INFO("All %u fragments acknowledged (%u transmissions, SRTT %lu ms, RTO %lu ms, loss now %u/1000)\n",
+                 ftx.total, frag_transmissions(),
+                 (unsigned long)(ftx.srtt8 * 1000UL / 8 / CLOCK_SECOND),
+                 (unsigned long)(ftx.rto * 1000UL / CLOCK_SECOND), loss_permille);
     }
     
     LOG_INFO("Authentication payload sent successfully!\n");
     
     /* Wait for authentication response */
-    if (!session_ctx.active) {
-        etimer_set(&periodic_timer, 60 * CLOCK_SECOND);
+    etimer_set(&frag_timer, 60 * CLOCK_SECOND);
+    PROCESS_YIELD_UNTIL((ev == PROCESS_EVENT_POLL && pending_ctx.active) ||
+                        etimer_expired(&frag_timer));
+    
+    if (!pending_ctx.active) {
+        LOG_ERR("Authentication timeout! Retrying...\n");
+    } else {
+        LOG_INFO("\n=== AUTHENTICATION COMPLETE ===\n");
+        renewal_policy_handshake_end();
+    }
     
-        PROCESS_YIELD_UNTIL((ev == PROCESS_EVENT_POLL && session_ctx.active) ||
-                            etimer_expired(&periodic_timer));
+    HANDSHAKE_EXIT();
     
-        if (etimer_expired(&periodic_timer)) {
-            LOG_ERR("Authentication timeout! Retrying...\n");
-            continue; // Loop back and try authenticating again
+    PROCESS_END();
+}
+
+/* ========== SENDER PROCESS ========== */
+
+PROCESS_THREAD(sender_process, ev, data)
+{
+    static struct etimer periodic_timer;
+    static int ku_attempt;
+    static renewal_action_t action;
+    static uint16_t route_polls;
+    
+    PROCESS_BEGIN();
+    
+    boot_time = clock_time();
+    LOG_INFO("=== Ring-LWE Sender Node Starting ===\n");
+    
+    /* Initialize PRNG */
+    uint32_t sender_seed = 0x12345678;
+    crypto_prng_init(sender_seed);
+    
+    /* Renewal limits are jittered per node, so seed from the node id */
+    random_init(node_id);
+    renewal_policy_init();
+    
+    /* Initialize UDP */
+    simple_udp_register(&udp_conn, UDP_PORT, NULL, UDP_PORT, udp_rx_callback);
+    
+    /* Restore session state persisted before the last reset */
+    if (session_store_load(&session_ctx, resume_state.ticket,
+                           resume_state.K_master, &resume_state.valid) == 0) {
+        if (session_ctx.active) {
+            LOG_INFO("Session restored from flash (counter=%u), skipping handshake\n",
+                     (unsigned)session_ctx.counter);
+        } else {
+            LOG_INFO("Resumption ticket restored from flash\n");
         }
     }
     
-    LOG_INFO("\n=== AUTHENTICATION COMPLETE ===\n");
+    /* Without a restored session the first handshake needs keys and a
+     * signed payload: build them while the network comes up */
+    if (!session_ctx.active) {
+        process_start(&payload_process, NULL);
+    }
+    
+    /* Wait for network: poll for a route instead of sleeping a fixed
+     * time, so the first fragment goes out as soon as one exists */
+    LOG_INFO("Waiting for a route to the gateway...\n");
+    for (route_polls = 0;
+         !NETSTACK_ROUTING.node_is_reachable() &&
+         route_polls < ROUTE_WAIT_MAX * CLOCK_SECOND / ROUTE_POLL;
+         route_polls++) {
+        etimer_set(&periodic_timer, ROUTE_POLL);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+    }
     
-    /* ===== DATA TRANSMISSION PHASE ===== */
-    LOG_INFO("[Phase 3] Starting Amortized Periodic Data Transmission...\n");
+    /* Get gateway address */
+    if(NETSTACK_ROUTING.node_is_reachable() &&
+       NETSTACK_ROUTING.get_root_ipaddr(&dest_ipaddr)) {
+        LOG_INFO("Gateway address obtained (route after %lu ms)\n", ms_since_boot());
+    } else {
+        uip_create_linklocal_allnodes_mcast(&dest_ipaddr);
+        LOG_INFO("No route after %u s, using multicast for gateway discovery\n",
+                 ROUTE_WAIT_MAX);
+    }
     
-    while(session_ctx.active && session_ctx.counter <= RENEW_THRESHOLD) {
-        char msg_buf[64];
-        snprintf(msg_buf, sizeof(msg_buf), "%s #%u", secret_message, (unsigned)session_ctx.counter);
+    // RENEW LOOP: Continuously authenticate and send data
+    while(1) {
+        /* ===== SESSION RESUMPTION ===== */
+        if (!session_ctx.active && resume_state.valid) {
+            LOG_INFO("\n[Phase 2] Resuming session from ticket...\n");
+            send_resume(&dest_ipaddr);
+            
+            etimer_set(&periodic_timer, RESUME_TIMEOUT * CLOCK_SECOND);
+            PROCESS_YIELD_UNTIL((ev == PROCESS_EVENT_POLL && !resume_state.pending) ||
+                                etimer_expired(&periodic_timer));
+            resume_state.pending = 0;
+            
+            if (session_ctx.active) {
+                renewal_policy_session_start();
+            } else {
+                LOG_INFO("Resumption failed, falling back to full handshake\n");
+                secure_zero(&resume_state, sizeof(resume_state));
+                session_store_clear();
+            }
+        }
         
-        /* Session encrypt */
-        uint8_t ciphertext[MESSAGE_MAX_SIZE + AEAD_TAG_LEN];
-        size_t cipher_len;
+        if (!session_ctx.active) {
+            /* No session to keep DATA going: wait for the handshake in the
+             * foreground (first boot, or the old session ran out) */
+            if (!handshake_running && !pending_ctx.active) {
+                process_start(&auth_process, NULL);
+            }
+            PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL &&
+                                (pending_ctx.active || !handshake_running));
+            
+            if (!pending_ctx.active) {
+                /* Back off before the next attempt */
+                etimer_set(&periodic_timer, DATA_INTERVAL * CLOCK_SECOND);
+                PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+                continue;
+            }
+            session_switch();
+        }
         
-        int ret = session_encrypt(&session_ctx,
-                                 (uint8_t *)msg_buf, strlen(msg_buf) + 1,
-                                 ciphertext, &cipher_len);
+        /* ===== DATA TRANSMISSION PHASE ===== */
+        LOG_INFO("[Phase 3] Starting Amortized Periodic Data Transmission...\n");
+    
+        while(session_ctx.active) {
+            /* Make-before-break: take over the new session between messages */
+            if (pending_ctx.active) {
+                session_switch();
+            }
+            
+            /* Gateway says it lost our SID: resume, or else re-authenticate
+             * in the background while DATA continues on the current SID */
+            if (session_hint) {
+                session_hint = 0;
+                session_hint_next = clock_seconds() + SESSION_HINT_HOLDOFF;
+                if (resume_state.valid) {
+                    LOG_INFO("Gateway reports our SID unknown, resuming from ticket\n");
+                    send_resume(&dest_ipaddr);
+                    etimer_set(&periodic_timer, RESUME_TIMEOUT * CLOCK_SECOND);
+                    PROCESS_YIELD_UNTIL((ev == PROCESS_EVENT_POLL && !resume_state.pending) ||
+                                        etimer_expired(&periodic_timer));
+                    if (!resume_state.pending) {
+                        renewal_policy_session_start();
+                        continue;
+                    }
+                    resume_state.pending = 0;
+                }
+                if (!handshake_running && !pending_ctx.active) {
+                    LOG_INFO("No resumption, re-authenticating in background\n");
+                    process_start(&auth_process, NULL);
+                }
+            }
+            
+            action = renewal_policy_decide(session_ctx.epoch);
+            
+            if (action == RENEWAL_KEY_UPDATE) {
+                /* ===== IN-SESSION KEY UPDATE ===== */
+                /* Key freshness without re-running the PQ handshake */
+                key_update.epoch = session_ctx.epoch + 1;
+                LOG_INFO("\n[Key Update] Ratcheting K_master to epoch %u...\n",
+                         (unsigned)key_update.epoch);
+                session_ratchet_key(key_update.K_next, session_ctx.K_master,
+                                    session_ctx.sid, key_update.epoch);
+                key_update.acked = 0;
+                key_update.pending = 1;
+                
+                for (ku_attempt = 0; ku_attempt < KEY_UPDATE_RETRIES && !key_update.acked; ku_attempt++) {
+                    send_key_update(&dest_ipaddr);
+                    etimer_set(&periodic_timer, KEY_UPDATE_TIMEOUT * CLOCK_SECOND);
+                    PROCESS_YIELD_UNTIL((ev == PROCESS_EVENT_POLL && key_update.acked) ||
+                                        etimer_expired(&periodic_timer));
+                }
+                key_update.pending = 0;
+                
+                if (key_update.acked) {
+                    /* Overwrite the old epoch key everywhere (forward secrecy) */
+                    memcpy(session_ctx.K_master, key_update.K_next, MASTER_KEY_LEN);
+                    session_ctx.epoch = key_update.epoch;
+                    session_ctx.counter = 1;
+                    memcpy(resume_state.ticket, key_update.ticket, TICKET_LEN);
+                    memcpy(resume_state.K_master, session_ctx.K_master, MASTER_KEY_LEN);
+                    resume_state.valid = 1;
+                    secure_zero(key_update.K_next, MASTER_KEY_LEN);
+                    session_store_save(&session_ctx, resume_state.ticket, resume_state.K_master);
+                    renewal_policy_epoch_start();
+                    
+                    LOG_INFO("Key update complete (epoch %u), continuing session\n",
+                             (unsigned)session_ctx.epoch);
+                    continue;
+                }
+                
+                secure_zero(key_update.K_next, MASTER_KEY_LEN);
+                LOG_INFO("Key update not acknowledged, re-authenticating in background\n");
+                renewal_policy_force_reauth();
+                action = renewal_policy_decide(session_ctx.epoch);
+            }
+            
+            if (action == RENEWAL_EXPIRED) {
+                /* Background handshake did not finish in time: hard expiry */
+                LOG_INFO("\n**************************************************\n");
+                LOG_INFO("* AMORTIZATION LIMIT REACHED (%u msgs, epoch %u) *\n",
+                         (unsigned)(session_ctx.counter - 1), (unsigned)session_ctx.epoch);
+                LOG_INFO("* SESSION EXPIRED BEFORE RENEWAL COMPLETED      *\n");
+                LOG_INFO("**************************************************\n");
+                /* Zeroize old master key and deactivate session */
+                secure_zero(&session_ctx, sizeof(session_ctx));
+                /* Renewal means fresh PQ authentication, not resumption */
+                secure_zero(&resume_state, sizeof(resume_state));
+                session_store_clear();
+                break;
+            }
+            
+            /* Last epoch: start the next full handshake in the background
+             * so it completes before this session has to stop */
+            if (action == RENEWAL_REAUTH && !handshake_running && !pending_ctx.active) {
+                LOG_INFO("\n**************************************************\n");
+                LOG_INFO("* AMORTIZATION LIMIT APPROACHING (%u msgs)       *\n",
+                         (unsigned)(session_ctx.counter - 1));
+                LOG_INFO("* BACKGROUND RE-AUTHENTICATION STARTED           *\n");
+                LOG_INFO("**************************************************\n");
+                process_start(&auth_process, NULL);
+            }
+            
+            /* Reserve the counter in flash before it is ever used */
+            if (session_store_reserve(&session_ctx) != 0) {
+                LOG_ERR("Counter checkpoint failed, holding message %u\n",
+                        (unsigned)session_ctx.counter);
+                etimer_set(&periodic_timer, DATA_INTERVAL * CLOCK_SECOND);
+                PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+                continue;
+            }
+            
+            char msg_buf[64];
+            snprintf(msg_buf, sizeof(msg_buf), "%s #%u", secret_message, (unsigned)session_ctx.counter);
         
-        if (ret != 0) {
-            LOG_ERR("Encryption failed for message %u!\n", (unsigned)session_ctx.counter);
-            break;
-        }
+            /* Session encrypt */
+            uint8_t ciphertext[MESSAGE_MAX_SIZE + AEAD_TAG_LEN];
+            size_t cipher_len;
+        
+            int ret = session_encrypt(&session_ctx,
+                                     (uint8_t *)msg_buf, strlen(msg_buf) + 1,
+                                     ciphertext, &cipher_len);
         
-        LOG_INFO("Message %u encrypted (%u bytes)\n", (unsigned)session_ctx.counter, (unsigned)cipher_len);
+            if (ret != 0) {
+                LOG_ERR("Encryption failed for message %u!\n", (unsigned)session_ctx.counter);
+                break;
+            }
         
-        /* Pack wire format */
-        uint8_t wire_buf[256];
-        size_t wire_offset = 0;
+            LOG_INFO("Message %u encrypted (%u bytes)\n", (unsigned)session_ctx.counter, (unsigned)cipher_len);
         
-        wire_buf[wire_offset++] = MSG_TYPE_DATA;
-        memcpy(wire_buf + wire_offset, session_ctx.sid, SID_LEN);
-        wire_offset += SID_LEN;
+            /* Pack wire format */
+            uint8_t wire_buf[256];
+            size_t wire_offset = 0;
         
-        wire_buf[wire_offset++] = (session_ctx.counter >> 24) & 0xFF;
-        wire_buf[wire_offset++] = (session_ctx.counter >> 16) & 0xFF;
-        wire_buf[wire_offset++] = (session_ctx.counter >> 8) & 0xFF;
-        wire_buf[wire_offset++] = session_ctx.counter & 0xFF;
+            wire_buf[wire_offset++] = MSG_TYPE_DATA;
+            memcpy(wire_buf + wire_offset, session_ctx.sid, SID_LEN);
+            wire_offset += SID_LEN;
         
-        wire_buf[wire_offset++] = (cipher_len >> 8) & 0xFF;
-        wire_buf[wire_offset++] = cipher_len & 0xFF;
+            wire_buf[wire_offset++] = (session_ctx.counter >> 24) & 0xFF;
+            wire_buf[wire_offset++] = (session_ctx.counter >> 16) & 0xFF;
+            wire_buf[wire_offset++] = (session_ctx.counter >> 8) & 0xFF;
+            wire_buf[wire_offset++] = session_ctx.counter & 0xFF;
         
-        memcpy(wire_buf + wire_offset, ciphertext, cipher_len);
-        wire_offset += cipher_len;
+            wire_buf[wire_offset++] = (cipher_len >> 8) & 0xFF;
+            wire_buf[wire_offset++] = cipher_len & 0xFF;
         
-        /* Send to gateway */
-        simple_udp_sendto(&udp_conn, wire_buf, wire_offset, &dest_ipaddr);
-        LOG_INFO("  -> UDP Packet Sent with counter=%u\n", (unsigned)session_ctx.counter);
+            memcpy(wire_buf + wire_offset, ciphertext, cipher_len);
+            wire_offset += cipher_len;
         
-        session_ctx.counter++;
+            /* Send to gateway */
+            simple_udp_sendto(&udp_conn, wire_buf, wire_offset, &dest_ipaddr);
+            LOG_INFO("  -> UDP Packet Sent with counter=%u\n", (unsigned)session_ctx.counter);
+            if (!first_data_sent) {
+                first_data_sent = 1;
+                /* Send time only; cooja_logger.js reports boot -> gateway acceptance */
+                LOG_INFO("First DATA sent %lu ms after boot\n", ms_since_boot());
+            }
         
-        /* Wait for periodic interval (e.g., 5 seconds) */
-        etimer_set(&periodic_timer, DATA_INTERVAL * CLOCK_SECOND);
-        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
-    }
+            session_ctx.counter++;
+            renewal_policy_record(strlen(msg_buf) + 1);
+        
+            /* Wait for periodic interval (e.g., 5 seconds) */
+            etimer_set(&periodic_timer, DATA_INTERVAL * CLOCK_SECOND);
+            PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
+        }
     
-    if (session_ctx.counter > RENEW_THRESHOLD) {
-        LOG_INFO("\n**************************************************\n");
-        LOG_INFO("* AMORTIZATION THRESHOLD REACHED (%d msgs)      *\n", RENEW_THRESHOLD);
-        LOG_INFO("* SECURE SESSION RENEWAL TRIGGERED               *\n");
-        LOG_INFO("**************************************************\n");
-        /* Zeroize old master key and deactivate session to force new handshake */
-        secure_zero(&session_ctx, sizeof(session_ctx));
-        session_ctx.active = 0;
-    }
-  } /* End of while(1) renew loop */
+    } /* End of while(1) renew loop */
   
   PROCESS_END();
 }
-
@@ -33,6 +33,12 @@
 /* Enable UDP support */
 #define UIP_CONF_UDP 1
 
+/* Energest drives the renewal policy's handshake cost model */
+#define ENERGEST_CONF_ON 1
+
+/* Renewal limits (RENEWAL_MAX_MSGS, RENEWAL_MAX_AGE, ...) default in
+ * renewal_policy.h; define them here to override */
+
 /* Disable RPL DAG MC (Metric Container) to save memory */
 #define RPL_CONF_WITH_MC 0
 
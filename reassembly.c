@@ -0,0 +1,470 @@
+/**
+ * reassembly.c
+ * Per-Peer AUTH Fragment Reassembly (gateway)
+ *
+ * Plain C with no Contiki dependencies: the caller passes the time.
+ * Buffers are a static pool; a context owns one slot from its first
+ * fragment until reassembly_release().
+ */
+
+#include "reassembly.h"
+#include <string.h>
+
+static THREAD_LOCAL uint8_t buffer_pool[REASSEMBLY_POOL_SIZE][REASSEMBLY_BUF_SIZE];
+static THREAD_LOCAL uint8_t buffer_used[REASSEMBLY_POOL_SIZE];
+static THREAD_LOCAL reassembly_ctx_t contexts[REASSEMBLY_POOL_SIZE];
+static THREAD_LOCAL uint32_t ready_counter;
+static THREAD_LOCAL uint16_t max_frag_size;
+
+#define FRAG_RECEIVED(ctx, i) ((ctx)->bitmap[(i) / 32] & (1UL << ((i) % 32)))
+
+/* Recently completed handshakes, oldest overwritten first */
+typedef struct {
+    uint8_t peer_addr[16];
+    uint16_t handshake_id;
+    uint8_t valid;
+    uint32_t completed;
+} recent_t;
+
+static THREAD_LOCAL recent_t recent[REASSEMBLY_RECENT_SIZE];
+static THREAD_LOCAL uint8_t recent_next;
+
+/* ========== BUFFER POOL ========== */
+
+static uint8_t *pool_alloc(void) {
+    int i;
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (!buffer_used[i]) {
+            buffer_used[i] = 1;
+            return buffer_pool[i];
+        }
+    }
+    return NULL;
+}
+
+static void pool_free(uint8_t *buf) {
+    int i;
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (buf == buffer_pool[i]) {
+            /* Payloads carry the sender's signature material */
+            memset(buffer_pool[i], 0, REASSEMBLY_BUF_SIZE);
+            buffer_used[i] = 0;
+            return;
+        }
+    }
+}
+
+/* ========== COMPLETED HANDSHAKES ========== */
+
+static void recent_add(const reassembly_ctx_t *ctx, uint32_t now) {
+    recent_t *r = &recent[recent_next];
+    
+    memcpy(r->peer_addr, ctx->peer_addr, 16);
+    r->handshake_id = ctx->handshake_id;
+    r->completed = now;
+    r->valid = 1;
+    recent_next = (recent_next + 1) % REASSEMBLY_RECENT_SIZE;
+}
+
+static int recent_find(const uint8_t *peer_addr, uint16_t handshake_id, uint32_t now) {
+    int i;
+    for (i = 0; i < REASSEMBLY_RECENT_SIZE; i++) {
+        if (recent[i].valid && recent[i].handshake_id == handshake_id &&
+            now - recent[i].completed <= REASSEMBLY_TIMEOUT &&
+            memcmp(recent[i].peer_addr, peer_addr, 16) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* ========== CONTEXTS ========== */
+
+void reassembly_init(uint16_t max_frag) {
+    memset(contexts, 0, sizeof(contexts));
+    memset(buffer_used, 0, sizeof(buffer_used));
+    memset(recent, 0, sizeof(recent));
+    recent_next = 0;
+    ready_counter = 0;
+    max_frag_size = max_frag < REASSEMBLY_MAX_FRAG_SIZE ? max_frag : REASSEMBLY_MAX_FRAG_SIZE;
+}
+
+uint16_t reassembly_max_frag_size(void) {
+    return max_frag_size;
+}
+
+void reassembly_release(reassembly_ctx_t *ctx) {
+    if (ctx == NULL || ctx->state == REASSEMBLY_FREE) return;
+    pool_free(ctx->buf);
+    memset(ctx, 0, sizeof(reassembly_ctx_t));
+}
+
+static reassembly_ctx_t *find_context(const uint8_t *peer_addr, uint16_t handshake_id) {
+    int i;
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (contexts[i].state != REASSEMBLY_FREE &&
+            contexts[i].handshake_id == handshake_id &&
+            memcmp(contexts[i].peer_addr, peer_addr, 16) == 0) {
+            return &contexts[i];
+        }
+    }
+    return NULL;
+}
+
+static reassembly_ctx_t *open_context(const uint8_t *peer_addr, uint16_t handshake_id,
+                                      uint16_t total_frags, uint16_t frag_size,
+                                      uint32_t now) {
+    reassembly_ctx_t *ctx = NULL;
+    int i;
+    
+    /* The peer restarted its handshake: its unfinished one is dead */
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (contexts[i].state == REASSEMBLY_RECEIVING &&
+            memcmp(contexts[i].peer_addr, peer_addr, 16) == 0) {
+            reassembly_release(&contexts[i]);
+        }
+    }
+    
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (contexts[i].state == REASSEMBLY_FREE) {
+            ctx = &contexts[i];
+            break;
+        }
+    }
+    if (ctx == NULL) return NULL;
+    
+    ctx->buf = pool_alloc();
+    if (ctx->buf == NULL) return NULL;
+    
+    memcpy(ctx->peer_addr, peer_addr, 16);
+    ctx->handshake_id = handshake_id;
+    ctx->total_frags = total_frags;
+    ctx->frag_size = frag_size;
+    ctx->received_frags = 0;
+    ctx->length = 0;
+    memset(ctx->bitmap, 0, sizeof(ctx->bitmap));
+    ctx->started = now;
+    ctx->last_activity = now;
+    ctx->state = REASSEMBLY_RECEIVING;
+    return ctx;
+}
+
+int reassembly_add(const uint8_t *peer_addr, uint16_t handshake_id,
+                   uint16_t fragment_id, uint16_t total_frags, uint16_t frag_size,
+                   const uint8_t *payload, uint16_t payload_len,
+                   uint32_t now, reassembly_ctx_t **ctx_out, uint8_t *created) {
+    reassembly_ctx_t *ctx;
+    uint32_t offset = (uint32_t)fragment_id * frag_size;
+    uint32_t bit;
+    
+    *ctx_out = NULL;
+    *created = 0;
+    
+    if (frag_size < REASSEMBLY_MIN_FRAG_SIZE || frag_size > max_frag_size) {
+        return REASSEMBLY_ERR_FRAG_SIZE;
+    }
+    
+    /* Every fragment but the last is full; nothing may overflow the slot */
+    if (total_frags == 0 || total_frags > REASSEMBLY_MAX_FRAGS ||
+        fragment_id >= total_frags || payload_len > frag_size ||
+        (fragment_id != total_frags - 1 && payload_len != frag_size) ||
+        (uint32_t)(total_frags - 1) * frag_size >= REASSEMBLY_BUF_SIZE ||
+        offset + payload_len > REASSEMBLY_BUF_SIZE) {
+        return REASSEMBLY_ERR_INVALID;
+    }
+    
+    ctx = find_context(peer_addr, handshake_id);
+    if (ctx == NULL) {
+        if (recent_find(peer_addr, handshake_id, now)) return REASSEMBLY_STALE;
+        ctx = open_context(peer_addr, handshake_id, total_frags, frag_size, now);
+        if (ctx == NULL) return REASSEMBLY_ERR_FULL;
+        *created = 1;
+    } else if (ctx->coded || ctx->total_frags != total_frags || ctx->frag_size != frag_size) {
+        return REASSEMBLY_ERR_INVALID;
+    }
+    *ctx_out = ctx;
+    
+    bit = 1UL << (fragment_id % 32);
+    if (ctx->state != REASSEMBLY_RECEIVING || FRAG_RECEIVED(ctx, fragment_id)) {
+        return REASSEMBLY_DUPLICATE;
+    }
+    
+    memcpy(ctx->buf + offset, payload, payload_len);
+    ctx->bitmap[fragment_id / 32] |= bit;
+    ctx->received_frags++;
+    ctx->last_activity = now;
+    if (fragment_id == total_frags - 1) {
+        ctx->length = (uint16_t)(offset + payload_len);
+    }
+    
+    if (ctx->received_frags < ctx->total_frags) {
+        return REASSEMBLY_PENDING;
+    }
+    
+    ctx->state = REASSEMBLY_READY;
+    ctx->ready_seq = ready_counter++;
+    recent_add(ctx, now);
+    return REASSEMBLY_COMPLETE;
+}
+
+/* ========== ERASURE-CODED CONTEXTS ========== */
+
+static int parity_in_slot(const reassembly_ctx_t *ctx, uint8_t slot) {
+    int i;
+    for (i = 0; i < ctx->parity_count; i++) {
+        if (ctx->parity_slot[i] == slot) return i;
+    }
+    return -1;
+}
+
+/* Highest data slot holding neither its fragment nor parked parity. One
+ * exists whenever received_frags + parity_count < total_frags. */
+static int parity_free_slot(const reassembly_ctx_t *ctx) {
+    int slot;
+    for (slot = ctx->total_frags - 1; slot >= 0; slot--) {
+        if (!FRAG_RECEIVED(ctx, slot) && parity_in_slot(ctx, slot) < 0) return slot;
+    }
+    return -1;
+}
+
+int reassembly_add_coded(const uint8_t *peer_addr, uint16_t handshake_id,
+                         uint8_t coded_id, uint8_t k, uint16_t frag_size,
+                         uint16_t payload_total,
+                         const uint8_t *payload, uint16_t payload_len,
+                         uint32_t now, reassembly_ctx_t **ctx_out, uint8_t *created) {
+    reassembly_ctx_t *ctx;
+    uint32_t slot_bytes = (uint32_t)k * frag_size;
+    uint16_t last_len;
+    int i, slot;
+    
+    *ctx_out = NULL;
+    *created = 0;
+    
+    if (frag_size < REASSEMBLY_MIN_FRAG_SIZE || frag_size > max_frag_size) {
+        return REASSEMBLY_ERR_FRAG_SIZE;
+    }
+    
+    /* Parity fills whole slots, so the last data slot is frag_size too */
+    if (k == 0 || slot_bytes > REASSEMBLY_BUF_SIZE ||
+        payload_total <= slot_bytes - frag_size || payload_total > slot_bytes) {
+        return REASSEMBLY_ERR_INVALID;
+    }
+    last_len = payload_total - (uint16_t)(slot_bytes - frag_size);
+    if (coded_id < k) {
+        if (payload_len != (coded_id == k - 1 ? last_len : frag_size)) {
+            return REASSEMBLY_ERR_INVALID;
+        }
+    } else if (payload_len != frag_size) {
+        return REASSEMBLY_ERR_INVALID;
+    }
+    
+    ctx = find_context(peer_addr, handshake_id);
+    if (ctx == NULL) {
+        if (recent_find(peer_addr, handshake_id, now)) return REASSEMBLY_STALE;
+        ctx = open_context(peer_addr, handshake_id, k, frag_size, now);
+        if (ctx == NULL) return REASSEMBLY_ERR_FULL;
+        ctx->coded = 1;
+        ctx->length = payload_total;
+        *created = 1;
+    } else if (!ctx->coded || ctx->total_frags != k || ctx->frag_size != frag_size ||
+               ctx->length != payload_total) {
+        return REASSEMBLY_ERR_INVALID;
+    }
+    *ctx_out = ctx;
+    
+    if (coded_id > ctx->max_coded_id) {
+        ctx->max_coded_id = coded_id;
+    }
+    if (ctx->state != REASSEMBLY_RECEIVING) {
+        return REASSEMBLY_DUPLICATE;
+    }
+    
+    if (coded_id < k) {
+        if (FRAG_RECEIVED(ctx, coded_id)) return REASSEMBLY_DUPLICATE;
+        /* The real fragment takes its slot back; the parity parked there
+         * still counts towards k and moves to another missing slot */
+        i = parity_in_slot(ctx, coded_id);
+        if (i >= 0) {
+            slot = parity_free_slot(ctx);
+            if (slot < 0) return REASSEMBLY_ERR_INVALID;
+            memcpy(ctx->buf + (uint32_t)slot * frag_size,
+                   ctx->buf + (uint32_t)coded_id * frag_size, frag_size);
+            ctx->parity_slot[i] = (uint8_t)slot;
+        }
+        memcpy(ctx->buf + (uint32_t)coded_id * frag_size, payload, payload_len);
+        memset(ctx->buf + (uint32_t)coded_id * frag_size + payload_len, 0,
+               frag_size - payload_len);
+        ctx->bitmap[coded_id / 32] |= 1UL << (coded_id % 32);
+        ctx->received_frags++;
+    } else {
+        uint8_t row = coded_id - k;
+        
+        for (i = 0; i < ctx->parity_count; i++) {
+            if (ctx->parity_row[i] == row) return REASSEMBLY_DUPLICATE;
+        }
+        if (ctx->parity_count >= FEC_MAX_PARITY) return REASSEMBLY_DUPLICATE;
+        /* Park it in a missing data slot; one is free while incomplete */
+        slot = parity_free_slot(ctx);
+        if (slot < 0) return REASSEMBLY_ERR_INVALID;
+        memcpy(ctx->buf + (uint32_t)slot * frag_size, payload, frag_size);
+        ctx->parity_row[ctx->parity_count] = row;
+        ctx->parity_slot[ctx->parity_count] = (uint8_t)slot;
+        ctx->parity_count++;
+    }
+    ctx->last_activity = now;
+    
+    if (ctx->received_frags + ctx->parity_count < k) {
+        return REASSEMBLY_PENDING;
+    }
+    
+    ctx->state = REASSEMBLY_READY;
+    ctx->ready_seq = ready_counter++;
+    recent_add(ctx, now);
+    return REASSEMBLY_COMPLETE;
+}
+
+int reassembly_fec_decode(reassembly_ctx_t *ctx) {
+    static THREAD_LOCAL uint8_t m[FEC_MAX_PARITY * FEC_MAX_PARITY];
+    uint8_t col[FEC_MAX_PARITY];
+    uint8_t e, h, t;
+    uint16_t i, b, fs;
+    
+    if (!ctx->coded || ctx->parity_count == 0) return 0;
+    e = ctx->parity_count;
+    fs = ctx->frag_size;
+    
+    /* Syndromes: strip the received data out of each parity fragment,
+     * leaving only the contribution of the e missing ones */
+    for (h = 0; h < e; h++) {
+        uint8_t *s = ctx->buf + (uint32_t)ctx->parity_slot[h] * fs;
+        for (i = 0; i < ctx->total_frags; i++) {
+            if (FRAG_RECEIVED(ctx, i)) {
+                fec_accumulate(s, ctx->buf + (uint32_t)i * fs, fs,
+                               fec_coeff(ctx->total_frags, ctx->parity_row[h], i));
+            }
+        }
+    }
+    
+    /* S_h = sum_t C[row_h][slot_t] * D_slot_t; invert the e x e Cauchy block */
+    for (h = 0; h < e; h++) {
+        for (t = 0; t < e; t++) {
+            m[h * e + t] = fec_coeff(ctx->total_frags, ctx->parity_row[h], ctx->parity_slot[t]);
+        }
+    }
+    if (fec_invert(m, e) != 0) return -1;
+    
+    /* Column by column: the outputs overwrite the syndromes they came from */
+    for (b = 0; b < fs; b++) {
+        for (h = 0; h < e; h++) {
+            col[h] = ctx->buf[(uint32_t)ctx->parity_slot[h] * fs + b];
+        }
+        for (t = 0; t < e; t++) {
+            uint8_t v = 0;
+            for (h = 0; h < e; h++) {
+                v ^= gf256_mul(m[t * e + h], col[h]);
+            }
+            ctx->buf[(uint32_t)ctx->parity_slot[t] * fs + b] = v;
+        }
+    }
+    
+    for (t = 0; t < e; t++) {
+        i = ctx->parity_slot[t];
+        ctx->bitmap[i / 32] |= 1UL << (i % 32);
+    }
+    ctx->received_frags = ctx->total_frags;
+    ctx->parity_count = 0;
+    return 0;
+}
+
+void reassembly_ack_state(const reassembly_ctx_t *ctx, uint16_t *cum_ack, uint32_t *sack) {
+    uint16_t cum = 0;
+    uint32_t bits = 0;
+    int k;
+    
+    while (cum < ctx->total_frags && FRAG_RECEIVED(ctx, cum)) {
+        cum++;
+    }
+    for (k = 0; k < 32 && cum + 1 + k < ctx->total_frags; k++) {
+        if (FRAG_RECEIVED(ctx, cum + 1 + k)) {
+            bits |= 1UL << k;
+        }
+    }
+    
+    *cum_ack = cum;
+    *sack = bits;
+}
+
+reassembly_ctx_t *reassembly_next_ready(void) {
+    reassembly_ctx_t *oldest = NULL;
+    int i;
+    
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (contexts[i].state == REASSEMBLY_READY &&
+            (oldest == NULL || (int32_t)(contexts[i].ready_seq - oldest->ready_seq) < 0)) {
+            oldest = &contexts[i];
+        }
+    }
+    if (oldest != NULL) {
+        oldest->state = REASSEMBLY_BUSY;
+    }
+    return oldest;
+}
+
+int reassembly_take(reassembly_ctx_t *ctx) {
+    if (ctx->state != REASSEMBLY_READY) return -1;
+    ctx->state = REASSEMBLY_BUSY;
+    return 0;
+}
+
+reassembly_ctx_t *reassembly_oldest_receiving(void) {
+    reassembly_ctx_t *oldest = NULL;
+    int i;
+    
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (contexts[i].state == REASSEMBLY_RECEIVING &&
+            (oldest == NULL || (int32_t)(contexts[i].started - oldest->started) < 0)) {
+            oldest = &contexts[i];
+        }
+    }
+    return oldest;
+}
+
+uint32_t reassembly_prefix(const reassembly_ctx_t *ctx) {
+    uint16_t n = 0;
+    
+    /* Complete (and, if coded, decoded) */
+    if (ctx->state != REASSEMBLY_RECEIVING && ctx->parity_count == 0) {
+        return ctx->length;
+    }
+    while (n < ctx->total_frags && FRAG_RECEIVED(ctx, n)) {
+        n++;
+    }
+    /* Only the last fragment may be short, and the length is known once
+     * it is in */
+    if (n == ctx->total_frags) {
+        return ctx->length;
+    }
+    return (uint32_t)n * ctx->frag_size;
+}
+
+int reassembly_expire(uint32_t now) {
+    int i, dropped = 0;
+    
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (contexts[i].state == REASSEMBLY_RECEIVING &&
+            now - contexts[i].last_activity > REASSEMBLY_TIMEOUT) {
+            reassembly_release(&contexts[i]);
+            dropped++;
+        }
+    }
+    return dropped;
+}
+
+int reassembly_in_use(void) {
+    int i, n = 0;
+    
+    for (i = 0; i < REASSEMBLY_POOL_SIZE; i++) {
+        if (contexts[i].state != REASSEMBLY_FREE) n++;
+    }
+    return n;
+}
@@ -0,0 +1,174 @@
+/**
+ * reassembly.h
+ * Per-Peer AUTH Fragment Reassembly (gateway)
+ *
+ * Each handshake in flight gets its own context, keyed by (peer address,
+ * handshake id), with a bitmap of received fragments. Payload buffers
+ * come from a fixed pool of REASSEMBLY_POOL_SIZE slots, so concurrent
+ * handshakes scale up to the pool size and never share a buffer.
+ * A context is complete only when every fragment has arrived, or, for
+ * erasure-coded transfers (fec.h), when any k of the k + r coded
+ * fragments have: parity fragments are parked in the slots of missing
+ * data fragments and reassembly_fec_decode() rebuilds the data in place.
+ */
+
+#ifndef REASSEMBLY_H_
+#define REASSEMBLY_H_
+
+#include <stdint.h>
+#include "fec.h"
+
+#ifndef REASSEMBLY_POOL_SIZE
+#define REASSEMBLY_POOL_SIZE 4             // Handshakes reassembled/queued at once
+#endif
+#ifndef REASSEMBLY_BUF_SIZE
+#define REASSEMBLY_BUF_SIZE 3000           // Max reassembled AUTH payload
+#endif
+#ifndef REASSEMBLY_MAX_FRAG_SIZE
+#define REASSEMBLY_MAX_FRAG_SIZE 1024      // Largest fragment payload accepted
+#endif
+#define REASSEMBLY_MIN_FRAG_SIZE 32        // Smallest fragment payload accepted
+#define REASSEMBLY_MAX_FRAGS 255           // Fragment ids are 8-bit on the wire
+#define REASSEMBLY_BITMAP_WORDS ((REASSEMBLY_MAX_FRAGS + 31) / 32)
+#ifndef REASSEMBLY_TIMEOUT
+#define REASSEMBLY_TIMEOUT 30              // Seconds without a fragment before a context is dropped
+#endif
+#ifndef REASSEMBLY_RECENT_SIZE
+#define REASSEMBLY_RECENT_SIZE 8           // Completed (peer, handshake id) pairs remembered
+#endif
+
+/* reassembly_add() return codes */
+#define REASSEMBLY_PENDING 0               // Stored, more fragments missing
+#define REASSEMBLY_COMPLETE 1              // All fragments present
+#define REASSEMBLY_DUPLICATE 2             // Already had this fragment (re-ACK it)
+#define REASSEMBLY_STALE 3                 // Handshake completed earlier: re-ACK as complete, no context
+#define REASSEMBLY_ERR_FULL -1             // No free context in the pool
+#define REASSEMBLY_ERR_INVALID -2          // Bad fragment id / length / total
+#define REASSEMBLY_ERR_FRAG_SIZE -3        // frag_size outside the reassembly_init() limit
+
+/* Context states */
+#define REASSEMBLY_FREE 0
+#define REASSEMBLY_RECEIVING 1
+#define REASSEMBLY_READY 2                 // Complete, waiting to be verified
+#define REASSEMBLY_BUSY 3                  // Taken by the handshake worker
+
+/**
+ * Reassembly context
+ */
+typedef struct {
+    uint8_t peer_addr[16];                 // IPv6 address
+    uint16_t handshake_id;                 // AuthFragment.session_id
+    uint16_t total_frags;
+    uint16_t frag_size;                    // Payload bytes per fragment (negotiated)
+    uint16_t received_frags;
+    uint16_t length;                       // Payload bytes, known once the last fragment arrived
+    uint32_t bitmap[REASSEMBLY_BITMAP_WORDS]; // Bit i set => fragment i received
+    uint32_t started;
+    uint32_t last_activity;
+    uint32_t ready_seq;                    // Completion order, for FIFO verification
+    uint8_t *buf;                          // Pool slot
+    uint8_t state;
+    /* Erasure-coded transfer: total_frags is k, bitmap/received_frags
+     * count data fragments only */
+    uint8_t coded;
+    uint8_t parity_count;                  // Parity fragments held
+    uint8_t parity_row[FEC_MAX_PARITY];    // Row of each held parity fragment ...
+    uint8_t parity_slot[FEC_MAX_PARITY];   // ... and the missing data slot it occupies
+    uint8_t max_coded_id;                  // Highest coded index seen (loss feedback)
+} reassembly_ctx_t;
+
+/**
+ * Reset all contexts and return every buffer to the pool
+ * @param max_frag_size: Largest frag_size accepted, the limit the gateway
+ *        advertises (capped at REASSEMBLY_MAX_FRAG_SIZE)
+ */
+void reassembly_init(uint16_t max_frag_size);
+
+/**
+ * frag_size limit in force (advertise this in FRAG_ACKs)
+ */
+uint16_t reassembly_max_frag_size(void);
+
+/**
+ * Store one fragment
+ * A new (peer, handshake id) evicts the peer's older unfinished context.
+ * Fragments of a handshake completed within REASSEMBLY_TIMEOUT (late
+ * retransmits, late parity) return REASSEMBLY_STALE with *ctx_out NULL
+ * instead of opening a context that would hold a slot until it expires.
+ * Fragment i starts at i * frag_size; frag_size is fixed per context.
+ * @param ctx_out: Receives the context (also for DUPLICATE)
+ * @param created: Set to 1 if this fragment opened a new context
+ * @returns REASSEMBLY_PENDING / _COMPLETE / _DUPLICATE or REASSEMBLY_ERR_*
+ */
+int reassembly_add(const uint8_t *peer_addr, uint16_t handshake_id,
+                   uint16_t fragment_id, uint16_t total_frags, uint16_t frag_size,
+                   const uint8_t *payload, uint16_t payload_len,
+                   uint32_t now, reassembly_ctx_t **ctx_out, uint8_t *created);
+
+/**
+ * Store one erasure-coded fragment
+ * coded_id < k is data fragment coded_id, otherwise parity row coded_id - k.
+ * Every coded fragment but the last data one carries frag_size bytes;
+ * payload_total fixes the length of that last one.
+ * @returns As reassembly_add(); COMPLETE once any k fragments are held
+ */
+int reassembly_add_coded(const uint8_t *peer_addr, uint16_t handshake_id,
+                         uint8_t coded_id, uint8_t k, uint16_t frag_size,
+                         uint16_t payload_total,
+                         const uint8_t *payload, uint16_t payload_len,
+                         uint32_t now, reassembly_ctx_t **ctx_out, uint8_t *created);
+
+/**
+ * Rebuild missing data fragments of a complete coded context from the
+ * parity it holds (no-op for plain contexts). Call from the worker, not
+ * the receive path: cost grows with erasures^2 * frag_size.
+ * @returns 0 on success, -1 on failure
+ */
+int reassembly_fec_decode(reassembly_ctx_t *ctx);
+
+/**
+ * Acknowledgment state for a context
+ * @param cum_ack: First missing fragment (total_frags when complete)
+ * @param sack: Bit k set => fragment cum_ack + 1 + k received
+ */
+void reassembly_ack_state(const reassembly_ctx_t *ctx, uint16_t *cum_ack, uint32_t *sack);
+
+/**
+ * Oldest complete context, marked BUSY (NULL if none)
+ */
+reassembly_ctx_t *reassembly_next_ready(void);
+
+/**
+ * Take a specific READY context (marks it BUSY)
+ * @returns 0, or -1 if it is not READY
+ */
+int reassembly_take(reassembly_ctx_t *ctx);
+
+/**
+ * Longest-running RECEIVING context (NULL if none), for work that can
+ * start before the last fragment
+ */
+reassembly_ctx_t *reassembly_oldest_receiving(void);
+
+/**
+ * Payload bytes present contiguously from offset 0 (data fragments only)
+ */
+uint32_t reassembly_prefix(const reassembly_ctx_t *ctx);
+
+/**
+ * Return a context and its buffer to the pool
+ */
+void reassembly_release(reassembly_ctx_t *ctx);
+
+/**
+ * Drop RECEIVING contexts idle for more than REASSEMBLY_TIMEOUT seconds
+ * @returns Number of contexts dropped
+ */
+int reassembly_expire(uint32_t now);
+
+/**
+ * Contexts currently in use (receiving, ready or busy)
+ */
+int reassembly_in_use(void);
+
+#endif /* REASSEMBLY_H_ */
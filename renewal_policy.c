@@ -0,0 +1,161 @@
+/**
+ * renewal_policy.c
+ * Adaptive Session Renewal Policy (sender)
+ *
+ * Handshake cost is the energest CPU + radio time spent between
+ * handshake_begin() and handshake_end(). The re-authentication interval
+ * is stretched until that cost is at most RENEWAL_HANDSHAKE_BUDGET_PCT percent
+ * of the energy the node spends across all epochs between two handshakes.
+ */
+
+#include "contiki.h"
+#include "renewal_policy.h"
+#include "sys/energest.h"
+#include "sys/log.h"
+#include "lib/random.h"
+
+#define LOG_MODULE "Policy"
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+/* Current epoch */
+static uint32_t epoch_msgs;
+static uint32_t epoch_bytes;
+static unsigned long epoch_started;
+static uint64_t epoch_energy_start;
+
+/* Jittered limits for the current epoch */
+static uint32_t limit_msgs;
+static uint32_t limit_bytes;
+static uint32_t limit_age;
+
+/* Cost model */
+static uint64_t handshake_energy_start;
+static uint64_t handshake_cost;            // Energest ticks of the last handshake
+static uint64_t epoch_cost;                // Energest ticks of the last full epoch
+static uint16_t reauth_epochs;
+static uint8_t forced_reauth;
+
+static uint64_t energy_now(void) {
+    energest_flush();
+    return energest_type_time(ENERGEST_TYPE_CPU) +
+           energest_type_time(ENERGEST_TYPE_TRANSMIT) +
+           energest_type_time(ENERGEST_TYPE_LISTEN);
+}
+
+/* Uniform in [limit * (100 - RENEWAL_JITTER_PCT) / 100, limit] */
+static uint32_t jittered(uint32_t limit) {
+    uint32_t span;
+    
+    if (limit == 0 || RENEWAL_JITTER_PCT == 0) return limit;
+    span = (uint32_t)(((uint64_t)limit * RENEWAL_JITTER_PCT) / 100);
+    if (span == 0) return limit;
+    return limit - (random_rand() % (span + 1));
+}
+
+/* Is the epoch at pct percent of its (jittered) limits? */
+static int epoch_reached(uint32_t pct) {
+    unsigned long age = clock_seconds() - epoch_started;
+    
+    if ((uint64_t)epoch_msgs * 100 >= (uint64_t)limit_msgs * pct) return 1;
+    if (limit_bytes && (uint64_t)epoch_bytes * 100 >= (uint64_t)limit_bytes * pct) return 1;
+    if (limit_age && (uint64_t)age * 100 >= (uint64_t)limit_age * pct) return 1;
+    return 0;
+}
+
+static void update_reauth_epochs(void) {
+    uint32_t needed;
+    
+    reauth_epochs = RENEWAL_REAUTH_EPOCHS;
+    if (handshake_cost == 0 || epoch_cost == 0 || RENEWAL_HANDSHAKE_BUDGET_PCT == 0) {
+        return;
+    }
+    
+    /* handshake_cost <= budget% * (epochs * epoch_cost) */
+    needed = (uint32_t)((handshake_cost * 100 + (uint64_t)RENEWAL_HANDSHAKE_BUDGET_PCT * epoch_cost - 1) /
+                        ((uint64_t)RENEWAL_HANDSHAKE_BUDGET_PCT * epoch_cost));
+    if (needed > reauth_epochs) reauth_epochs = needed;
+    if (reauth_epochs > RENEWAL_MAX_REAUTH_EPOCHS) reauth_epochs = RENEWAL_MAX_REAUTH_EPOCHS;
+}
+
+void renewal_policy_init(void) {
+    handshake_cost = 0;
+    epoch_cost = 0;
+    renewal_policy_session_start();
+    
+    LOG_INFO("Policy: msgs=%lu bytes=%lu age=%lus reauth=%u..%u epochs jitter=%u%%\n",
+             (unsigned long)RENEWAL_MAX_MSGS, (unsigned long)RENEWAL_MAX_BYTES,
+             (unsigned long)RENEWAL_MAX_AGE, (unsigned)RENEWAL_REAUTH_EPOCHS,
+             (unsigned)RENEWAL_MAX_REAUTH_EPOCHS, (unsigned)RENEWAL_JITTER_PCT);
+}
+
+void renewal_policy_session_start(void) {
+    forced_reauth = 0;
+    epoch_energy_start = energy_now();
+    epoch_msgs = 0;
+    epoch_bytes = 0;
+    epoch_started = clock_seconds();
+    limit_msgs = jittered(RENEWAL_MAX_MSGS);
+    limit_bytes = jittered(RENEWAL_MAX_BYTES);
+    limit_age = jittered(RENEWAL_MAX_AGE);
+    if (limit_msgs == 0) limit_msgs = 1;
+    update_reauth_epochs();
+}
+
+void renewal_policy_epoch_start(void) {
+    uint64_t now = energy_now();
+    
+    epoch_cost = now - epoch_energy_start;
+    epoch_energy_start = now;
+    epoch_msgs = 0;
+    epoch_bytes = 0;
+    epoch_started = clock_seconds();
+    limit_msgs = jittered(RENEWAL_MAX_MSGS);
+    limit_bytes = jittered(RENEWAL_MAX_BYTES);
+    limit_age = jittered(RENEWAL_MAX_AGE);
+    if (limit_msgs == 0) limit_msgs = 1;
+    update_reauth_epochs();
+    
+    LOG_INFO("Epoch limits: %lu msgs, %lu bytes, %lus (reauth every %u epochs)\n",
+             (unsigned long)limit_msgs, (unsigned long)limit_bytes,
+             (unsigned long)limit_age, reauth_epochs);
+}
+
+void renewal_policy_record(uint32_t pt_len) {
+    epoch_msgs++;
+    epoch_bytes += pt_len;
+}
+
+renewal_action_t renewal_policy_decide(uint16_t epoch) {
+    int last_epoch = forced_reauth || (epoch + 1 >= reauth_epochs);
+    
+    if (!last_epoch) {
+        return epoch_reached(100) ? RENEWAL_KEY_UPDATE : RENEWAL_NONE;
+    }
+    if (epoch_reached(RENEWAL_GRACE_PCT)) {
+        return RENEWAL_EXPIRED;
+    }
+    if (epoch_reached(RENEWAL_LEAD_PCT)) {
+        return RENEWAL_REAUTH;
+    }
+    return RENEWAL_NONE;
+}
+
+void renewal_policy_force_reauth(void) {
+    forced_reauth = 1;
+}
+
+void renewal_policy_handshake_begin(void) {
+    handshake_energy_start = energy_now();
+}
+
+void renewal_policy_handshake_end(void) {
+    handshake_cost = energy_now() - handshake_energy_start;
+    update_reauth_epochs();
+    
+    LOG_INFO("Handshake cost: %lu ms CPU+radio (reauth every %u epochs)\n",
+             (unsigned long)(handshake_cost * 1000 / ENERGEST_SECOND), reauth_epochs);
+}
+
+uint16_t renewal_policy_reauth_epochs(void) {
+    return reauth_epochs;
+}
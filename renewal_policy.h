@@ -0,0 +1,107 @@
+/**
+ * renewal_policy.h
+ * Adaptive Session Renewal Policy (sender)
+ *
+ * Decides when the sender ratchets its session key (KEY_UPDATE) and when
+ * it runs a full post-quantum re-authentication. The decision combines
+ * message count, plaintext bytes, epoch age and the measured energy cost
+ * of the last handshake. Every limit is drawn with a per-epoch random
+ * jitter, so nodes that booted together do not renew in lockstep.
+ */
+
+#ifndef RENEWAL_POLICY_H_
+#define RENEWAL_POLICY_H_
+
+#include <stdint.h>
+
+/* Compile-time settings; override them in project-conf.h */
+#ifndef RENEWAL_MAX_MSGS
+#define RENEWAL_MAX_MSGS 20                // Key update after this many messages
+#endif
+#ifndef RENEWAL_MAX_BYTES
+#define RENEWAL_MAX_BYTES 4096             // ... or this many plaintext bytes (0 = off)
+#endif
+#ifndef RENEWAL_MAX_AGE
+#define RENEWAL_MAX_AGE 600                // ... or this many seconds (0 = off)
+#endif
+#ifndef RENEWAL_REAUTH_EPOCHS
+#define RENEWAL_REAUTH_EPOCHS 4            // Minimum key epochs per re-authentication
+#endif
+#ifndef RENEWAL_MAX_REAUTH_EPOCHS
+#define RENEWAL_MAX_REAUTH_EPOCHS (4 * RENEWAL_REAUTH_EPOCHS) // Upper bound when stretched for cost
+#endif
+#ifndef RENEWAL_JITTER_PCT
+#define RENEWAL_JITTER_PCT 25              // Limits drawn from [L*(100-j)/100, L]
+#endif
+#ifndef RENEWAL_LEAD_PCT
+#define RENEWAL_LEAD_PCT 75                // Start background re-auth this early
+#endif
+#ifndef RENEWAL_GRACE_PCT
+#define RENEWAL_GRACE_PCT 200              // Old session survives this far past the limit
+#endif
+#ifndef RENEWAL_HANDSHAKE_BUDGET_PCT
+#define RENEWAL_HANDSHAKE_BUDGET_PCT 10    // Max share of energy spent on handshakes
+#endif
+
+#if RENEWAL_MAX_MSGS < 1 || RENEWAL_REAUTH_EPOCHS < 1
+#error "RENEWAL_MAX_MSGS and RENEWAL_REAUTH_EPOCHS must be at least 1"
+#endif
+#if RENEWAL_MAX_REAUTH_EPOCHS < RENEWAL_REAUTH_EPOCHS
+#error "RENEWAL_MAX_REAUTH_EPOCHS must not be below RENEWAL_REAUTH_EPOCHS"
+#endif
+#if RENEWAL_JITTER_PCT > 90 || RENEWAL_LEAD_PCT > 100 || RENEWAL_GRACE_PCT < 100
+#error "Need RENEWAL_JITTER_PCT <= 90, RENEWAL_LEAD_PCT <= 100, RENEWAL_GRACE_PCT >= 100"
+#endif
+
+/**
+ * What the data loop should do before sending the next message
+ */
+typedef enum {
+    RENEWAL_NONE = 0,                      // Keep sending on the current key
+    RENEWAL_KEY_UPDATE,                    // Ratchet K_master (1 RTT)
+    RENEWAL_REAUTH,                        // Start the PQ handshake in the background
+    RENEWAL_EXPIRED                        // Session must stop carrying DATA
+} renewal_action_t;
+
+/**
+ * Start the first epoch
+ */
+void renewal_policy_init(void);
+
+/**
+ * A new session was established (handshake or resumption)
+ */
+void renewal_policy_session_start(void);
+
+/**
+ * A new key epoch started (after KEY_UPDATE); redraws the jittered limits
+ */
+void renewal_policy_epoch_start(void);
+
+/**
+ * Account one DATA message of pt_len plaintext bytes
+ */
+void renewal_policy_record(uint32_t pt_len);
+
+/**
+ * Decide the next renewal step for a session in key epoch `epoch`
+ */
+renewal_action_t renewal_policy_decide(uint16_t epoch);
+
+/**
+ * Key update failed: re-authenticate in the background instead
+ */
+void renewal_policy_force_reauth(void);
+
+/**
+ * Bracket a full handshake to measure its energest cost
+ */
+void renewal_policy_handshake_begin(void);
+void renewal_policy_handshake_end(void);
+
+/**
+ * Key epochs per re-authentication after cost stretching
+ */
+uint16_t renewal_policy_reauth_epochs(void);
+
+#endif /* RENEWAL_POLICY_H_ */
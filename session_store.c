@@ -0,0 +1,167 @@
+/**
+ * session_store.c
+ * Persistent Sender Session State (Contiki CFS)
+ *
+ * Two record slots are written alternately with a sequence number and a
+ * truncated SHA-256 digest, so a reset in the middle of a write leaves
+ * the previous record intact.
+ */
+
+#include "session_store.h"
+#include "cfs/cfs.h"
+#include "sys/log.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#define LOG_MODULE "Store"
+#define LOG_LEVEL LOG_LEVEL_INFO
+
+#define STORE_MAGIC 0x53455353UL           // "SESS"
+#define STORE_DIGEST_LEN 8
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint8_t active;
+    uint8_t sid[SID_LEN];
+    uint8_t K_master[MASTER_KEY_LEN];
+    uint32_t counter_limit;                // First counter not yet reserved
+    uint32_t expiry_ts;
+    uint16_t epoch;
+    uint8_t ticket_valid;
+    uint8_t ticket[TICKET_LEN];
+    uint8_t ticket_key[MASTER_KEY_LEN];
+    uint8_t digest[STORE_DIGEST_LEN];
+} store_record_t;
+
+static const char *slot_names[2] = { "sess.a", "sess.b" };
+
+/* RAM copy of the last record written */
+static store_record_t rec;
+static uint8_t next_slot;
+
+static void record_digest(uint8_t *out, const store_record_t *r) {
+    uint8_t h[SHA256_DIGEST_SIZE];
+    sha256_hash(h, (const uint8_t *)r, offsetof(store_record_t, digest));
+    memcpy(out, h, STORE_DIGEST_LEN);
+}
+
+static int record_valid(const store_record_t *r) {
+    uint8_t d[STORE_DIGEST_LEN];
+    
+    if (r->magic != STORE_MAGIC) return 0;
+    record_digest(d, r);
+    return constant_time_compare(d, r->digest, STORE_DIGEST_LEN) == 0;
+}
+
+static int record_read(int slot, store_record_t *r) {
+    int fd = cfs_open(slot_names[slot], CFS_READ);
+    int n;
+    
+    if (fd < 0) return -1;
+    n = cfs_read(fd, r, sizeof(*r));
+    cfs_close(fd);
+    
+    return (n == sizeof(*r) && record_valid(r)) ? 0 : -1;
+}
+
+static int record_commit(void) {
+    int fd, n;
+    
+    rec.magic = STORE_MAGIC;
+    rec.seq++;
+    record_digest(rec.digest, &rec);
+    
+    fd = cfs_open(slot_names[next_slot], CFS_WRITE);
+    if (fd < 0) {
+        LOG_ERR("Cannot open %s\n", slot_names[next_slot]);
+        return -1;
+    }
+    cfs_seek(fd, 0, CFS_SEEK_SET);
+    n = cfs_write(fd, &rec, sizeof(rec));
+    cfs_close(fd);
+    
+    if (n != sizeof(rec)) {
+        LOG_ERR("Short write to %s\n", slot_names[next_slot]);
+        return -1;
+    }
+    next_slot ^= 1;
+    return 0;
+}
+
+int session_store_load(session_ctx_t *ctx,
+                       uint8_t *ticket, uint8_t *ticket_key,
+                       uint8_t *ticket_valid) {
+    static store_record_t slot[2];
+    int ok0 = (record_read(0, &slot[0]) == 0);
+    int ok1 = (record_read(1, &slot[1]) == 0);
+    int best;
+    
+    if (!ok0 && !ok1) {
+        secure_zero(slot, sizeof(slot));
+        return -1;
+    }
+    best = (ok0 && (!ok1 || slot[0].seq >= slot[1].seq)) ? 0 : 1;
+    rec = slot[best];
+    next_slot = best ^ 1;
+    secure_zero(slot, sizeof(slot));
+    
+    memset(ctx, 0, sizeof(*ctx));
+    if (rec.active) {
+        memcpy(ctx->sid, rec.sid, SID_LEN);
+        memcpy(ctx->K_master, rec.K_master, MASTER_KEY_LEN);
+        ctx->counter = rec.counter_limit;  // Everything below may have been used
+        ctx->expiry_ts = rec.expiry_ts;
+        ctx->epoch = rec.epoch;
+        ctx->active = 1;
+    }
+    *ticket_valid = rec.ticket_valid;
+    if (rec.ticket_valid) {
+        memcpy(ticket, rec.ticket, TICKET_LEN);
+        memcpy(ticket_key, rec.ticket_key, MASTER_KEY_LEN);
+    }
+    
+    LOG_INFO("Restored record #%u (session %s, counter %u, ticket %s)\n",
+             (unsigned)rec.seq, rec.active ? "active" : "none",
+             (unsigned)rec.counter_limit, rec.ticket_valid ? "yes" : "no");
+    return (rec.active || rec.ticket_valid) ? 0 : -1;
+}
+
+int session_store_save(const session_ctx_t *ctx,
+                       const uint8_t *ticket, const uint8_t *ticket_key) {
+    rec.active = ctx->active;
+    memcpy(rec.sid, ctx->sid, SID_LEN);
+    memcpy(rec.K_master, ctx->K_master, MASTER_KEY_LEN);
+    rec.counter_limit = ctx->counter + SESSION_STORE_COUNTER_BLOCK;
+    rec.expiry_ts = ctx->expiry_ts;
+    rec.epoch = ctx->epoch;
+    
+    rec.ticket_valid = (ticket != NULL);
+    if (ticket != NULL) {
+        memcpy(rec.ticket, ticket, TICKET_LEN);
+        memcpy(rec.ticket_key, ticket_key, MASTER_KEY_LEN);
+    } else {
+        secure_zero(rec.ticket, TICKET_LEN);
+        secure_zero(rec.ticket_key, MASTER_KEY_LEN);
+    }
+    
+    return record_commit();
+}
+
+int session_store_reserve(const session_ctx_t *ctx) {
+    if (ctx->counter < rec.counter_limit) {
+        return 0;
+    }
+    
+    /* Block exhausted: checkpoint the next limit before using the counter */
+    rec.counter_limit = ctx->counter + SESSION_STORE_COUNTER_BLOCK;
+    return record_commit();
+}
+
+void session_store_clear(void) {
+    cfs_remove(slot_names[0]);
+    cfs_remove(slot_names[1]);
+    secure_zero(&rec, sizeof(rec));
+    next_slot = 0;
+}
@@ -0,0 +1,57 @@
+/**
+ * session_store.h
+ * Persistent Sender Session State (Contiki CFS)
+ *
+ * Keeps the sender's session context and resumption ticket in flash so a
+ * watchdog reset or battery swap does not force a full handshake.
+ * Counters are reserved in blocks: the store records an upper limit
+ * before any counter below it is used, so flash is written once per
+ * SESSION_STORE_COUNTER_BLOCK messages and a restart resumes at the
+ * limit, never reusing a nonce.
+ *
+ * K_master and the ticket key are stored in the clear: the Z1 has no
+ * device key or secure element to wrap them under, and a key derived
+ * from anything else in flash would sit next to what it protects. The
+ * store therefore assumes an attacker cannot read the mote's flash; the
+ * digest only detects torn or corrupted records.
+ */
+
+#ifndef SESSION_STORE_H_
+#define SESSION_STORE_H_
+
+#include "crypto_core.h"
+
+#ifndef SESSION_STORE_COUNTER_BLOCK
+#define SESSION_STORE_COUNTER_BLOCK 16     // Counters reserved per flash write
+#endif
+
+/**
+ * Load the newest valid record
+ * On success ctx->counter is set to the reserved limit (first unused counter).
+ * @param ticket/ticket_key: Receive the resumption ticket and its K_master
+ * @returns 0 if a record was restored, -1 if none is usable
+ */
+int session_store_load(session_ctx_t *ctx,
+                       uint8_t *ticket, uint8_t *ticket_key,
+                       uint8_t *ticket_valid);
+
+/**
+ * Persist a new session and/or ticket (pass ticket = NULL to drop it)
+ * Reserves counters [ctx->counter, ctx->counter + BLOCK) for an active session.
+ */
+int session_store_save(const session_ctx_t *ctx,
+                       const uint8_t *ticket, const uint8_t *ticket_key);
+
+/**
+ * Make sure ctx->counter is covered by the reserved block
+ * Call before every use of a counter; writes flash only when a block runs out.
+ * @returns 0 if the counter may be used, -1 if the checkpoint write failed
+ */
+int session_store_reserve(const session_ctx_t *ctx);
+
+/**
+ * Erase all persisted session state
+ */
+void session_store_clear(void);
+
+#endif /* SESSION_STORE_H_ */
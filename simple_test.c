@@ -121,14 +121,16 @@ int main() {
     ring_lwe_keygen(&temp_key);
     ring_pks[2] = temp_key.public;
     
-    Poly512 other_pks[2] = {gateway_keys.public, temp_key.public};
+    PolyView ring_views[3];
+    int v;
+    for (v = 0; v < 3; v++) ring_views[v] = poly_view(&ring_pks[v]);
     
     log_msg("Generating ring signature...\n");
     RingSignature sig;
     uint8_t keyword[32] = "AUTH_REQUEST";
     
     start = clock();
-    result = ring_sign(&sig, keyword, &sender_keys, other_pks, 0);
+    result = ring_sign(&sig, keyword, &sender_keys, ring_views, 0);
     end = clock();
     elapsed = ((double)(end - start)) / CLOCKS_PER_SEC * 1000.0;
     
@@ -143,7 +143,7 @@ int main() {
     /* Generate other ring member keys */
     log_message("\n🔐 Generating Other Ring Member Keys...\n");
     Poly512 ring_public_keys[RING_SIZE];
-    Poly512 other_pubkeys[RING_SIZE - 1];
+    PolyView ring_views[RING_SIZE];
     
     ring_public_keys[0] = sender_keypair.public;
     ring_public_keys[1] = gateway_keypair.public;
@@ -157,8 +157,10 @@ int main() {
     sprintf(buffer, "   ✅ Generated %d ring members (%.2f ms)\n", RING_SIZE, elapsed_ms);
     log_message(buffer);
     
-    other_pubkeys[0] = gateway_keypair.public;
-    other_pubkeys[1] = temp_keypair.public;
+    int v;
+    for (v = 0; v < RING_SIZE; v++) {
+        ring_views[v] = poly_view(&ring_public_keys[v]);
+    }
     
     log_phase_success("Ring Setup Complete", 
                      "Initialized 3-member ring with distinct public keys");
@@ -178,7 +180,7 @@ int main() {
     log_message(buffer);
     
     start_timer();
-    result = ring_sign(&signature, keyword, &sender_keypair, other_pubkeys, 0);
+    result = ring_sign(&signature, keyword, &sender_keypair, ring_views, 0);
     elapsed_ms = end_timer();
     
     if (result == 0) {
@@ -1,5 +1,6 @@
 #include "contiki.h"
 #include "crypto_core.h"
+#include "reassembly.h"
 #include "sys/log.h"
 #include <stdio.h>
 #include <string.h>
@@ -40,7 +41,7 @@ PROCESS_THREAD(test_process, ev, data)
     int ret = ring_lwe_keygen(&keypair);
     assert_true(ret == 0, "Key Generation");
     
-    poly_print("Secret Key", &keypair.secret, 8);
+    poly_small_print("Secret Key", &keypair.secret, 8);
     poly_print("Public Key", &keypair.public, 8);
 
     /* 3. Ring Setup */
@@ -52,6 +53,20 @@ PROCESS_THREAD(test_process, ev, data)
     }
     printf("Ring initialized with %d members\n", RING_SIZE);
 
+    /* 3b. Build-time tables (ring_tables.c) match the runtime generators */
+    {
+        static Poly512 expanded;
+        
+        ring_expand_a(&expanded);
+        assert_true(memcmp(&expanded, &ring_a_table, sizeof(Poly512)) == 0,
+                    "Flash table a matches runtime expansion");
+        for (i = 0; i < RING_SIZE; i++) {
+            generate_ring_member_key(&expanded, i);
+            if (memcmp(&expanded, &ring_member_table[i], sizeof(Poly512)) != 0) break;
+        }
+        assert_true(i == RING_SIZE, "Flash member keys match runtime expansion");
+    }
+
     /* 4. Sign */
     static RingSignature sig;
     uint8_t keyword[KEYWORD_SIZE] = "AUTH_REQUEST";
@@ -60,16 +75,14 @@ PROCESS_THREAD(test_process, ev, data)
     memset(syndrome, 0xAA, sizeof(syndrome));
     
     /* Signature logic needs a message structure or hash binding */
-    /* The ring_sign function takes explicit inputs. */
-    /* Wait, ring_sign signature: 
-       int ring_sign(RingSignature *sig, const uint8_t *keyword,
-              const RingLWEKeyPair *signer_keypair,
-              const Poly512 ring_pubkeys[RING_SIZE],
-              int signer_index);
-    */
+    /* The ring_sign function takes explicit inputs: the ring as views */
+    static PolyView ring_views[RING_SIZE];
+    for (i = 0; i < RING_SIZE; i++) {
+        ring_views[i] = poly_view(&ring_keys[i]);
+    }
     
     printf("Signing...\n");
-    ret = ring_sign(&sig, keyword, &keypair, ring_keys, 0);
+    ret = ring_sign(&sig, keyword, &keypair, ring_views, 0);
     assert_true(ret == 0, "Signature Generation");
 
     /* 5. Verify */
@@ -77,7 +90,55 @@ PROCESS_THREAD(test_process, ev, data)
     int verify_ret = ring_verify(&sig, ring_keys);
     assert_true(verify_ret == 1, "Signature Verification");
 
-    if (verify_ret == 1) {
+    /* 6. Erasure-coded reassembly: k = 4 data fragments (the last one
+     * short), 2 parity. First data 1 and 3 are lost and rebuilt from the
+     * parity; then both parity fragments overtake data 3 and 0, so data 3
+     * lands on a slot where parity is parked */
+    int fec_ok = 1;
+    {
+        static uint8_t data[4 * 32], parity[2][32];
+        static const uint8_t peer[16] = { 0xfe, 0x80 };
+        const uint16_t total = 3 * 32 + 20;
+        static const uint8_t orders[2][4] = {       // Coded ids that arrive
+            { 0, 2, 4, 5 },
+            { 5, 4, 3, 0 }
+        };
+        reassembly_ctx_t *ctx;
+        uint8_t created, h, c, t;
+        int r = REASSEMBLY_PENDING;
+        
+        for (i = 0; i < total; i++) data[i] = (uint8_t)crypto_random_uint32();
+        memset(data + total, 0, sizeof(data) - total);
+        memset(parity, 0, sizeof(parity));
+        for (h = 0; h < 2; h++) {
+            for (c = 0; c < 4; c++) {
+                fec_accumulate(parity[h], data + c * 32, 32, fec_coeff(4, h, c));
+            }
+        }
+        
+        reassembly_init(REASSEMBLY_MAX_FRAG_SIZE);
+        for (t = 0; t < 2; t++) {
+            for (i = 0; i < 4; i++) {
+                c = orders[t][i];
+                r = reassembly_add_coded(peer, 0x1234 + t, c, 4, 32, total,
+                                         c < 4 ? data + c * 32 : parity[c - 4],
+                                         c == 3 ? total - 3 * 32 : 32, 100, &ctx, &created);
+            }
+            fec_ok = fec_ok && r == REASSEMBLY_COMPLETE && reassembly_fec_decode(ctx) == 0 &&
+                     reassembly_prefix(ctx) == total && memcmp(ctx->buf, data, total) == 0;
+            reassembly_release(ctx);
+        }
+        assert_true(fec_ok, "Erasure decode restores the lost fragments, in any order");
+        
+        /* A late parity fragment must not take a new context */
+        r = reassembly_add_coded(peer, 0x1234, 5, 4, 32, total, parity[1], 32,
+                                 101, &ctx, &created);
+        assert_true(r == REASSEMBLY_STALE && reassembly_in_use() == 0,
+                    "Straggler of a completed handshake is dropped");
+        fec_ok = fec_ok && r == REASSEMBLY_STALE;
+    }
+
+    if (verify_ret == 1 && fec_ok) {
         printf("=== TEST PASSED: Logic is correct ===\n");
     } else {
         printf("=== TEST FAILED: Math issue or Bounds ===\n");
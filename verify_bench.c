@@ -0,0 +1,154 @@
+#include "contiki.h"
+#include "crypto_core.h"
+#include "sys/rtimer.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+ * Cost of rejecting forged AUTH signatures vs accepting a valid one.
+ *
+ * A forger can always make the commitment consistent (it is just
+ * H(w || keyword) over values they choose), so the classes below all
+ * pass the hash check except the first and land on the ring-level filters:
+ *   garbage   - random bytes, commitment mismatch
+ *   z-bound   - consistent commitment, z outside RING_Z_BOUND
+ *   in-bound  - consistent commitment, random z within the bound
+ *   valid     - ring_sign() output (full a*z - t*c for the signer)
+ *
+ * The longest single slice is what a DATA packet can wait behind a
+ * handshake in node-gateway's handshake_process; the whole verification
+ * is what it waited when verification ran inside the receive callback.
+ */
+
+#define BENCH_TRIALS 8
+
+PROCESS(bench_process, "Verification Benchmark Process");
+AUTOSTART_PROCESSES(&bench_process);
+
+static RingLWEKeyPair keypair;
+static Poly512 ring_keys[RING_SIZE];
+static PolyView ring_key_views[RING_SIZE];
+static RingSignature sig;
+static ring_verify_ctx_t verify_ctx;
+
+/* Commitment a forger computes for w || keyword */
+static void forge_commitment(RingSignature *s) {
+    static uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
+    int i;
+
+    for (i = 0; i < POLY_DEGREE; i++) {
+        int32_t v = s->w.coeff[i];
+        hash_input[i*4] = (v >> 24) & 0xFF;
+        hash_input[i*4+1] = (v >> 16) & 0xFF;
+        hash_input[i*4+2] = (v >> 8) & 0xFF;
+        hash_input[i*4+3] = v & 0xFF;
+    }
+    memcpy(hash_input + POLY_DEGREE * 4, s->keyword, KEYWORD_SIZE);
+    sha256_hash(s->commitment, hash_input, sizeof(hash_input));
+}
+
+/* z_range == 0: random bytes everywhere; otherwise z uniform in
+ * +/- z_range for every member, random high bits w, matching commitment */
+static void forge(RingSignature *s, int32_t z_range) {
+    int i, j;
+
+    if (z_range == 0) {
+        uint8_t *p = (uint8_t *)s;
+        for (i = 0; i < (int)sizeof(*s); i++) p[i] = crypto_random_uint32() & 0xFF;
+        return;
+    }
+    for (i = 0; i < RING_SIZE; i++) {
+        for (j = 0; j < POLY_DEGREE; j++) {
+            s->S[i].coeff[j] = (int32_t)(crypto_random_uint32() % (2 * (uint32_t)z_range + 1)) - z_range;
+        }
+    }
+    for (j = 0; j < POLY_DEGREE; j++) {
+        s->w.coeff[j] = crypto_random_uint32() % (((MODULUS_Q - 1) >> 13) + 1);
+    }
+    memcpy(s->keyword, "AUTH_REQUEST", 13);
+    forge_commitment(s);
+}
+
+/* One verification, driven slice by slice as handshake_process does */
+static int verify_timed(const RingSignature *s, rtimer_clock_t *ticks, int *slices,
+                        rtimer_clock_t *longest) {
+    rtimer_clock_t start = RTIMER_NOW();
+    rtimer_clock_t slice_start;
+    int ret;
+
+    *slices = 0;
+    ret = ring_verify_start(&verify_ctx, s, ring_keys);
+    while (ret == RING_VERIFY_PENDING) {
+        slice_start = RTIMER_NOW();
+        ret = ring_verify_step(&verify_ctx);
+        if (RTIMER_NOW() - slice_start > *longest) {
+            *longest = RTIMER_NOW() - slice_start;
+        }
+        (*slices)++;
+    }
+    *ticks = RTIMER_NOW() - start;
+    return ret;
+}
+
+static void bench(const char *name, int32_t z_range) {
+    unsigned long total_ticks = 0;
+    rtimer_clock_t longest = 0;
+    int total_slices = 0;
+    int accepted = 0;
+    int t;
+
+    for (t = 0; t < BENCH_TRIALS; t++) {
+        rtimer_clock_t ticks;
+        int slices;
+
+        if (z_range < 0) {
+            uint8_t keyword[KEYWORD_SIZE] = "AUTH_REQUEST";
+            if (ring_sign(&sig, keyword, &keypair, ring_key_views, 0) != 0) {
+                printf("Signing failed\n");
+                return;
+            }
+        } else {
+            forge(&sig, z_range);
+        }
+        accepted += verify_timed(&sig, &ticks, &slices, &longest) == 1;
+        total_ticks += ticks;
+        total_slices += slices;
+    }
+    printf("%-9s: %d/%d accepted, %lu ticks, %d.%d slices per verification, "
+           "longest slice %lu ticks\n",
+           name, accepted, BENCH_TRIALS, total_ticks / BENCH_TRIALS,
+           total_slices / BENCH_TRIALS, (total_slices * 10 / BENCH_TRIALS) % 10,
+           (unsigned long)longest);
+}
+
+PROCESS_THREAD(bench_process, ev, data)
+{
+    int i;
+
+    PROCESS_BEGIN();
+
+    printf("=== Ring Verification Benchmark (n=%d, ring=%d, %lu ticks/s) ===\n",
+           POLY_DEGREE, RING_SIZE, (unsigned long)RTIMER_SECOND);
+
+    crypto_prng_init(0x12345678);
+    if (ring_lwe_keygen(&keypair) != 0) {
+        printf("Key generation failed\n");
+        PROCESS_EXIT();
+    }
+    ring_keys[0] = keypair.public;
+    for (i = 1; i < RING_SIZE; i++) {
+        generate_ring_member_key(&ring_keys[i], i);
+    }
+    for (i = 0; i < RING_SIZE; i++) {
+        ring_key_views[i] = poly_view(&ring_keys[i]);
+    }
+
+    bench("garbage", 0);
+    bench("z-bound", 4 * RING_Z_BOUND);
+    bench("in-bound", RING_Z_BOUND);
+    bench("valid", -1);
+
+    printf("=== Benchmark done ===\n");
+
+    PROCESS_END();
+}
@@ -108,6 +108,97 @@ void poly_mul_ntt(Poly512 *result, const Poly512 *a, const Poly512 *b) {
     poly_mul_schoolbook(result, a, b);
 }
 
+/* ========== STREAMED SHARED 'a' ========== */
+
+/* Terms accumulated between reductions: |a_i * b_j| < 2^58, so 16 of
+ * them (plus a reduced remainder) stay inside int64 */
+#define RING_A_REDUCE_EVERY 16
+
+int32_t ring_a_coeff(uint16_t i) {
+    /* Counter mode: mix (key, i) with the murmur3 finaliser */
+    uint32_t x = (uint32_t)RING_A_SEED ^ ((uint32_t)i * 0x9E3779B9UL);
+    
+    x ^= x >> 16;
+    x *= 0x85EBCA6BUL;
+    x ^= x >> 13;
+    x *= 0xC2B2AE35UL;
+    x ^= x >> 16;
+    
+    /* Top 29 bits, folded below q (no division) */
+    x >>= 3;
+    if (x >= (uint32_t)MODULUS_Q) x -= MODULUS_Q;
+    return (int32_t)x;
+}
+
+void poly_mul_a(Poly512 *result, const Poly512 *b) {
+    int i, k;
+    
+    /* Output coefficient k: terms with i + j = k add, terms with
+     * i + j = n + k wrap past x^n = -1 and subtract */
+    for (k = 0; k < POLY_DEGREE; k++) {
+        int64_t acc = 0;
+        
+        for (i = 0; i < POLY_DEGREE; i++) {
+            int64_t ab;
+            
+            if (i <= k) {
+                ab = (int64_t)ring_a_coeff(i) * (b->coeff[k - i] % MODULUS_Q);
+                acc += ab;
+            } else {
+                ab = (int64_t)ring_a_coeff(i) * (b->coeff[POLY_DEGREE + k - i] % MODULUS_Q);
+                acc -= ab;
+            }
+            if ((i % RING_A_REDUCE_EVERY) == RING_A_REDUCE_EVERY - 1) {
+                acc %= MODULUS_Q;
+            }
+        }
+        result->coeff[k] = mod_q(acc);
+    }
+}
+
+/* As poly_mul_a() with a small operand: |a_i * s_j| < 2^36, so the n
+ * terms of a coefficient need no reduction until the end */
+void poly_mul_a_small(Poly512 *result, const PolySmall *s) {
+    int i, k;
+    
+    for (k = 0; k < POLY_DEGREE; k++) {
+        int64_t acc = 0;
+        
+        for (i = 0; i <= k; i++) {
+            acc += (int64_t)ring_a_coeff(i) * s->coeff[k - i];
+        }
+        for (; i < POLY_DEGREE; i++) {
+            acc -= (int64_t)ring_a_coeff(i) * s->coeff[POLY_DEGREE + k - i];
+        }
+        result->coeff[k] = mod_q(acc);
+    }
+}
+
+/* a * s walks output coefficients k: terms with i + j = k add, terms
+ * with i + j = n + k wrap past x^n = -1 and subtract */
+void poly_mul_small(Poly512 *result, const Poly512 *a, const PolySmall *s) {
+    int i, k;
+    
+    for (k = 0; k < POLY_DEGREE; k++) {
+        int64_t acc = 0;
+        
+        for (i = 0; i <= k; i++) {
+            acc += (int64_t)a->coeff[i] * s->coeff[k - i];
+        }
+        for (; i < POLY_DEGREE; i++) {
+            acc -= (int64_t)a->coeff[i] * s->coeff[POLY_DEGREE + k - i];
+        }
+        result->coeff[k] = mod_q(acc);
+    }
+}
+
+void poly_add_small(Poly512 *result, const Poly512 *a, const PolySmall *s) {
+    int i;
+    for (i = 0; i < POLY_DEGREE; i++) {
+        result->coeff[i] = mod_q((int64_t)a->coeff[i] + s->coeff[i]);
+    }
+}
+
 void poly_add(Poly512 *result, const Poly512 *a, const Poly512 *b) {
     int i;
     for (i = 0; i < POLY_DEGREE; i++) {
@@ -279,27 +370,20 @@ void generate_ring_member_key(Poly512 *public_key, int member_index) {
 
 int ring_lwe_keygen(RingLWEKeyPair *keypair) {
     int i;
-    Poly512 a, s, e;
+    PolySmall e;
     
-    uint32_t a_seed = 0xDEADBEEF;
-    uint32_t old_state = prng_state; /* Simulate shared system parameter 'a' */
-    crypto_prng_init(a_seed);
-    for(i=0; i<POLY_DEGREE; i++) a.coeff[i] = crypto_random_uint32() % MODULUS_Q;
-    crypto_prng_init(old_state);
-    
-    /* Sample secret s, error e */
+    /* Sample secret s (kept narrow), error e */
     for(i=0; i<POLY_DEGREE; i++) {
-        s.coeff[i] = gaussian_sample(STD_DEVIATION);
+        keypair->secret.coeff[i] = gaussian_sample(STD_DEVIATION);
         e.coeff[i] = gaussian_sample(STD_DEVIATION);
     }
     
-    /* t = a*s + e */
+    /* t = a*s + e, shared system parameter 'a' streamed */
     Poly512 as;
-    poly_mul_schoolbook(&as, &a, &s);
-    poly_add(&keypair->public, &as, &e); // Public key = t
+    poly_mul_a_small(&as, &keypair->secret);
+    poly_add_small(&keypair->public, &as, &e); // Public key = t
     
-    keypair->secret = s;
-    keypair->random = a; // Store 'a' for convenience
+    secure_zero(&e, sizeof(e));
     
     return 0;
 }
@@ -335,7 +419,7 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
         }
         
         /* 2. w = a*y */
-        poly_mul_schoolbook(&w, &signer_keypair->random, &y);
+        poly_mul_a(&w, &y);
         
         /* 3. Get High Bits of w */
         get_high_bits(&w_approx, &w);
@@ -356,7 +440,7 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
         for(i=0; i<POLY_DEGREE; i++) challenge.coeff[i] = (c_hash[i%32] >> (i%8)) & 1;
         
         /* 5. z = y + s*c */
-        poly_mul_schoolbook(&sc, &signer_keypair->secret, &challenge);
+        poly_mul_small(&sc, &challenge, &signer_keypair->secret);
         poly_add(&z, &y, &sc);
         
         /* 6. Bounds Check on z (Security) */
@@ -371,7 +455,7 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
         /* 7. Correctness Check (Verify w_approx consistency) */
         /* w' = a*z - t*c */
         poly_mul_schoolbook(&tc, &signer_keypair->public, &challenge);
-        poly_mul_schoolbook(&w_check, &signer_keypair->random, &z);
+        poly_mul_a(&w_check, &z);
         poly_sub(&w_check, &w_check, &tc);
         
         Poly512 w_check_approx;
@@ -416,17 +500,12 @@ int ring_sign(RingSignature *sig, const uint8_t *keyword,
 
 int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE]) {
     int i, j;
-    Poly512 a, z, tc, w_prime, challenge;
+    Poly512 z, tc, w_prime, challenge;
     Poly512 w_expected = sig->w; /* The w_approx from signer */
     uint8_t c_hash[SHA256_DIGEST_SIZE];
     uint8_t hash_input[POLY_DEGREE * 4 + KEYWORD_SIZE];
     
-    /* 1. Reconstruct 'a' */
-    uint32_t a_seed = 0xDEADBEEF;
-    uint32_t old_state = prng_state;
-    crypto_prng_init(a_seed);
-    for(i=0; i<POLY_DEGREE; i++) a.coeff[i] = crypto_random_uint32() % MODULUS_Q;
-    crypto_prng_init(old_state);
+    /* 1. 'a' is streamed into the product below, never reconstructed */
     
     /* 2. Verify 'c' matches 'w_approx' */
     for(i=0; i<POLY_DEGREE; i++) {
@@ -456,7 +535,7 @@ int ring_verify(const RingSignature *sig, const Poly512 public_keys[RING_SIZE])
         if (!non_zero) continue; 
         
         /* w' = a*z - t*c */
-        poly_mul_schoolbook(&w_prime, &a, &z);
+        poly_mul_a(&w_prime, &z);
         poly_mul_schoolbook(&tc, &public_keys[i], &challenge);
         poly_sub(&w_prime, &w_prime, &tc);
         
@@ -16,7 +16,7 @@
  *   - AuthFragment payload reduced 64 -> 48 bytes
  *
  * RAM Budget (approx after reductions):
- *   RingLWEKeyPair : 3 x (32x4) = 384 bytes
+ *   RingLWEKeyPair : 2 x (32x4) = 256 bytes (a is streamed, never stored)
  *   RingSignature  : (2+1) x 128 + 64 = 448 bytes
  *   session_entry  : 2 x 65 = 130 bytes
  *   OS overhead    : ~4000 bytes
@@ -45,13 +45,16 @@
 
 /* ========== RING-LWE PARAMETERS ========== */
 
+#ifndef POLY_DEGREE
 #define POLY_DEGREE 32                     // n: Z1-reduced from 128 (saves 75% RAM)
+#endif
 #define MODULUS_Q 536870909L               // q: Prime modulus (2^29 - 3)
 #define STD_DEVIATION 43                   // σ: Gaussian standard deviation
 #define BOUND_E 2097151L                   // E: 2^21 - 1 (signature bound)
 #define RING_SIZE 2                        // N: Z1-reduced from 3 to 2 members
 #define REJECT_M 20000                     // M: Rejection threshold for keygen
 #define REJECT_V 10000                     // V: Uniformity bound
+#define RING_A_SEED 0xDEADBEEFUL           // Key of the expander of the shared 'a'
 
 /* ========== LDPC PARAMETERS ========== */
 
@@ -86,13 +89,20 @@ typedef struct {
     int32_t coeff[POLY_DEGREE];
 } Poly512;
 
+/**
+ * Small-coefficient polynomial (|c| <= 128): secrets and errors, a
+ * quarter of a Poly512. Coefficients are plain integers, not reduced mod q.
+ */
+typedef struct {
+    int8_t coeff[POLY_DEGREE];
+} PolySmall;
+
 /**
  * Ring-LWE key pair
  */
 typedef struct {
-    Poly512 secret;      // Secret key sk
+    PolySmall secret;    // Secret key sk
     Poly512 public;      // Public key pk
-    Poly512 random;      // Random polynomial R
 } RingLWEKeyPair;
 
 /**
@@ -190,6 +200,17 @@ void poly_mod_q(Poly512 *result, const Poly512 *a);
  */
 void poly_add(Poly512 *result, const Poly512 *a, const Poly512 *b);
 
+/**
+ * result = a * s mod q (s small): each output coefficient accumulated
+ * in an int64 and reduced once
+ */
+void poly_mul_small(Poly512 *result, const Poly512 *a, const PolySmall *s);
+
+/**
+ * result = a + s mod q (s small)
+ */
+void poly_add_small(Poly512 *result, const Poly512 *a, const PolySmall *s);
+
 /**
  * Polynomial subtraction: result = a - b mod q
  */
@@ -210,6 +231,26 @@ uint32_t poly_norm(const Poly512 *a);
  */
 void poly_copy(Poly512 *dest, const Poly512 *src);
 
+/**
+ * Coefficient i of the shared ring element a, from a counter-mode
+ * expander keyed by RING_A_SEED: any coefficient, in any order, with no
+ * state
+ */
+int32_t ring_a_coeff(uint16_t i);
+
+/**
+ * result = a * b mod (x^n + 1), with a's coefficients drawn from
+ * ring_a_coeff() while the products accumulate. Neither a nor a 2n
+ * product buffer is held in RAM; a is regenerated n times instead.
+ */
+void poly_mul_a(Poly512 *result, const Poly512 *b);
+
+/**
+ * result = a * s mod (x^n + 1) for a small s (the secret key), a
+ * streamed as in poly_mul_a()
+ */
+void poly_mul_a_small(Poly512 *result, const PolySmall *s);
+
 /* ========== RANDOM NUMBER GENERATION ========== */
 
 /**